@@ -50,7 +50,7 @@ INCLUDEPATH += /usr/include/openblas
 LIBS += \
     -L$${PWD}/../build/libs -lkinccore \
     -lacecore \
-    -lgsl -lopenblas \
+    -lgsl -lopenblas -lz \
     -L$${CUDADIR}/lib64 -lcuda -lnvrtc -lcusolver -fopenmp \
     -lOpenCL -lmpi
 
@@ -6,6 +6,7 @@
 #include "exportparametermatrix.h"
 #include "conditionaltest.h"
 #include "similarity.h"
+#include "mergeshards.h"
 #include "corrpower.h"
 #include "powerlaw.h"
 #include "rmt.h"
@@ -46,6 +47,7 @@ QString AnalyticFactory::name(quint16 type) const
     case ExportCorrelationMatrixType: return "Export Correlation Matrix";
     case ExportParameterMatrixType: return "Export Parameter Matrix";
     case SimilarityType: return "Similarity";
+    case MergeShardsType: return "Merge Similarity Shards";
     case CorrelationPowerFilterType: return "Filter: Correlation Power";
     case ConditionalTestType: return "Threshold: Condition-Specific";
     case PowerLawType: return "Threshold: Power-law";
@@ -74,6 +76,7 @@ QString AnalyticFactory::commandName(quint16 type) const
     case ExportCorrelationMatrixType: return "export-cmx";
     case ExportParameterMatrixType: return "export-cpm";
     case SimilarityType: return "similarity";
+    case MergeShardsType: return "merge-shards";
     case CorrelationPowerFilterType: return "corrpower";
     case ConditionalTestType: return "cond-test";
     case PowerLawType: return "powerlaw";
@@ -102,6 +105,7 @@ std::unique_ptr<EAbstractAnalytic> AnalyticFactory::make(quint16 type) const
     case ExportCorrelationMatrixType: return unique_ptr<EAbstractAnalytic>(new ExportCorrelationMatrix);
     case ExportParameterMatrixType: return unique_ptr<EAbstractAnalytic>(new ExportParameterMatrix);
     case SimilarityType: return unique_ptr<EAbstractAnalytic>(new Similarity);
+    case MergeShardsType: return unique_ptr<EAbstractAnalytic>(new MergeShards);
     case CorrelationPowerFilterType: return unique_ptr<EAbstractAnalytic>(new CorrPowerFilter);
     case ConditionalTestType: return unique_ptr<EAbstractAnalytic>(new ConditionalTest);
     case PowerLawType: return unique_ptr<EAbstractAnalytic>(new PowerLaw);
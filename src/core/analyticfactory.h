@@ -23,6 +23,7 @@ public:
         ,ExportCorrelationMatrixType
         ,ExportParameterMatrixType
         ,SimilarityType
+        ,MergeShardsType
         ,CorrelationPowerFilterType
         ,ConditionalTestType
         ,PowerLawType
@@ -44,6 +44,7 @@ void CCMatrix::initialize(const EMetaArray& geneNames, int maxClusterSize, const
     EMetaObject metaObject {meta().toObject()};
     metaObject.insert("samples", sampleNames);
     setMeta(metaObject);
+    _sampleTable.reset();
 
     // save sample size and initialize base class
     _sampleSize = sampleNames.size();
@@ -61,3 +62,22 @@ EMetaArray CCMatrix::sampleNames() const
 
     return meta().toObject().at("samples").toArray();
 }
+
+
+
+/*!
+ * Return the table of sample names in this cluster matrix. The table is built
+ * from the metadata on the first call, which should not be made concurrently
+ * from several threads.
+ */
+const NameTable& CCMatrix::sampleTable() const
+{
+    EDEBUG_FUNC(this);
+
+    if ( !_sampleTable )
+    {
+        _sampleTable.reset(new NameTable(sampleNames()));
+    }
+
+    return *_sampleTable;
+}
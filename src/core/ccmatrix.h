@@ -20,6 +20,7 @@ public:
 public:
     void initialize(const EMetaArray& geneNames, int maxClusterSize, const EMetaArray& sampleNames);
     EMetaArray sampleNames() const;
+    const NameTable& sampleTable() const;
     /*!
      * Return the number of samples in the cluster matrix.
      */
@@ -48,6 +49,11 @@ private:
      * Pointer to a qt table model for this class.
      */
     Model* _model {nullptr};
+    /*!
+     * The cached table of sample names, which is built from the metadata when
+     * it is first requested.
+     */
+    mutable std::unique_ptr<NameTable> _sampleTable;
 };
 
 
@@ -12,7 +12,8 @@
 
 
 /*!
- * Supplies ACE with the number of work blocks it is going to create.
+ * Supplies ACE with the number of work blocks it is going to create. Each
+ * work block covers a fixed number of clusters of the cluster matrix.
  *
  * @return How many pieces you want to break up the task your working on.
  */
@@ -20,7 +21,7 @@ int ConditionalTest::size() const
 {
     EDEBUG_FUNC(this);
 
-    return (static_cast<qint64>(_ccm->size()) + _workBlockSize - 1) / _workBlockSize;
+    return (_ccm->clusterSize() + _workBlockSize - 1) / _workBlockSize;
 }
 
 
@@ -107,7 +108,11 @@ EAbstractAnalyticInput* ConditionalTest::makeInput()
 
 
 /*!
- * Creates a block of work at the given index.
+ * Creates a block of work at the given index. The block covers a range of
+ * cluster offsets in the cluster matrix, where both ends of the range are
+ * moved forward to the next pair boundary so that every pair is processed by
+ * exactly one block. Workers can then seek directly to the start of the
+ * range without depending on the blocks before it.
  *
  * @param index The index at which the work block should be made.
  *
@@ -122,10 +127,10 @@ std::unique_ptr<EAbstractAnalyticBlock> ConditionalTest::makeWork(int index) con
         ELog() << tr("Making work index %1 of %2.\n").arg(index).arg(size());
     }
 
-    qint64 start {index * static_cast<qint64>(_workBlockSize)};
-    qint64 size {std::min(_ccm->size() - start, static_cast<qint64>(_workBlockSize))};
+    qint64 start {_ccm->findPairStart(index * static_cast<qint64>(_workBlockSize))};
+    qint64 end {_ccm->findPairStart((index + 1) * static_cast<qint64>(_workBlockSize))};
 
-    return std::unique_ptr<EAbstractAnalyticBlock>(new WorkBlock(index, _index, start, size));
+    return std::unique_ptr<EAbstractAnalyticBlock>(new WorkBlock(index, start, end));
 }
 
 
@@ -180,11 +185,14 @@ void ConditionalTest::initialize()
 {
     EDEBUG_FUNC(this);
 
-    // only the master process needs to validate arguments
+    // only the master process needs to validate arguments, but every process
+    // needs the annotation data which is used by the tests
     auto& mpi {Ace::QMPI::instance()};
 
     if ( !mpi.isMaster() )
     {
+        initializeTests();
+        _numTests = countTests();
         return;
     }
 
@@ -229,6 +237,32 @@ void ConditionalTest::initialize()
         throw e;
     }
 
+    // read in the annotation matrix and prepare the test data
+    initializeTests();
+
+    // initialize work block size
+    if ( _workBlockSize == 0 )
+    {
+        int numWorkers = std::max(1, mpi.size() - 1);
+
+        _workBlockSize = std::max(1LL, std::min(32768LL, _ccm->clusterSize() / numWorkers));
+    }
+
+    // CSM specific
+    qint32 maxCluster = 64, subHeadersize = 12;
+    initialize(maxCluster,subHeadersize,_features,_testType,_data);
+}
+
+
+
+/*!
+ * Read in the annotation matrix and prepare the data which is used by the
+ * tests, which is needed by every process.
+ */
+void ConditionalTest::initializeTests()
+{
+    EDEBUG_FUNC(this);
+
     // open the stream to the coprrect file.
     _stream.setDevice(_amx);
 
@@ -257,18 +291,11 @@ void ConditionalTest::initialize()
     readInAMX(_features, _data, _testType);
 
     rearrangeSamples();
+    computeLabelMasks();
+    computeFeatureValues();
 
-    // initialize work block size
-    if ( _workBlockSize == 0 )
-    {
-        int numWorkers = std::max(1, mpi.size() - 1);
-
-        _workBlockSize = std::min(32768LL, _ccm->size() / numWorkers);
-    }
-
-    // CSM specific
-    qint32 maxCluster = 64, subHeadersize = 12;
-    initialize(maxCluster,subHeadersize,_features,_testType,_data);
+    // load the expression matrix into memory for the regression tests
+    _expressions = _emx->dumpRawData();
 }
 
 
@@ -699,8 +726,6 @@ void ConditionalTest::initialize(qint32 &maxClusterSize, qint32 &subHeaderSize,Q
 void ConditionalTest::rearrangeSamples()
 {
     int sampleIndex = 0;
-    int startIndex = 0;
-    QVariant temp;
 
     // find the sample index, if none is found with the name "samples" then
     // we default to using the first column.
@@ -723,41 +748,160 @@ void ConditionalTest::rearrangeSamples()
         throw e;
     }
 
-    // look through all the samples, if you find one that doesnt match
-    // switch it for the right sample.
-    for ( int i = 0; i < _emx->sampleSize(); i++ )
+    // find the position of each annotation sample in the emx using the
+    // sample name table, and move each sample to that position.
+    const NameTable& sampleNames = _emx->sampleTable();
+    QVector<QVector<QVariant>> data(_data.size(), QVector<QVariant>(_emx->sampleSize()));
+    QVector<bool> found(_emx->sampleSize(), false);
+
+    for ( int j = 0; j < _data.at(sampleIndex).size(); j++ )
     {
-        if ( _emx->sampleNames().at(i).toString() != _data.at(sampleIndex).at(i) )
+        int i = sampleNames.indexOf(_data.at(sampleIndex).at(j).toString());
+
+        if ( i == -1 )
         {
-            // find the right sample.
-            for ( int j = startIndex; j <  _data.at(sampleIndex).size(); j++ )
-            {
-                // switch the samples.
-                if ( _emx->sampleNames().at(i).toString() == _data.at(sampleIndex).at(j) )
-                {
-                    for ( int k = 0; k < _data.size(); k++ )
-                    {
-                        // move wrong sample to temp.
-                        temp = _data.at(k).at(i);
-                        // move right sample to the right place.
-                        _data[k][i] = _data.at(k).at(j);
-                        // replace the right sample with the wrong sample.
-                        _data[k][j] = temp;
-                    }
-                    break;
-                }
+            E_MAKE_EXCEPTION(e);
+            e.setTitle(tr("Sample Size Error"));
+            e.setDetails(tr("Sample not in emx."));
+            throw e;
+        }
+
+        if ( found.at(i) )
+        {
+            E_MAKE_EXCEPTION(e);
+            e.setTitle(tr("Sample Size Error"));
+            e.setDetails(tr("Sample appears more than once in annotation matrix."));
+            throw e;
+        }
+
+        found[i] = true;
+
+        for ( int k = 0; k < _data.size(); k++ )
+        {
+            data[k][i] = _data.at(k).at(j);
+        }
+    }
+
+    _data = data;
+}
+
+
+
+/*!
+ * Compute the set of samples which have each label of each categorical
+ * feature, so that the samples of a label in a cluster can be counted with
+ * bitwise operations instead of comparing labels for each cluster.
+ */
+void ConditionalTest::computeLabelMasks()
+{
+    EDEBUG_FUNC(this);
+
+    int numWords {(_emx->sampleSize() + 63) / 64};
 
-                if ( j == _emx->sampleSize() - 1 )
+    _labelMasks.clear();
+    _labelMasks.resize(_features.size());
+    _labelCounts.clear();
+    _labelCounts.resize(_features.size());
+
+    for ( int featureIndex = 0; featureIndex < _features.size(); featureIndex++ )
+    {
+        if ( _testType.at(featureIndex) != CATEGORICAL )
+        {
+            continue;
+        }
+
+        const QVector<QString>& labels = _features.at(featureIndex);
+
+        _labelMasks[featureIndex].fill(SampleMask(numWords, 0), labels.size());
+        _labelCounts[featureIndex].fill(0, labels.size());
+
+        // set the bit of each sample in the mask of its label
+        for ( int i = 0; i < _data.at(featureIndex).size(); i++ )
+        {
+            QString value {_data.at(featureIndex).at(i).toString()};
+
+            for ( int labelIndex = 0; labelIndex < labels.size(); labelIndex++ )
+            {
+                if ( value == labels.at(labelIndex) )
                 {
-                    E_MAKE_EXCEPTION(e);
-                    e.setTitle(tr("Sample Size Error"));
-                    e.setDetails(tr("Sample not in emx."));
-                    throw e;
+                    _labelMasks[featureIndex][labelIndex][i / 64] |= quint64(1) << (i % 64);
+                    _labelCounts[featureIndex][labelIndex]++;
                 }
             }
+        }
+    }
+}
+
+
+
+/*!
+ * Convert the annotations of each quantitative and ordinal feature to numbers
+ * once, so that the regression tests do not parse annotations for each
+ * cluster. Quantitative annotations are parsed as real numbers and ordinal
+ * annotations as integers.
+ */
+void ConditionalTest::computeFeatureValues()
+{
+    EDEBUG_FUNC(this);
+
+    _featureValues.clear();
+    _featureValues.resize(_features.size());
+
+    for ( int featureIndex = 0; featureIndex < _features.size(); featureIndex++ )
+    {
+        TESTTYPE testType {_testType.at(featureIndex)};
+
+        if ( testType != QUANTITATIVE && testType != ORDINAL )
+        {
+            continue;
+        }
+
+        std::vector<double>& values = _featureValues[featureIndex];
 
-            // increment the start nidex so you dont have to start at 0 every time.
-            startIndex++;
+        values.resize(_data.at(featureIndex).size());
+
+        for ( int i = 0; i < _data.at(featureIndex).size(); i++ )
+        {
+            QString value {_data.at(featureIndex).at(i).toString()};
+
+            values[i] = (testType == ORDINAL)
+                ? static_cast<double>(value.toInt())
+                : static_cast<double>(value.toFloat());
         }
     }
 }
+
+
+
+/*!
+ * Return the number of tests which are performed on each cluster, which is
+ * one test for each label of a categorical feature with labels and one test
+ * for every other categorical, ordinal or quantitative feature. This matches
+ * the number of tests which the output data object computes from the
+ * metadata on the master process.
+ */
+int ConditionalTest::countTests() const
+{
+    EDEBUG_FUNC(this);
+
+    int numTests {0};
+
+    for ( int i = 0; i < _features.size(); i++ )
+    {
+        if ( _testType.at(i) == NONE || _testType.at(i) == UNKNOWN )
+        {
+            continue;
+        }
+
+        if ( _testType.at(i) == CATEGORICAL && _features.at(i).size() > 1 )
+        {
+            numTests += _features.at(i).size() - 1;
+        }
+        else
+        {
+            numTests++;
+        }
+    }
+
+    return numTests;
+}
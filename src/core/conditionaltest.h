@@ -26,6 +26,12 @@ public:
         NONE
     };
 
+    /*!
+     * Defines a set of samples as a bitset with one bit per sample, stored in
+     * 64-bit words.
+     */
+    typedef std::vector<quint64> SampleMask;
+
     struct CSMPair
     {
         /*!
@@ -73,6 +79,10 @@ public:
     void initialize(qint32 &maxClusterSize, qint32 &subHeaderSize,QVector<QVector<QString>> &amxData, QVector<TESTTYPE> &testType, QVector<QVector<QVariant>> &data);
 
     void rearrangeSamples();
+    void computeLabelMasks();
+    void computeFeatureValues();
+    void initializeTests();
+    int countTests() const;
 
 private:
     /*!
@@ -114,7 +124,8 @@ private:
      */
     qint32 _amxNumLines {0};
     /*!
-     * The number of pairs to process in each work block.
+     * The number of clusters of the cluster matrix to process in each work
+     * block.
      */
     int _workBlockSize {0};
     /*!
@@ -127,6 +138,28 @@ private:
     qint32 _geneSize {0};
     qint32 _sampleSize {0};
     QString _delimiter = "tab";
+    /*!
+     * The set of samples which have each label of each categorical feature,
+     * indexed in the same way as the features. The lists of other features
+     * are empty.
+     */
+    QVector<QVector<SampleMask>> _labelMasks;
+    /*!
+     * The number of samples which have each label of each categorical
+     * feature.
+     */
+    QVector<QVector<qint32>> _labelCounts;
+    /*!
+     * The numeric value of each sample for each quantitative or ordinal
+     * feature, indexed in the same way as the features. The lists of other
+     * features are empty.
+     */
+    QVector<std::vector<double>> _featureValues;
+    /*!
+     * The expression matrix in row-major order, which is kept in memory so
+     * that the regression tests do not read gene rows from the file.
+     */
+    std::vector<float> _expressions;
     /*!
      * Current pairwise pair index
      */
@@ -27,7 +27,8 @@ private:
      */
     int _numTests{0};
     /*!
-     * The pairwise index of the first pair in the result block.
+     * The cluster offset in the cluster matrix of the first pair in the
+     * result block.
      */
     qint64 _start{0};
     /*!
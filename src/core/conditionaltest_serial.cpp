@@ -12,6 +12,8 @@
 #include <gsl/gsl_cdf.h>
 #include <gsl/gsl_multifit.h>
 #include <gsl/gsl_math.h>
+#include <algorithm>
+#include <cmath>
 
 
 
@@ -38,39 +40,17 @@ std::unique_ptr<EAbstractAnalyticBlock> ConditionalTest::Serial::execute(const E
 
     // crate the work and result blocks
     const WorkBlock* workBlock {block->cast<WorkBlock>()};
-    ResultBlock* resultBlock {new ResultBlock(workBlock->index(), _base->_numTests, workBlock->startpair())};
+    ResultBlock* resultBlock {new ResultBlock(workBlock->index(), _base->_numTests, workBlock->start())};
 
-    // Create iterators for the CCM data object.
+    // Create an iterator for the CCM data object which starts at the first
+    // pair of the work block.
     CCMatrix::Pair ccmPair = CCMatrix::Pair(_base->_ccm);
-    CorrelationMatrix::Pair cmxPair = CorrelationMatrix::Pair(_base->_cmx);
+    ccmPair.seek(workBlock->start());
 
-    // Iterate through the pairs the workblock is assigned to.
-    qint64 start = workBlock->startpair();
-    qint64 size = workBlock->size();
-    Pairwise::Index index(workBlock->start());
-
-    // iterate through each pair in the matrix
-    for ( qint64 ccmIndex = start; ccmIndex < start + size; ccmIndex++ )
+    // iterate through each pair in the range of the work block
+    while ( ccmPair.offset() < workBlock->end() )
     {
-        // reads the first value in the ccm
-        if ( ccmIndex == start )
-        {
-            ccmPair.read(index);
-            cmxPair.read(ccmPair.index());
-        }
-
-        if ( (ccmPair.index().getX() != 1 && ccmPair.index().getY()!= 0) || ccmIndex != start )
-        {
-            ccmPair.readNext();
-            cmxPair.read(ccmPair.index());
-        }
-
-        // if the first one isnt in the cluster we should not count it.
-        if ( ccmPair.clusterSize() == 0 )
-        {
-            size++;
-            continue;
-        }
+        ccmPair.readNext();
 
         // Initialize new pvalues, one set of pvalues for each cluster.
         QVector<QVector<double>> pValues;
@@ -87,6 +67,11 @@ std::unique_ptr<EAbstractAnalyticBlock> ConditionalTest::Serial::execute(const E
             pValues[clusterIndex].resize(_base->_numTests);
             r2[clusterIndex].resize(_base->_numTests);
 
+            // get the set of samples in the cluster and run the regression
+            // tests of all quantitative and ordinal features on it
+            computeClusterMask(ccmPair, clusterIndex);
+            computeRegressions(ccmPair.index());
+
             for ( qint32 featureIndex = 0, testIndex = 0; featureIndex < _base->_features.size(); featureIndex++ )
             {
                 if ( _base->_testType.at(featureIndex) == NONE || _base->_testType.at(featureIndex) == UNKNOWN )
@@ -96,15 +81,12 @@ std::unique_ptr<EAbstractAnalyticBlock> ConditionalTest::Serial::execute(const E
 
                 if ( _base->_testType.at(featureIndex) == QUANTITATIVE || _base->_testType.at(featureIndex) == ORDINAL )
                 {
-                    prepAnxData(_base->_features.at(featureIndex).at(0), featureIndex, _base->_testType.at(featureIndex));
                     test(ccmPair, clusterIndex, testIndex, featureIndex, 0, pValues, r2);
                 }
                 else if ( _base->_testType.at(featureIndex) == CATEGORICAL )
                 {
                     for ( qint32 labelIndex = 0; labelIndex < _base->_features.at(featureIndex).size(); labelIndex++ )
                     {
-                        prepAnxData(_base->_features.at(featureIndex).at(labelIndex), featureIndex, _base->_testType.at(featureIndex));
-
                         // if there are sub labels to test for the feature
                         if ( _base->_features.at(featureIndex).size() > 1 )
                         {
@@ -141,98 +123,95 @@ std::unique_ptr<EAbstractAnalyticBlock> ConditionalTest::Serial::execute(const E
 
 
 /*!
- * Prepare the annotation matrix data for testing.
- *
- * @param testLabel The label you are testing on.
+ * Check to see if a matrix is empty.
  *
- * @param dataIndex The feature the label is part of.
+ * @param vector The matrix you want to check.
  *
- * @return The number of samples in total of the test label.
+ * @return True if the matrix is empty, false otherwise.
  */
-int ConditionalTest::Serial::prepAnxData(QString testLabel, int dataIndex, TESTTYPE testType)
+bool ConditionalTest::Serial::isEmpty(QVector<QVector<double>>& matrix)
 {
-    EDEBUG_FUNC(this, testLabel, dataIndex);
+    EDEBUG_FUNC(this, &matrix);
 
-    // get the needed data fro the comparison
-    _catCount = 0;
-    _amxData.resize(_base->_data.at(dataIndex).size());
+    int index = 0;
 
-    // populate array with annotation data
-    for ( int j = 0; j < _base->_data.at(dataIndex).size(); j++ )
+    while ( index < matrix.size() )
     {
-        _amxData[j] = _base->_data.at(dataIndex).at(j).toString();
-
-        // if data is the same as the test label add one to the catagory counter
-        if ( testType == _base->CATEGORICAL && _amxData[j] == testLabel )
+        if ( !matrix.at(index++).isEmpty() )
         {
-            _catCount++;
+            return false;
         }
     }
 
-    return _catCount;
+    return true;
 }
 
 
 
 /*!
- * Check to see if a matrix is empty.
+ * Compute the set of samples in the given cluster of a pair and the size of
+ * the cluster.
  *
- * @param vector The matrix you want to check.
+ * @param ccmPair The gene pair that contains the cluster.
  *
- * @return True if the matrix is empty, false otherwise.
+ * @param clusterIndex The number cluster we are in in the pair
  */
-bool ConditionalTest::Serial::isEmpty(QVector<QVector<double>>& matrix)
+void ConditionalTest::Serial::computeClusterMask(CCMatrix::Pair& ccmPair, int clusterIndex)
 {
-    EDEBUG_FUNC(this, &matrix);
+    EDEBUG_FUNC(this, &ccmPair, clusterIndex);
 
-    int index = 0;
+    int sampleSize {_base->_emx->sampleSize()};
 
-    while ( index < matrix.size() )
+    _clusterMask.assign((sampleSize + 63) / 64, 0);
+    _clusterSize = 0;
+
+    for ( qint32 i = 0; i < sampleSize; i++ )
     {
-        if ( !matrix.at(index++).isEmpty() )
+        if ( ccmPair.at(clusterIndex, i) == 1 )
         {
-            return false;
+            _clusterMask[i / 64] |= quint64(1) << (i % 64);
+            _clusterSize++;
         }
     }
-
-    return true;
 }
 
 
 
 /*!
- * Prepare the cluster category count information.
+ * Prepare the cluster category count information. The counts are computed
+ * from the set of samples in the current cluster and the precomputed set of
+ * samples with the given label.
  *
- * @param ccmPair The gene pair that we are counting the labels for.
+ * @param featureIndex The feature the label is part of.
  *
- * @param clusterIndex The number cluster we are in in the pair
+ * @param labelIndex The label in the feature.
  *
  * @return The number of labels in the given cluster.
  */
-int ConditionalTest::Serial::clusterInfo(CCMatrix::Pair& ccmPair, int clusterIndex, QString label, TESTTYPE testType)
+int ConditionalTest::Serial::clusterInfo(qint32 featureIndex, qint32 labelIndex, TESTTYPE testType)
 {
-    _catCount = _clusterSize = _catInCluster = 0;
+    EDEBUG_FUNC(this, featureIndex, labelIndex, testType);
 
-    // Look through all the samples in the mask.
-    for ( qint32 i = 0; i < _base->_emx->sampleSize(); i++ )
+    _catCount = _catInCluster = 0;
+
+    if ( testType != CATEGORICAL )
     {
-        // If the sample label matches with the given label.
-        if ( testType == _base->CATEGORICAL && _amxData.at(i) == label )
-        {
-            _catCount++;
-        }
+        return _catInCluster;
+    }
 
-        if ( ccmPair.at(clusterIndex, i) == 1 )
-        {
-            _clusterSize++;
+    // intersect the cluster with the samples of the label
+    const SampleMask& labelMask = _base->_labelMasks.at(featureIndex).at(labelIndex);
 
-            if ( testType == _base->CATEGORICAL && _amxData.at(i) == label )
-            {
-                _catInCluster++;
-            }
-        }
+    _labelClusterMask.resize(_clusterMask.size());
+
+    for ( size_t w = 0; w < _clusterMask.size(); w++ )
+    {
+        _labelClusterMask[w] = _clusterMask[w] & labelMask[w];
+        _catInCluster += qPopulationCount(_labelClusterMask[w]);
     }
 
+    _catCount = _base->_labelCounts.at(featureIndex).at(labelIndex);
+
     return _catInCluster;
 }
 
@@ -269,31 +248,20 @@ int ConditionalTest::Serial::test(
     EDEBUG_FUNC(this,&ccmPair, clusterIndex, &testIndex, featureIndex, labelIndex, &pValues);
 
     // get informatiopn on the mask
-    clusterInfo(ccmPair, clusterIndex, _base->_features.at(featureIndex).at(labelIndex), _base->_testType.at(featureIndex));
-
-    // For linear regresssion we need a variable that will hold the
-    // pvalue and the r2 value.
-    QVector<double> results(2);
+    clusterInfo(featureIndex, labelIndex, _base->_testType.at(featureIndex));
 
     // conduct the correct test based on the type of data
     switch(_base->_testType.at(featureIndex))
     {
         case CATEGORICAL:
-            pValues[clusterIndex][testIndex] = hypergeom(ccmPair, clusterIndex,
-                                                         _base->_features.at(featureIndex).at(labelIndex));
+            pValues[clusterIndex][testIndex] = hypergeom(ccmPair.index(), clusterIndex, testIndex);
             r2[clusterIndex][testIndex] = qQNaN();
             testIndex++;
             break;
         case ORDINAL:
-            regression(_amxData, ccmPair, clusterIndex, ORDINAL, results);
-            pValues[clusterIndex][testIndex] = results.at(0);
-            r2[clusterIndex][testIndex] = results.at(1);
-            testIndex++;
-            break;
         case QUANTITATIVE:
-            regression(_amxData, ccmPair, clusterIndex, QUANTITATIVE, results);
-            pValues[clusterIndex][testIndex] = results.at(0);
-            r2[clusterIndex][testIndex] = results.at(1);
+            pValues[clusterIndex][testIndex] = _regressionPValues.at(featureIndex);
+            r2[clusterIndex][testIndex] = _regressionR2.at(featureIndex);
             testIndex++;
             break;
         default:
@@ -306,13 +274,21 @@ int ConditionalTest::Serial::test(
 
 
 /*!
- * Run the first binomial test for given data.
+ * Run the first binomial test for given data. The random samples of the
+ * jackknife resampling are determined only by the pair, cluster and test, so
+ * the result does not depend on how pairs are distributed among workers.
+ *
+ * @param index The index of the pair which is tested.
+ *
+ * @param clusterIndex The cluster of the pair which is tested.
+ *
+ * @param testIndex The test which is performed.
  *
  * @return Pvalue corrosponding to the test.
  */
-double ConditionalTest::Serial::hypergeom(CCMatrix::Pair& ccmPair, int clusterIndex, QString test_label)
+double ConditionalTest::Serial::hypergeom(const Pairwise::Index& index, qint32 clusterIndex, qint32 testIndex)
 {
-    EDEBUG_FUNC(this);
+    EDEBUG_FUNC(this, &index, clusterIndex, testIndex);
 
     // We use the hypergeometric distribution because the samples are
     // selected from the population for membership in the cluster without
@@ -350,60 +326,67 @@ double ConditionalTest::Serial::hypergeom(CCMatrix::Pair& ccmPair, int clusterIn
     // 0.001 and a power of 0.95 we need at least 31 samples.
     // So, we'll perform a jacknife resampling of our data
     // to calculate an average proportion of 31 samples
-    if ( t > 31 )
+    if ( t > JACKKNIFE_SIZE )
     {
-        // Initialize the uniform random number generator.
-        const gsl_rng_type * T;
-        gsl_rng * r;
-        gsl_rng_env_setup();
-        T = gsl_rng_default;
-        r = gsl_rng_alloc (T);
+        // Initialize the random number key from the pair, cluster and test.
+        quint64 key {random(static_cast<quint64>(index.getX()) << 32 | static_cast<quint32>(index.getY()), static_cast<quint64>(clusterIndex) << 32 | static_cast<quint32>(testIndex))};
+
+        // Initialize the sample permutation to the identity.
+        if ( _sampleOrder.size() != static_cast<size_t>(sampleSize) )
+        {
+            _sampleOrder.resize(sampleSize);
+
+            for ( int j = 0; j < sampleSize; j++ )
+            {
+                _sampleOrder[j] = j;
+            }
+        }
 
         // Holds the jacknife average proportion.
         int jkap = 0;
 
         // To perform the Jacknife resampling we will
         // perform 30 iterations (central limit thereom)
-        int in = 30;
+        int in = JACKKNIFE_ITERATIONS;
         for ( int i = 0; i < in; i++ )
         {
             // Keeps track of the number of successes for each iteration.
             int ns = 0;
 
-            // Generate 31 random indexes between 0 and the size of
-            // the sample string.  We will use these numbers to
-            // randomly select a sample and if it is a 1 and of the
-            // testing category then we consider it a success.
-            int indexes[sampleSize];
-            int chosen[31];
+            // Choose 31 random samples without replacement using a partial
+            // Fisher-Yates shuffle of the sample permutation. If a chosen
+            // sample is in the cluster and of the testing category then we
+            // consider it a success.
+            int swaps[JACKKNIFE_SIZE];
 
-            for ( int j = 0; j < sampleSize; j++ )
+            for ( int j = 0; j < JACKKNIFE_SIZE; j++ )
             {
-                indexes[j] = j;
-            }
+                quint64 r {random(key, static_cast<quint64>(i) * JACKKNIFE_SIZE + j)};
+                int s {j + static_cast<int>(((r >> 32) * static_cast<quint64>(sampleSize - j)) >> 32)};
 
-            // The gsl_ran_choose function randmly choose samples without replacement from a list.
-            gsl_ran_choose(r, chosen, 31, indexes, sampleSize, sizeof(int));
+                std::swap(_sampleOrder[j], _sampleOrder[s]);
+                swaps[j] = s;
 
-            for ( int j = 0; j < 31; j++ )
+                int chosen {_sampleOrder[j]};
+
+                ns += (_labelClusterMask[chosen / 64] >> (chosen % 64)) & 1;
+            }
+
+            // Undo the swaps in reverse order to restore the identity.
+            for ( int j = JACKKNIFE_SIZE - 1; j >= 0; j-- )
             {
-                if ( ccmPair.at(clusterIndex, chosen[j]) == 1 && _amxData.at(chosen[j]) == test_label )
-                {
-                    ns = ns + 1;
-                }
+                std::swap(_sampleOrder[j], _sampleOrder[swaps[j]]);
             }
 
             jkap += ns;
         }
 
-        // Calculate the average proportion from all iterations
-        // and free the random number struct.
+        // Calculate the average proportion from all iterations.
         jkap = jkap/in;
-        gsl_rng_free(r);
 
         // Now reset the sample size and the proporiton of success.
         k = jkap;
-        t = 31;
+        t = JACKKNIFE_SIZE;
     }
 
     // The gsl_cdf_hypergeometric_Q function uses the upper-tail of the CDF.
@@ -414,115 +397,253 @@ double ConditionalTest::Serial::hypergeom(CCMatrix::Pair& ccmPair, int clusterIn
 
 
 /*!
- * Run the regression test for given data, the regression line is genex vs geney vs label data.
- *
- * @param amxInfo Annotation matrix information.
+ * Return a random number which is determined only by the given key and
+ * counter. This is a counter-based generator which applies the SplitMix64
+ * finalizer to the key and counter, so it requires no state or allocation
+ * and any random number of a sequence can be generated independently.
  *
- * @param ccmPair Cluster matrix pair.
+ * @param key
+ * @param counter
+ */
+quint64 ConditionalTest::Serial::random(quint64 key, quint64 counter)
+{
+    quint64 z {key + (counter + 1) * 0x9e3779b97f4a7c15ULL};
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+    return z ^ (z >> 31);
+}
+
+
+
+/*!
+ * Run the regression tests of all quantitative and ordinal features on the
+ * current cluster of the given pair, the regression line is genex vs geney
+ * vs label data. The design matrix [1, gene x, gene y, gene x * gene y] is
+ * the same for every feature, so the normal equations are formed and
+ * factored once per cluster and then solved for the response of each
+ * feature. If the normal equations are not positive definite, each feature
+ * is instead fitted with the least-squares solver of GSL.
  *
- * @param clusterIndex The index of the cluster, used to get the right info
- *       from the cluster pair
+ * @param index The index of the pair which is tested.
+ */
+void ConditionalTest::Serial::computeRegressions(const Pairwise::Index& index)
+{
+    EDEBUG_FUNC(this, &index);
+
+    int numFeatures {_base->_features.size()};
+
+    _regressionPValues.fill(qQNaN(), numFeatures);
+    _regressionR2.fill(qQNaN(), numFeatures);
+
+    // skip the design matrix if there are no features to test
+    bool hasRegressions {false};
+
+    for ( int featureIndex = 0; featureIndex < numFeatures; featureIndex++ )
+    {
+        TESTTYPE testType {_base->_testType.at(featureIndex)};
+
+        hasRegressions |= (testType == QUANTITATIVE || testType == ORDINAL);
+    }
+
+    if ( !hasRegressions )
+    {
+        return;
+    }
+
+    // Get the gene pairs expression information from the expression cache.
+    int sampleSize {_base->_emx->sampleSize()};
+    const float* geneX {&_base->_expressions[static_cast<size_t>(index.getX()) * sampleSize]};
+    const float* geneY {&_base->_expressions[static_cast<size_t>(index.getY()) * sampleSize]};
+
+    // Compute the mean expression of each gene in the cluster.
+    double mean1 {0};
+    double mean2 {0};
+
+    for ( int i = 0; i < sampleSize; i++ )
+    {
+        if ( (_clusterMask[i / 64] >> (i % 64)) & 1 )
+        {
+            mean1 += geneX[i];
+            mean2 += geneY[i];
+        }
+    }
+
+    mean1 /= _clusterSize;
+    mean2 /= _clusterSize;
+
+    // Build the design matrix from the samples in the cluster. We add a 1 for
+    // the intercept, gene1, gene2 and the interaction: gene1*gene2. The
+    // interaction term handles the case where the relationship is dependent
+    // on the values of both genes. Both genes are centred, which spans the
+    // same model but keeps the normal equations well conditioned.
+    _design.resize(static_cast<size_t>(_clusterSize) * 4);
+
+    for ( int i = 0, j = 0; i < sampleSize; i++ )
+    {
+        if ( (_clusterMask[i / 64] >> (i % 64)) & 1 )
+        {
+            double g1 = static_cast<double>(geneX[i]) - mean1;
+            double g2 = static_cast<double>(geneY[i]) - mean2;
+
+            _design[j * 4 + 0] = 1;
+            _design[j * 4 + 1] = g1;
+            _design[j * 4 + 2] = g2;
+            _design[j * 4 + 3] = g1 * g2;
+            j++;
+        }
+    }
+
+    // Form the lower triangle of the normal equations X^T X and factor it.
+    double L[4][4] {};
+
+    for ( int j = 0; j < _clusterSize; j++ )
+    {
+        const double* x {&_design[j * 4]};
+
+        for ( int a = 0; a < 4; a++ )
+        {
+            for ( int b = 0; b <= a; b++ )
+            {
+                L[a][b] += x[a] * x[b];
+            }
+        }
+    }
+
+    bool factored {choleskyDecompose(L)};
+
+    // Solve the normal equations for the response of each feature.
+    for ( int featureIndex = 0; featureIndex < numFeatures; featureIndex++ )
+    {
+        TESTTYPE testType {_base->_testType.at(featureIndex)};
+
+        if ( testType != QUANTITATIVE && testType != ORDINAL )
+        {
+            continue;
+        }
+
+        computeResponses(featureIndex);
+
+        double* pValue {&_regressionPValues[featureIndex]};
+        double* r2 {&_regressionR2[featureIndex]};
+
+        if ( !factored )
+        {
+            regressionSVD(pValue, r2);
+            continue;
+        }
+
+        // Compute X^T Y and solve for the coefficients C.
+        double b[4] {};
+
+        for ( int j = 0; j < _clusterSize; j++ )
+        {
+            const double* x {&_design[j * 4]};
+            double y {_responses[j]};
+
+            b[0] += x[0] * y;
+            b[1] += x[1] * y;
+            b[2] += x[2] * y;
+            b[3] += x[3] * y;
+        }
+
+        choleskySolve(L, b);
+
+        // Compute the residual sum of squares directly from the residuals,
+        // and the total sum of squares in two passes as GSL does.
+        double chisq {0};
+
+        for ( int j = 0; j < _clusterSize; j++ )
+        {
+            const double* x {&_design[j * 4]};
+            double residual {_responses[j] - (x[0] * b[0] + x[1] * b[1] + x[2] * b[2] + x[3] * b[3])};
+
+            chisq += residual * residual;
+        }
+
+        double tss {gsl_stats_tss(_responses.data(), 1, _clusterSize)};
+
+        regression(chisq, tss, pValue, r2);
+    }
+}
+
+
+
+/*!
+ * Fill the response vector of the regression tests with the value of each
+ * sample in the cluster for the given feature. Ordinal values are converted
+ * into a "design vector", with each unique value assigned a unique integer
+ * in the order in which it appears in the cluster.
  *
- * @return Pvalue corrosponding to the test.
+ * @param featureIndex The feature whose values are used.
  */
-void ConditionalTest::Serial::regression(QVector<QString> &amxInfo, CCMatrix::Pair& ccmPair, int clusterIndex, TESTTYPE testType, QVector<double>& results)
+void ConditionalTest::Serial::computeResponses(qint32 featureIndex)
 {
-    EDEBUG_FUNC(this, &amxInfo, &ccmPair, clusterIndex);
+    EDEBUG_FUNC(this, featureIndex);
 
-    // Temp containers.
+    const std::vector<double>& values = _base->_featureValues.at(featureIndex);
+    bool ordinal {_base->_testType.at(featureIndex) == ORDINAL};
     QVector<double> labelInfo;
 
-    // Regression model containers.
-    double chisq;
-    gsl_matrix *X, *cov;
-    gsl_vector *Y, *C;
-    double pValue = 0.0;
-    double r2 = 0.0;
-
-    // Allocate a matrix to hold the predictior variables, in this case the gene
-    // Expression data.
-    X = gsl_matrix_alloc(_clusterSize, 4);
-
-    // Allocate a vector to hold observation data, in this case the data
-    // corrosponding to the features.
-    Y = gsl_vector_alloc(_clusterSize);
-
-    // Allocate a vector and matrix for the slope info.
-    C = gsl_vector_alloc(4);
-    cov = gsl_matrix_alloc(4, 4);
-
-    // Read in the gene pairs expression information.
-    ExpressionMatrix::Gene geneX(_base->_emx);
-    ExpressionMatrix::Gene geneY(_base->_emx);
-    geneX.read(ccmPair.index().getX());
-    geneY.read(ccmPair.index().getY());
-
-    // Look through all the samples in the mask.
+    _responses.resize(_clusterSize);
+
     for ( int i = 0, j = 0; i < _base->_emx->sampleSize(); i++ )
     {
-        // If the sample label matches with the given label.
-        if ( ccmPair.at(clusterIndex, i) == 1 )
+        if ( (_clusterMask[i / 64] >> (i % 64)) & 1 )
         {
-            // Add emx data as the predictors but only for samples in the cluster. We
-            // add a 1 for the intercept, gene1, gene2 and the interaction: gene1*gene2.
-            // The interaction term handles the case where the relationship is dependent
-            // on the values of both genes.
-            double g1 = static_cast<double>(geneX.at(i));
-            double g2 = static_cast<double>(geneY.at(i));
-
-            gsl_matrix_set(X, j, 0, static_cast<double>(1)); // for the intercept
-            gsl_matrix_set(X, j, 1, g1);
-            gsl_matrix_set(X, j, 2, g2);
-            gsl_matrix_set(X, j, 3, g1*g2);
-
-            // Next add the annotation observation for this sample to the Y vector.
-            if ( testType == ORDINAL )
+            double value {values[i]};
+
+            if ( ordinal )
             {
-                // Convert the observation data into a "design vector"
-                // Each unique number being a ssigned a unique integer.
-                if ( !labelInfo.contains(amxInfo.at(i).toInt()) )
-                {
-                    labelInfo.append(amxInfo.at(i).toInt());
-                }
+                int k = labelInfo.indexOf(value);
 
-                for ( int k = 0; k < labelInfo.size(); k++ )
+                if ( k == -1 )
                 {
-                    if ( labelInfo.at(k) == amxInfo.at(i).toInt() )
-                    {
-                        gsl_vector_set(Y, j, k + 1);
-                    }
+                    k = labelInfo.size();
+                    labelInfo.append(value);
                 }
-            }
-            else
-            {
-                gsl_vector_set(Y, j, amxInfo.at(i).toFloat());
+
+                value = k + 1;
             }
 
+            _responses[j] = value;
             j++;
         }
     }
+}
 
-    // Create the workspace for the gnu scientific library to work in.
-    gsl_multifit_linear_workspace * work = gsl_multifit_linear_alloc (X->size1, X->size2);
 
-    // Regrassion calculation.
-    gsl_multifit_linear(X, Y, C, cov, &chisq, work);
+
+/*!
+ * Compute the p-value and r-squared value of a regression test from the
+ * residual and total sum of squares.
+ *
+ * @param chisq The residual sum of squares.
+ *
+ * @param tss The total sum of squares.
+ *
+ * @param pValue The p-value of the test.
+ *
+ * @param r2 The r-squared value of the test.
+ */
+void ConditionalTest::Serial::regression(double chisq, double tss, double* pValue, double* r2)
+{
+    EDEBUG_FUNC(this, chisq, tss, pValue, r2);
 
     // Calculate R^2 and p-value
-    r2 = 1 - chisq / gsl_stats_tss(Y->data, Y->stride, Y->size);
+    double rsquare = 1 - chisq / tss;
 
     double dl = _clusterSize - 2;
-    double F = r2 * dl / (1 - r2);
+    double F = rsquare * dl / (1 - rsquare);
 
-    pValue = 1 - gsl_cdf_fdist_P (F, 1, dl);
+    double p = 1 - gsl_cdf_fdist_P (F, 1, dl);
 
     // TODO: we should check the assumptions of the linear regression and
     // not return if the assumptions are not met.
 
     // TODO: it would be nice to return a rate of change of the conditioal mean.
 
-    // TODO: it would be nice to return the r2 value along with the p-value.
-
     // Four scenarios:
     // 1) low R-square and low p-value (p-value <= 0.05).  Model doesn't explain
     //    the variation but it does follow the trend or regression line well.
@@ -535,21 +656,131 @@ void ConditionalTest::Serial::regression(QVector<QString> &amxInfo, CCMatrix::Pa
     // In summary, low p-values still indicate a real relationship between the
     // predictors and the observed values.
 
+    // Set the results
+    if ( qIsNaN(p) )
+    {
+        *pValue = 1;
+        *r2 = 0;
+    }
+    else
+    {
+        *pValue = p;
+        *r2 = rsquare;
+    }
+}
+
+
+
+/*!
+ * Run the regression test of the current response vector with the
+ * least-squares solver of GSL, which is used when the normal equations of the
+ * cluster are not positive definite.
+ *
+ * @param pValue The p-value of the test.
+ *
+ * @param r2 The r-squared value of the test.
+ */
+void ConditionalTest::Serial::regressionSVD(double* pValue, double* r2)
+{
+    EDEBUG_FUNC(this, pValue, r2);
+
+    // Regression model containers, where the design matrix and the
+    // observation vector refer directly to the cluster data.
+    double chisq;
+    gsl_matrix_view X {gsl_matrix_view_array(_design.data(), _clusterSize, 4)};
+    gsl_vector_view Y {gsl_vector_view_array(_responses.data(), _clusterSize)};
+    gsl_vector* C {gsl_vector_alloc(4)};
+    gsl_matrix* cov {gsl_matrix_alloc(4, 4)};
+
+    // Create the workspace for the gnu scientific library to work in.
+    gsl_multifit_linear_workspace * work = gsl_multifit_linear_alloc(_clusterSize, 4);
+
+    // Regrassion calculation.
+    gsl_multifit_linear(&X.matrix, &Y.vector, C, cov, &chisq, work);
+
+    regression(chisq, gsl_stats_tss(_responses.data(), 1, _clusterSize), pValue, r2);
+
     // Free all of the data.
-    gsl_matrix_free(X);
-    gsl_vector_free(Y);
     gsl_matrix_free(cov);
     gsl_vector_free(C);
     gsl_multifit_linear_free(work);
+}
+
+
+
+/*!
+ * Compute the Cholesky factor of a symmetric 4x4 matrix in place. Only the
+ * lower triangle of the matrix is used. Return false if the matrix is not
+ * numerically positive definite, which is the case if any pivot loses more
+ * than eight digits relative to the diagonal element, so that nearly
+ * singular clusters are fitted with the least-squares solver of GSL.
+ *
+ * @param L The matrix, which is replaced by its lower-triangular factor.
+ */
+bool ConditionalTest::Serial::choleskyDecompose(double L[4][4])
+{
+    for ( int j = 0; j < 4; j++ )
+    {
+        double diagonal {L[j][j]};
+
+        for ( int k = 0; k < j; k++ )
+        {
+            diagonal -= L[j][k] * L[j][k];
+        }
+
+        if ( !(diagonal > 1e-8 * L[j][j]) )
+        {
+            return false;
+        }
+
+        L[j][j] = std::sqrt(diagonal);
+
+        for ( int i = j + 1; i < 4; i++ )
+        {
+            double value {L[i][j]};
+
+            for ( int k = 0; k < j; k++ )
+            {
+                value -= L[i][k] * L[j][k];
+            }
+
+            L[i][j] = value / L[j][j];
+        }
+    }
+
+    return true;
+}
 
-    // Set the results array
-    if ( qIsNaN(pValue) )
+
+
+/*!
+ * Solve the linear system L L^T x = b in place, given the Cholesky factor L.
+ *
+ * @param L The lower-triangular Cholesky factor.
+ *
+ * @param b The right-hand side, which is replaced by the solution.
+ */
+void ConditionalTest::Serial::choleskySolve(const double L[4][4], double b[4])
+{
+    // solve L y = b
+    for ( int i = 0; i < 4; i++ )
     {
-        results[0] = 1;
-        results[1] = 0;
+        for ( int k = 0; k < i; k++ )
+        {
+            b[i] -= L[i][k] * b[k];
+        }
+
+        b[i] /= L[i][i];
     }
-    else {
-        results[0] = pValue;
-        results[1] = r2;
+
+    // solve L^T x = y
+    for ( int i = 3; i >= 0; i-- )
+    {
+        for ( int k = i + 1; k < 4; k++ )
+        {
+            b[i] -= L[k][i] * b[k];
+        }
+
+        b[i] /= L[i][i];
     }
 }
@@ -2,7 +2,6 @@
 #define ConditionalTest_SERIAL_H
 #include <ace/core/core.h>
 #include <gsl/gsl_matrix.h>
-#include <gsl/gsl_rng.h>
 #include <gsl/gsl_statistics_double.h>
 #include <gsl/gsl_randist.h>
 #include "conditionaltest.h"
@@ -18,9 +17,9 @@ public:
 
     // helper functions
     int test(CCMatrix::Pair& ccmPair, qint32 clusterIndex, qint32& testIndex, qint32 featureIndex, qint32 labelIndex, QVector<QVector<double>>& pValues, QVector<QVector<double>>& r2);
-    int prepAnxData(QString testLabel, int dataIndex, TESTTYPE testType);
     bool isEmpty(QVector<QVector<double>>& matrix);
-    int clusterInfo(CCMatrix::Pair& ccmPair, int clusterIndex, QString label, TESTTYPE testType);
+    void computeClusterMask(CCMatrix::Pair& ccmPair, int clusterIndex);
+    int clusterInfo(qint32 featureIndex, qint32 labelIndex, TESTTYPE testType);
 
     // Binomial Tests
     double binomial();
@@ -28,21 +27,32 @@ public:
     double testTwo();
 
     // Hypergeometrix Test.
-    double hypergeom(CCMatrix::Pair& ccmPair, int clusterIndex, QString test_label);
+    double hypergeom(const Pairwise::Index& index, qint32 clusterIndex, qint32 testIndex);
+    static quint64 random(quint64 key, quint64 counter);
 
     // Regression Test
-    void regression(QVector<QString> &amxInfo, CCMatrix::Pair& ccmPair, int clusterIndex, TESTTYPE testType, QVector<double>& results);
+    void computeRegressions(const Pairwise::Index& index);
+    void computeResponses(qint32 featureIndex);
+    void regression(double chisq, double tss, double* pValue, double* r2);
+    void regressionSVD(double* pValue, double* r2);
+    static bool choleskyDecompose(double L[4][4]);
+    static void choleskySolve(const double L[4][4], double b[4]);
     double fTest(double chisq, gsl_matrix* X, gsl_vector* Y, gsl_matrix* cov, gsl_vector* C);
 
 private:
     /*!
-     * Pointer to the serials objects parent KNNAnalytic.
+     * The number of samples which are chosen in each iteration of the
+     * jackknife resampling.
      */
-    ConditionalTest* _base;
+    constexpr static int JACKKNIFE_SIZE {31};
     /*!
-     * Annotation matrix data for testing.
+     * The number of iterations of the jackknife resampling.
+     */
+    constexpr static int JACKKNIFE_ITERATIONS {30};
+    /*!
+     * Pointer to the serials objects parent KNNAnalytic.
      */
-    QVector<QString> _amxData;
+    ConditionalTest* _base;
     /*!
      * Category count.
      */
@@ -55,6 +65,41 @@ private:
      * Size of the cluster.
      */
     qint32 _clusterSize {0};
+    /*!
+     * The set of samples in the cluster.
+     */
+    SampleMask _clusterMask;
+    /*!
+     * The set of samples in the cluster which have the test label.
+     */
+    SampleMask _labelClusterMask;
+    /*!
+     * Persistent permutation of the sample indices which is used to choose
+     * samples without replacement during jackknife resampling. Every
+     * resampling iteration restores the identity permutation.
+     */
+    std::vector<int> _sampleOrder;
+    /*!
+     * The design matrix of the regression tests in row-major order, which
+     * contains the intercept, gene x, gene y and their interaction for each
+     * sample in the cluster.
+     */
+    std::vector<double> _design;
+    /*!
+     * The response vector of the regression tests, which contains the
+     * feature value of each sample in the cluster.
+     */
+    std::vector<double> _responses;
+    /*!
+     * The regression p-value of each quantitative or ordinal feature for the
+     * current cluster.
+     */
+    QVector<double> _regressionPValues;
+    /*!
+     * The regression r-squared value of each quantitative or ordinal feature
+     * for the current cluster.
+     */
+    QVector<double> _regressionR2;
 };
 
 
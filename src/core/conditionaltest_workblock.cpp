@@ -3,17 +3,22 @@
 
 
 /*!
- * Implements the interface to create an uninitialized work block at a given index.
+ * Implements the interface to create a work block at a given index. The block
+ * processes the pairs whose clusters lie in the given range of cluster
+ * offsets, which must begin and end at pair boundaries.
  *
  * @param index The given index to create the block at
+ *
+ * @param start The cluster offset of the first pair to process.
+ *
+ * @param end The cluster offset after the last pair to process.
  */
-ConditionalTest::WorkBlock::WorkBlock(int index, Pairwise::Index start, qint64 startpair, qint64 size) :
+ConditionalTest::WorkBlock::WorkBlock(int index, qint64 start, qint64 end) :
     EAbstractAnalyticBlock(index),
     _start(start),
-    _startpair(startpair),
-    _size(size)
+    _end(end)
 {
-    EDEBUG_FUNC(this,index,startpair,size);
+    EDEBUG_FUNC(this,index,start,end);
 }
 
 
@@ -27,7 +32,7 @@ void ConditionalTest::WorkBlock::write(QDataStream& stream) const
 {
     EDEBUG_FUNC(this,&stream);
 
-    stream << _startpair << _size;
+    stream << _start << _end;
 }
 
 
@@ -41,5 +46,5 @@ void ConditionalTest::WorkBlock::read(QDataStream& stream)
 {
     EDEBUG_FUNC(this,&stream);
 
-    stream >> _startpair >> _size;
+    stream >> _start >> _end;
 }
@@ -13,27 +13,23 @@ public:
      * Creates an uninitialized work block
      */
     explicit WorkBlock() = default;
-    explicit WorkBlock(int index, Pairwise::Index start, qint64 startpair, qint64 size);
+    explicit WorkBlock(int index, qint64 start, qint64 end);
 
-    Pairwise::Index start() const { return _start; }
-    qint64 size() const { return _size; }
-    qint64 startpair() const {return _startpair;}
+    qint64 start() const { return _start; }
+    qint64 end() const { return _end; }
 protected:
     virtual void write(QDataStream& stream) const override final;
     virtual void read(QDataStream& stream) override final;
 private:
     /*!
-     * The pairwise index of the first pair to process.
+     * The cluster offset in the cluster matrix of the first pair to process.
      */
-    Pairwise::Index _start;
+    qint64 _start {0};
     /*!
-     * The the number of the starting pair.
+     * The cluster offset in the cluster matrix after the last pair to
+     * process.
      */
-    qint64 _startpair;
-    /*!
-     * The number of pairs to process.
-     */
-    qint64 _size;
+    qint64 _end {0};
 };
 
 
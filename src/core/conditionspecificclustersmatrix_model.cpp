@@ -43,13 +43,13 @@ QVariant CSMatrix::Model::headerData(int section, Qt::Orientation orientation, i
     }
 
     // get gene names
-    EMetaArray geneNames {_matrix->geneNames()};
+    const NameTable& geneNames = _matrix->geneTable();
 
     // make sure section is within limits of gene name array
     if ( section >= 0 && section < geneNames.size() )
     {
         // return gene name
-        return geneNames.at(section).toString();
+        return geneNames.at(section);
     }
 
     // no gene found return nothing
@@ -21,6 +21,8 @@ public:
     QString toString() const;
     const double& at(int cluster, int gene, QString type) const;
     double& at(int cluster, int gene, QString type);
+    const double* pValues(int cluster) const { return _pValues.at(cluster).constData(); }
+    const double* rSquares(int cluster) const { return _r2.at(cluster).constData(); }
     void addCluster(int amount, int size) const;
 private:
     virtual void writeCluster(EDataStream& stream, int cluster);
@@ -29,13 +29,18 @@ SOURCES += \
     expressionmatrix.cpp \
     extract_input.cpp \
     extract.cpp \
+    gzipdevice.cpp \
     importcorrelationmatrix_input.cpp \
     importcorrelationmatrix.cpp \
     importexpressionmatrix_input.cpp \
     importexpressionmatrix.cpp \
+    mergeshards_input.cpp \
+    mergeshards.cpp \
+    nametable.cpp \
     pairwise_correlationmodel.cpp \
     pairwise_gmm.cpp \
     pairwise_index.cpp \
+    pairwise_join.cpp \
     pairwise_linalg.cpp \
     pairwise_matrix_pair.cpp \
     pairwise_matrix.cpp \
@@ -43,6 +48,7 @@ SOURCES += \
     pairwise_spearman.cpp \
     powerlaw_input.cpp \
     powerlaw.cpp \
+    rmt_cache.cpp \
     rmt_input.cpp \
     rmt.cpp \
     similarity_cuda_kernel.cpp \
@@ -54,8 +60,10 @@ SOURCES += \
     similarity_opencl.cpp \
     similarity_resultblock.cpp \
     similarity_serial.cpp \
+    similarity_shard.cpp \
     similarity_workblock.cpp \
     similarity.cpp \
+    thresholdsummary.cpp \
     corrpower.cpp \
     corrpower_input.cpp \
     corrpower_resultblock.cpp \
@@ -94,14 +102,19 @@ HEADERS += \
     expressionmatrix.h \
     extract_input.h \
     extract.h \
+    gzipdevice.h \
     importcorrelationmatrix_input.h \
     importcorrelationmatrix.h \
     importexpressionmatrix_input.h \
     importexpressionmatrix.h \
+    mergeshards_input.h \
+    mergeshards.h \
+    nametable.h \
     pairwise_clusteringmodel.h \
     pairwise_correlationmodel.h \
     pairwise_gmm.h \
     pairwise_index.h \
+    pairwise_join.h \
     pairwise_linalg.h \
     pairwise_matrix_pair.h \
     pairwise_matrix.h \
@@ -109,6 +122,7 @@ HEADERS += \
     pairwise_spearman.h \
     powerlaw_input.h \
     powerlaw.h \
+    rmt_cache.h \
     rmt_input.h \
     rmt.h \
     similarity_cuda_kernel.h \
@@ -120,8 +134,10 @@ HEADERS += \
     similarity_opencl.h \
     similarity_resultblock.h \
     similarity_serial.h \
+    similarity_shard.h \
     similarity_workblock.h \
     similarity.h \
+    thresholdsummary.h \
     corrpower.h \
     corrpower_input.h \
     corrpower_serial.h \
@@ -1,6 +1,10 @@
 #include "correlationmatrix.h"
 #include "correlationmatrix_model.h"
 #include "correlationmatrix_pair.h"
+#include <QCryptographicHash>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 
 
@@ -43,6 +47,23 @@ void CorrelationMatrix::initialize(const EMetaArray& geneNames, int maxClusterSi
 
 
 
+/*!
+ * Write the sub-header to the data object file. The sub-header itself is
+ * empty, but since this is also called when the matrix is finished, it is
+ * used to save the content hash of every pair that was written to the
+ * metadata.
+ */
+void CorrelationMatrix::writeHeader()
+{
+    EDEBUG_FUNC(this);
+
+    EMetaObject metaObject {meta().toObject()};
+    metaObject.insert("hash", QString(makeHash(_digest).toHex()));
+    setMeta(metaObject);
+}
+
+
+
 /*!
  * Return the correlation name for this correlation matrix.
  */
@@ -89,3 +110,213 @@ std::vector<CorrelationMatrix::RawPair> CorrelationMatrix::dumpRawData() const
 
     return pairs;
 }
+
+
+
+/*!
+ * Return a hash of the contents of this correlation matrix, which consists of
+ * the index and the correlations of every pair. If pairs have been written to
+ * this matrix since it was opened, the hash is made from their digests, so
+ * that it is available before the matrix is finished. The hash is saved to
+ * the metadata when the matrix is written, so it is normally returned without
+ * reading any pairs. Matrices which were written without a saved hash are
+ * read in a single pass without storing the pairs.
+ */
+QByteArray CorrelationMatrix::contentHash() const
+{
+    EDEBUG_FUNC(this);
+
+    // use the digest of the pairs which were written if there are any
+    if ( _digest != 0 )
+    {
+        return makeHash(_digest);
+    }
+
+    // use the saved hash if it exists
+    QString savedHash {meta().toObject().at("hash").toString()};
+
+    if ( !savedHash.isEmpty() )
+    {
+        return QByteArray::fromHex(savedHash.toLatin1());
+    }
+
+    // otherwise add the digest of each pair
+    quint64 digest {0};
+    Pair pair(this);
+    std::vector<float> correlations(maxClusterSize());
+
+    while ( pair.hasNext() )
+    {
+        pair.readNext();
+
+        for ( int k = 0; k < pair.clusterSize(); ++k )
+        {
+            correlations[k] = pair.at(k);
+        }
+
+        digest += pairDigest(pair.index(), correlations.data(), pair.clusterSize());
+    }
+
+    return makeHash(digest);
+}
+
+
+
+/*!
+ * Return the digest of a single pair, which consists of its index and its
+ * correlations.
+ *
+ * @param index
+ * @param correlations
+ * @param size
+ */
+quint64 CorrelationMatrix::pairDigest(const Pairwise::Index& index, const float* correlations, int size)
+{
+    QCryptographicHash hash(QCryptographicHash::Md5);
+
+    qint32 header[] { index.getX(), index.getY(), size };
+
+    hash.addData(reinterpret_cast<const char*>(header), sizeof(header));
+    hash.addData(reinterpret_cast<const char*>(correlations), size * sizeof(float));
+
+    QByteArray result {hash.result()};
+    quint64 digest;
+
+    memcpy(&digest, result.constData(), sizeof(digest));
+
+    return digest;
+}
+
+
+
+/*!
+ * Return the content hash of this correlation matrix given the sum of the
+ * digests of every pair. The matrix dimensions are included in the hash.
+ *
+ * @param digest
+ */
+QByteArray CorrelationMatrix::makeHash(quint64 digest) const
+{
+    EDEBUG_FUNC(this,digest);
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+
+    qint64 header[] { geneSize(), maxClusterSize(), size() };
+
+    hash.addData(reinterpret_cast<const char*>(header), sizeof(header));
+    hash.addData(reinterpret_cast<const char*>(&digest), sizeof(digest));
+
+    return hash.result();
+}
+
+
+
+/*!
+ * Return the correlation data of this correlation matrix in compact form. The
+ * pairs are read in a single pass, and each pair is reduced to a single
+ * correlation with the given reduction method. Pairs whose reduced correlation
+ * is below the given minimum in absolute value are discarded, but they are
+ * still used to compute the row-wise maximums. The correlation of each cluster
+ * is also saved if cluster correlations are included. If the number of pairs
+ * which are kept is known in advance, it can be given as the capacity so that
+ * the arrays are allocated only once.
+ *
+ * @param reductionMethod
+ * @param minCorrelation
+ * @param includeClusters
+ * @param capacity
+ */
+CorrelationMatrix::CompactData CorrelationMatrix::dumpCompactData(ReductionMethod reductionMethod, float minCorrelation, bool includeClusters, qint64 capacity) const
+{
+    EDEBUG_FUNC(this,static_cast<int>(reductionMethod),minCorrelation,includeClusters,capacity);
+
+    // make sure reduction method is supported
+    if ( reductionMethod == ReductionMethod::MaximumSize )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(tr("Unsupported Option"));
+        e.setDetails(tr("Pairwise reduction by maximum size is not yet supported."));
+        throw e;
+    }
+
+    // initialize compact data
+    CompactData data;
+    data.maximums.assign(geneSize(), 0);
+
+    if ( minCorrelation <= 0 )
+    {
+        capacity = size();
+    }
+
+    data.x.reserve(capacity);
+    data.y.reserve(capacity);
+    data.correlations.reserve(capacity);
+
+    if ( includeClusters )
+    {
+        data.offsets.push_back(0);
+    }
+
+    // iterate through all pairs
+    Pair pair(this);
+
+    while ( pair.hasNext() )
+    {
+        // read in next pair
+        pair.readNext();
+
+        int clusterSize = pair.clusterSize();
+
+        // update row-wise maximum
+        float& maximum = data.maximums[pair.index().getX()];
+
+        for ( int k = 0; k < clusterSize; ++k )
+        {
+            maximum = std::max(maximum, fabsf(pair.at(k)));
+        }
+
+        // select correlation from pair
+        float correlation = 0;
+
+        switch ( reductionMethod )
+        {
+        case ReductionMethod::First:
+            correlation = pair.at(0);
+            break;
+        case ReductionMethod::MaximumCorrelation:
+            for ( int k = 0; k < clusterSize; ++k )
+            {
+                correlation = std::max(correlation, fabsf(pair.at(k)));
+            }
+            break;
+        case ReductionMethod::MaximumSize:
+            break;
+        case ReductionMethod::Random:
+            correlation = pair.at(qrand() % clusterSize);
+            break;
+        }
+
+        // skip pair if its reduced correlation is below the minimum
+        if ( fabsf(correlation) < minCorrelation )
+        {
+            continue;
+        }
+
+        // append pair to compact data
+        data.x.push_back(pair.index().getX());
+        data.y.push_back(pair.index().getY());
+        data.correlations.push_back(correlation);
+
+        if ( includeClusters )
+        {
+            for ( int k = 0; k < clusterSize; ++k )
+            {
+                data.clusterCorrelations.push_back(pair.at(k));
+            }
+
+            data.offsets.push_back(data.clusterCorrelations.size());
+        }
+    }
+
+    return data;
+}
@@ -20,19 +20,79 @@ public:
         Pairwise::Index index;
         std::vector<float> correlations;
     };
+    /*!
+     * Defines the pairwise reduction methods, which select a single correlation
+     * from the clusters of a pair.
+     */
+    enum class ReductionMethod
+    {
+        /*!
+         * Select the first cluster
+         */
+        First
+        /*!
+         * Select the cluster with the highest absolute correlation
+         */
+        ,MaximumCorrelation
+        /*!
+         * Select the cluster with the largest sample size
+         */
+        ,MaximumSize
+        /*!
+         * Select a random cluster
+         */
+        ,Random
+    };
+    /*!
+     * Defines the correlation data of a correlation matrix in compact form, in
+     * which each pair is reduced to a single correlation and stored in flat
+     * arrays.
+     */
+    struct CompactData
+    {
+        /*!
+         * The row index of each pair.
+         */
+        std::vector<qint32> x;
+        /*!
+         * The column index of each pair.
+         */
+        std::vector<qint32> y;
+        /*!
+         * The reduced correlation of each pair.
+         */
+        std::vector<float> correlations;
+        /*!
+         * The position of the first cluster correlation of each pair, followed
+         * by the total number of cluster correlations. Only used if cluster
+         * correlations are included.
+         */
+        std::vector<qint64> offsets;
+        /*!
+         * The correlation of each cluster of each pair. Only used if cluster
+         * correlations are included.
+         */
+        std::vector<float> clusterCorrelations;
+        /*!
+         * The maximum absolute correlation of any cluster in each row, over all
+         * pairs including those which were filtered out.
+         */
+        std::vector<float> maximums;
+    };
 public:
     virtual QAbstractTableModel* model() override final;
 public:
     void initialize(const EMetaArray& geneNames, int maxClusterSize, const QString& correlationName);
     QString correlationName() const;
     std::vector<RawPair> dumpRawData() const;
+    QByteArray contentHash() const;
+    CompactData dumpCompactData(ReductionMethod reductionMethod, float minCorrelation = 0, bool includeClusters = false, qint64 capacity = 0) const;
 private:
     class Model;
 private:
-    /*!
-     * Write the sub-header to the data object file.
-     */
-    virtual void writeHeader() override final {}
+    static quint64 pairDigest(const Pairwise::Index& index, const float* correlations, int size);
+    QByteArray makeHash(quint64 digest) const;
+    virtual void writeHeader() override final;
     /*!
      * Read the sub-header from the data object file.
      */
@@ -47,6 +107,13 @@ private:
      * Pointer to a qt table model for this class.
      */
     Model* _model {nullptr};
+    /*!
+     * The sum of the digests of every pair which has been written to this
+     * matrix. The sum does not depend on the order in which pairs are written,
+     * so it is the same whether pairs are appended or written at reserved
+     * positions.
+     */
+    quint64 _digest {0};
 };
 
 
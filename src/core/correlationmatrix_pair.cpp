@@ -20,6 +20,42 @@ void CorrelationMatrix::Pair::addCluster(int amount) const
 
 
 
+/*!
+ * Write the iterator's pairwise data to the data object file with the given
+ * pairwise index, and add the digest of the pair to the parent matrix.
+ *
+ * @param index
+ */
+void CorrelationMatrix::Pair::write(const Pairwise::Index& index)
+{
+    EDEBUG_FUNC(this,&index);
+
+    Matrix::Pair::write(index);
+
+    _correlationMatrix->_digest += pairDigest(index, _correlations.constData(), _correlations.size());
+}
+
+
+
+/*!
+ * Write the iterator's pairwise data to the data object file with the given
+ * pairwise index at the given cluster position, and add the digest of the
+ * pair to the parent matrix.
+ *
+ * @param index
+ * @param position
+ */
+void CorrelationMatrix::Pair::write(const Pairwise::Index& index, qint64 position)
+{
+    EDEBUG_FUNC(this,&index,position);
+
+    Matrix::Pair::write(index, position);
+
+    _correlationMatrix->_digest += pairDigest(index, _correlations.constData(), _correlations.size());
+}
+
+
+
 /*!
  * Return the string representation of this pair, which is a comma-delimited
  * string of each correlation in the pair.
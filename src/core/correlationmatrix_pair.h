@@ -15,6 +15,7 @@ class CorrelationMatrix::Pair : public Pairwise::Matrix::Pair
 public:
     Pair(CorrelationMatrix* matrix):
         Matrix::Pair(matrix),
+        _correlationMatrix(matrix),
         _cMatrix(matrix)
         {}
     Pair(const CorrelationMatrix* matrix):
@@ -28,6 +29,8 @@ public:
     virtual void addCluster(int amount = 1) const;
     virtual int clusterSize() const { return _correlations.size(); }
     virtual bool isEmpty() const { return _correlations.isEmpty(); }
+    void write(const Pairwise::Index& index);
+    void write(const Pairwise::Index& index, qint64 position);
     QString toString() const;
     const float& at(int cluster) const { return _correlations.at(cluster); }
     float& at(int cluster) { return _correlations[cluster]; }
@@ -39,6 +42,11 @@ private:
      * Array of correlations for the current pair.
      */
     mutable QVector<float> _correlations;
+    /*!
+     * Pointer to parent correlation matrix, which is used to update its
+     * digest when a pair is written.
+     */
+    CorrelationMatrix* _correlationMatrix {nullptr};
     /*!
      * Constant pointer to parent correlation matrix.
      */
@@ -30,16 +30,15 @@ int ExportCorrelationMatrix::size() const
  *
  * @param result
  */
-void ExportCorrelationMatrix::process(const EAbstractAnalyticBlock*)
+void ExportCorrelationMatrix::process(const EAbstractAnalyticBlock* result)
 {
-    EDEBUG_FUNC(this);
+    EDEBUG_FUNC(this,result);
 
     // initialize workspace
     QString sampleMask(_ccm->sampleSize(), '0');
 
     // read next pair
-    _cmxPair.readNext();
-    _ccmPair.read(_cmxPair.index());
+    _join.readNext();
 
     // write pairwise data to output file
     for ( int k = 0; k < _cmxPair.clusterSize(); k++ )
@@ -112,8 +111,15 @@ void ExportCorrelationMatrix::process(const EAbstractAnalyticBlock*)
             << "\n";
     }
 
+    // compress the remaining data in the last step if the output file is compressed
+    if ( result->index() == size() - 1 && _gzipDevice )
+    {
+        _stream.flush();
+        _gzipDevice->close();
+    }
+
     // make sure writing output file worked
-    if ( _stream.status() != QTextStream::Ok )
+    if ( _stream.status() != QTextStream::Ok || _output->error() != QFileDevice::NoError )
     {
         E_MAKE_EXCEPTION(e);
         e.setTitle(tr("File IO Error"));
@@ -156,8 +162,27 @@ void ExportCorrelationMatrix::initialize()
     // initialize pairwise iterators
     _ccmPair = CCMatrix::Pair(_ccm);
     _cmxPair = CorrelationMatrix::Pair(_cmx);
+    _join = Pairwise::Join(&_cmxPair);
+    _join.add(&_ccmPair);
+
+    // initialize output file stream, which is compressed if specified
+    if ( _compress )
+    {
+        _gzipDevice.reset(new GzipDevice(_output, _numThreads));
+        _gzipDevice->open(QIODevice::WriteOnly);
+        _stream.setDevice(_gzipDevice.get());
+    }
+    else
+    {
+        _stream.setDevice(_output);
+    }
 
-    // initialize output file stream
-    _stream.setDevice(_output);
     _stream.setRealNumberPrecision(8);
+
+    // finish the compressed output file now if there are no pairs, since no
+    // step is processed for an empty correlation matrix
+    if ( size() == 0 && _gzipDevice )
+    {
+        _gzipDevice->close();
+    }
 }
@@ -1,12 +1,15 @@
 #ifndef EXPORTCORRELATIONMATRIX_H
 #define EXPORTCORRELATIONMATRIX_H
 #include <ace/core/core.h>
+#include <memory>
 
 #include "ccmatrix_pair.h"
 #include "ccmatrix.h"
 #include "correlationmatrix_pair.h"
 #include "correlationmatrix.h"
 #include "expressionmatrix.h"
+#include "gzipdevice.h"
+#include "pairwise_join.h"
 
 
 
@@ -33,6 +36,11 @@ private:
     QTextStream _stream;
     CCMatrix::Pair _ccmPair;
     CorrelationMatrix::Pair _cmxPair;
+    /*!
+     * Join iterator which reads each pair of the correlation matrix along with
+     * the same pair of the cluster matrix.
+     */
+    Pairwise::Join _join;
     /*!
      * Pointer to the input expression matrix.
      */
@@ -49,6 +57,19 @@ private:
      * Pointer to the output text file.
      */
     QFile* _output {nullptr};
+    /*!
+     * Whether to compress the output file in the gzip format.
+     */
+    bool _compress {false};
+    /*!
+     * The number of threads to use when compressing the output file.
+     */
+    int _numThreads {1};
+    /*!
+     * Pointer to the gzip device which compresses the output text file, or
+     * null if the output file is not compressed.
+     */
+    std::unique_ptr<GzipDevice> _gzipDevice;
 };
 
 
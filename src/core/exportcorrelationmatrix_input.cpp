@@ -44,6 +44,8 @@ EAbstractAnalyticInput::Type ExportCorrelationMatrix::Input::type(int index) con
     case ClusterData: return Type::DataIn;
     case CorrelationData: return Type::DataIn;
     case OutputFile: return Type::FileOut;
+    case Compress: return Type::Boolean;
+    case NumThreads: return Type::Integer;
     default: return Type::Boolean;
     }
 }
@@ -98,6 +100,26 @@ QVariant ExportCorrelationMatrix::Input::data(int index, Role role) const
         case Role::FileFilters: return tr("Text file %1").arg("(*.txt)");
         default: return QVariant();
         }
+    case Compress:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("gzip");
+        case Role::Title: return tr("Compress Output:");
+        case Role::WhatsThis: return tr("Whether to compress the output file in the gzip format as it is written.");
+        case Role::Default: return false;
+        default: return QVariant();
+        }
+    case NumThreads:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("threads");
+        case Role::Title: return tr("Number of Threads:");
+        case Role::WhatsThis: return tr("The number of threads to use when compressing the output file.");
+        case Role::Default: return 1;
+        case Role::Minimum: return 1;
+        case Role::Maximum: return std::numeric_limits<int>::max();
+        default: return QVariant();
+        }
     default: return QVariant();
     }
 }
@@ -105,15 +127,24 @@ QVariant ExportCorrelationMatrix::Input::data(int index, Role role) const
 
 
 /*!
- * Set an argument with the given index to the given value. This analytic has
- * no basic arguments so this function does nothing.
+ * Set an argument with the given index to the given value.
  *
  * @param index
  * @param value
  */
-void ExportCorrelationMatrix::Input::set(int, const QVariant&)
+void ExportCorrelationMatrix::Input::set(int index, const QVariant& value)
 {
-    EDEBUG_FUNC(this);
+    EDEBUG_FUNC(this,index,&value);
+
+    switch (index)
+    {
+    case Compress:
+        _base->_compress = value.toBool();
+        break;
+    case NumThreads:
+        _base->_numThreads = value.toInt();
+        break;
+    }
 }
 
 
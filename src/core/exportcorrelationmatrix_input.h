@@ -20,6 +20,8 @@ public:
         ,ClusterData
         ,CorrelationData
         ,OutputFile
+        ,Compress
+        ,NumThreads
         ,Total
     };
     explicit Input(ExportCorrelationMatrix* parent);
@@ -34,16 +34,26 @@ void ExportExpressionMatrix::process(const EAbstractAnalyticBlock* result)
     if ( result->index() == 0 )
     {
         // get sample names
-        EMetaArray sampleNames {_input->sampleNames()};
+        const NameTable& sampleNames = _input->sampleTable();
+
+        // initialize output file stream, which is compressed if specified
+        if ( _compress )
+        {
+            _gzipDevice.reset(new GzipDevice(_output, _numThreads));
+            _gzipDevice->open(QIODevice::WriteOnly);
+            _stream.setDevice(_gzipDevice.get());
+        }
+        else
+        {
+            _stream.setDevice(_output);
+        }
 
-        // initialize output file stream
-        _stream.setDevice(_output);
         _stream.setRealNumberPrecision(_precision);
 
         // write sample names
         for ( int i = 0; i < _input->sampleSize(); i++ )
         {
-            _stream << sampleNames.at(i).toString() << "\t";
+            _stream << sampleNames.at(i) << "\t";
         }
         _stream << "\n";
     }
@@ -55,7 +65,7 @@ void ExportExpressionMatrix::process(const EAbstractAnalyticBlock* result)
         int i = result->index() - 1;
 
         // get gene name
-        QString geneName {_input->geneNames().at(i).toString()};
+        const QString& geneName = _input->geneTable().at(i);
 
         // load gene from expression matrix
         ExpressionMatrix::Gene gene(_input);
@@ -85,8 +95,15 @@ void ExportExpressionMatrix::process(const EAbstractAnalyticBlock* result)
         _stream << "\n";
     }
 
+    // compress the remaining data in the last step if the output file is compressed
+    if ( result->index() == size() - 1 && _gzipDevice )
+    {
+        _stream.flush();
+        _gzipDevice->close();
+    }
+
     // make sure writing output file worked
-    if ( _stream.status() != QTextStream::Ok )
+    if ( _stream.status() != QTextStream::Ok || _output->error() != QFileDevice::NoError )
     {
         E_MAKE_EXCEPTION(e);
         e.setTitle(tr("File IO Error"));
@@ -1,8 +1,10 @@
 #ifndef EXPORTEXPRESSIONMATRIX_H
 #define EXPORTEXPRESSIONMATRIX_H
 #include <ace/core/core.h>
+#include <memory>
 
 #include "expressionmatrix.h"
+#include "gzipdevice.h"
 
 
 
@@ -43,6 +45,19 @@ private:
      * The number of decimals to save for each expression value.
      */
     int _precision {8};
+    /*!
+     * Whether to compress the output file in the gzip format.
+     */
+    bool _compress {false};
+    /*!
+     * The number of threads to use when compressing the output file.
+     */
+    int _numThreads {1};
+    /*!
+     * Pointer to the gzip device which compresses the output text file, or
+     * null if the output file is not compressed.
+     */
+    std::unique_ptr<GzipDevice> _gzipDevice;
 };
 
 
@@ -44,6 +44,8 @@ EAbstractAnalyticInput::Type ExportExpressionMatrix::Input::type(int index) cons
     case OutputFile: return Type::FileOut;
     case NANToken: return Type::String;
     case Precision: return Type::Integer;
+    case Compress: return Type::Boolean;
+    case NumThreads: return Type::Integer;
     default: return Type::Boolean;
     }
 }
@@ -100,6 +102,26 @@ QVariant ExportExpressionMatrix::Input::data(int index, Role role) const
         case Role::Maximum: return std::numeric_limits<int>::max();
         default: return QVariant();
         }
+    case Compress:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("gzip");
+        case Role::Title: return tr("Compress Output:");
+        case Role::WhatsThis: return tr("Whether to compress the output file in the gzip format as it is written.");
+        case Role::Default: return false;
+        default: return QVariant();
+        }
+    case NumThreads:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("threads");
+        case Role::Title: return tr("Number of Threads:");
+        case Role::WhatsThis: return tr("The number of threads to use when compressing the output file.");
+        case Role::Default: return 1;
+        case Role::Minimum: return 1;
+        case Role::Maximum: return std::numeric_limits<int>::max();
+        default: return QVariant();
+        }
     default: return QVariant();
     }
 }
@@ -124,6 +146,12 @@ void ExportExpressionMatrix::Input::set(int index, const QVariant& value)
     case Precision:
         _base->_precision = value.toInt();
         break;
+    case Compress:
+        _base->_compress = value.toBool();
+        break;
+    case NumThreads:
+        _base->_numThreads = value.toInt();
+        break;
     }
 }
 
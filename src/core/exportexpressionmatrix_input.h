@@ -20,6 +20,8 @@ public:
         ,OutputFile
         ,NANToken
         ,Precision
+        ,Compress
+        ,NumThreads
         ,Total
     };
     explicit Input(ExportExpressionMatrix* parent);
@@ -41,6 +41,8 @@ void ExpressionMatrix::writeNewData()
 
     // initialize metadata object
     setMeta(EMetaObject());
+    _geneTable.reset();
+    _sampleTable.reset();
 
     // seek to the beginning of the data
     seek(0);
@@ -132,6 +134,44 @@ EMetaArray ExpressionMatrix::sampleNames() const
 
 
 
+/*!
+ * Return the table of gene names in this expression matrix. The table is
+ * built from the metadata on the first call, which should not be made
+ * concurrently from several threads.
+ */
+const NameTable& ExpressionMatrix::geneTable() const
+{
+    EDEBUG_FUNC(this);
+
+    if ( !_geneTable )
+    {
+        _geneTable.reset(new NameTable(geneNames()));
+    }
+
+    return *_geneTable;
+}
+
+
+
+/*!
+ * Return the table of sample names in this expression matrix. The table is
+ * built from the metadata on the first call, which should not be made
+ * concurrently from several threads.
+ */
+const NameTable& ExpressionMatrix::sampleTable() const
+{
+    EDEBUG_FUNC(this);
+
+    if ( !_sampleTable )
+    {
+        _sampleTable.reset(new NameTable(sampleNames()));
+    }
+
+    return *_sampleTable;
+}
+
+
+
 /*!
  * Return an array of this expression matrix's data in row-major order.
  */
@@ -193,6 +233,8 @@ void ExpressionMatrix::initialize(const QStringList& geneNames, const QStringLis
     metaObject.insert("genes",metaGeneNames);
     metaObject.insert("samples",metaSampleNames);
     setMeta(metaObject);
+    _geneTable.reset();
+    _sampleTable.reset();
 
     // initialize the gene size and sample size accordingly
     _geneSize = geneNames.size();
@@ -1,6 +1,8 @@
 #ifndef EXPRESSIONMATRIX_H
 #define EXPRESSIONMATRIX_H
 #include <ace/core/core.h>
+#include <memory>
+#include "nametable.h"
 
 
 
@@ -26,6 +28,8 @@ public:
     qint32 sampleSize() const;
     EMetaArray geneNames() const;
     EMetaArray sampleNames() const;
+    const NameTable& geneTable() const;
+    const NameTable& sampleTable() const;
     std::vector<float> dumpRawData() const;
     void initialize(const QStringList& geneNames, const QStringList& sampleNames);
 private:
@@ -49,6 +53,16 @@ private:
      * Pointer to a qt table model for this class.
      */
     Model* _model {nullptr};
+    /*!
+     * The cached table of gene names, which is built from the metadata when
+     * it is first requested.
+     */
+    mutable std::unique_ptr<NameTable> _geneTable;
+    /*!
+     * The cached table of sample names, which is built from the metadata when
+     * it is first requested.
+     */
+    mutable std::unique_ptr<NameTable> _sampleTable;
 };
 
 
@@ -41,13 +41,13 @@ QVariant ExpressionMatrix::Model::headerData(int section, Qt::Orientation orient
     case Qt::Vertical:
     {
         // get gene names
-        EMetaArray geneNames {_matrix->geneNames()};
+        const NameTable& geneNames = _matrix->geneTable();
 
         // make sure the index is valid
         if ( section >= 0 && section < geneNames.size() )
         {
             // return the specified row name
-            return geneNames.at(section).toString();
+            return geneNames.at(section);
         }
 
         // otherwise return empty string
@@ -56,13 +56,13 @@ QVariant ExpressionMatrix::Model::headerData(int section, Qt::Orientation orient
     case Qt::Horizontal:
     {
         // get sample names
-        EMetaArray samples {_matrix->sampleNames()};
+        const NameTable& samples = _matrix->sampleTable();
 
         // make sure the index is valid
         if ( section >= 0 && section < samples.size() )
         {
             // return the specified column name
-            return samples.at(section).toString();
+            return samples.at(section);
         }
 
         // otherwise return empty string
@@ -3,6 +3,9 @@
 #include "datafactory.h"
 #include "expressionmatrix_gene.h"
 #include "conditionspecificclustersmatrix_pair.h"
+#include <atomic>
+#include <exception>
+#include <thread>
 
 
 
@@ -13,13 +16,14 @@ using namespace std;
 /*!
  * Return the total number of blocks this analytic must process as steps
  * or blocks of work. This implementation uses a work block for writing
- * each pair to the output file.
+ * each batch of pairs to the output file. An empty correlation matrix still
+ * has one empty batch, so that the output file is always finished.
  */
 int Extract::size() const
 {
     EDEBUG_FUNC(this);
 
-    return _cmx->size();
+    return max(1LL, (_cmx->size() + BATCH_SIZE - 1) / BATCH_SIZE);
 }
 
 
@@ -27,7 +31,8 @@ int Extract::size() const
 /*!
  * Process the given index with a possible block of results if this analytic
  * produces work blocks. This implementation uses only the index of the result
- * block to determine which piece of work to do.
+ * block to determine which piece of work to do. Each block reads the next
+ * batch of pairs and writes the batch according to the output format.
  *
  * @param result
  */
@@ -35,17 +40,20 @@ void Extract::process(const EAbstractAnalyticBlock* result)
 {
     EDEBUG_FUNC(this,result);
 
-    // write pair according to the output format
+    // read the next batch of pairs
+    std::vector<Record> records {readBatch()};
+
+    // write the batch according to the output format
     switch ( _outputFormat )
     {
     case OutputFormat::Text:
-        writeTextFormat(result->index());
-        break;
     case OutputFormat::Minimal:
-        writeMinimalFormat(result->index());
-        break;
     case OutputFormat::GraphML:
-        writeGraphMLFormat(result->index());
+        writeTextBatch(result->index(), records);
+        break;
+    case OutputFormat::Binary:
+    case OutputFormat::CSR:
+        writeBinaryBatch(result->index(), records);
         break;
     }
 }
@@ -53,23 +61,168 @@ void Extract::process(const EAbstractAnalyticBlock* result)
 
 
 /*!
- * Write the next pair using the text format.
+ * Write a batch of pairs using one of the text formats. The pairs are
+ * formatted in parallel and the formatted text is written in the order of
+ * the pairs, so the output file is the same regardless of the number of
+ * threads.
  *
  * @param index
+ * @param records
  */
-void Extract::writeTextFormat(int index)
+void Extract::writeTextBatch(int index, const std::vector<Record>& records)
 {
-    EDEBUG_FUNC(this);
-
-    // get gene names
-    EMetaArray geneNames {_cmx->geneNames()};
-
-    // initialize workspace
-    QString sampleMask(_ccm->sampleSize(), '0');
+    EDEBUG_FUNC(this,index,&records);
 
     // write header to file
     if ( index == 0 )
     {
+        writeHeader();
+    }
+
+    // format the pairs according to the output format
+    std::vector<QString> texts {formatBatch(records)};
+
+    // write the formatted pairs in order
+    for ( auto& text : texts )
+    {
+        _stream << text;
+    }
+
+    // write footer to file
+    if ( index == size() - 1 )
+    {
+        writeFooter();
+
+        // compress the remaining data if the output file is compressed
+        if ( _gzipDevice )
+        {
+            _stream.flush();
+            _gzipDevice->close();
+        }
+    }
+
+    // make sure writing output file worked
+    if ( _stream.status() != QTextStream::Ok || _output->error() != QFileDevice::NoError )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(tr("File IO Error"));
+        e.setDetails(tr("Qt Text Stream encountered an unknown error."));
+        throw e;
+    }
+}
+
+
+
+/*!
+ * Write a batch of pairs using one of the binary formats. The edges of each
+ * pair are encoded in parallel. The binary edge list format writes the edges
+ * of each batch in the order of the pairs, while the CSR format only counts
+ * the degree of each gene and writes the adjacency matrix after the last
+ * batch. The gene table is written after the last batch in both formats.
+ *
+ * @param index
+ * @param records
+ */
+void Extract::writeBinaryBatch(int index, const std::vector<Record>& records)
+{
+    EDEBUG_FUNC(this,index,&records);
+
+    // initialize binary data stream
+    QDataStream stream(_output);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    // write header of binary edge list
+    if ( index == 0 && _outputFormat == OutputFormat::Binary )
+    {
+        stream
+            << BINARY_MAGIC
+            << BINARY_VERSION
+            << static_cast<qint32>(_geneNames.size())
+            << static_cast<qint32>(_maskSize)
+            << static_cast<qint32>(_maskBytes)
+            << static_cast<qint32>(BINARY_EDGE_SIZE + _maskBytes)
+            << static_cast<qint64>(0);
+
+        _edgeCount = 0;
+    }
+
+    // encode the edges of each pair
+    std::vector<std::vector<Edge>> edges(records.size());
+    std::vector<QByteArray> masks(records.size());
+
+    runParallel(records.size(), [this, &records, &edges, &masks] (size_t j)
+    {
+        encodeRecord(records[j], &edges[j], &masks[j]);
+    });
+
+    // write or count the edges of each pair in order
+    for ( size_t j = 0; j < records.size(); ++j )
+    {
+        for ( size_t m = 0; m < edges[j].size(); ++m )
+        {
+            const Edge& edge {edges[j][m]};
+
+            if ( _outputFormat == OutputFormat::Binary )
+            {
+                stream
+                    << edge.source
+                    << edge.target
+                    << edge.similarity
+                    << edge.cluster
+                    << edge.clusterSize;
+
+                stream.writeRawData(masks[j].constData() + m * _maskBytes, _maskBytes);
+                ++_edgeCount;
+            }
+            else
+            {
+                ++_offsets[edge.source + 1];
+                ++_offsets[edge.target + 1];
+            }
+        }
+    }
+
+    // finish the output file after the last batch
+    if ( index == size() - 1 )
+    {
+        if ( _outputFormat == OutputFormat::Binary )
+        {
+            // write the number of edges to the header
+            _output->seek(BINARY_EDGE_COUNT_OFFSET);
+            stream << _edgeCount;
+            _output->seek(_output->size());
+        }
+        else
+        {
+            writeCSR(stream);
+        }
+
+        writeGeneTable();
+    }
+
+    // make sure writing output file worked
+    if ( stream.status() != QDataStream::Ok )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(tr("File IO Error"));
+        e.setDetails(tr("Qt Data Stream encountered an unknown error."));
+        throw e;
+    }
+}
+
+
+
+/*!
+ * Write the header of the output file according to the output format.
+ */
+void Extract::writeHeader()
+{
+    EDEBUG_FUNC(this);
+
+    switch ( _outputFormat )
+    {
+    case OutputFormat::Text:
         _stream
             << "Source"
             << "\t" << "Target"
@@ -83,39 +236,296 @@ void Extract::writeTextFormat(int index)
         // additional headers for each test.
         if ( _csm )
         {
-            for ( int i = 0; i < _csm->getTestCount(); i++ )
+            for ( int i = 0; i < _csmTestNames.size(); i++ )
             {
-                QString testName = _csm->getTestName(i);
-                QString testType = _csm->getTestType(i);
-
-                _stream << "\t" << testName + + "_pVal";
+                _stream << "\t" << _csmTestNames.at(i) + "_pVal";
 
                 // If there is an R-squared value add it as well.
-                if ( QString::compare(testType, "Quantitative", Qt::CaseInsensitive) == 0 ||
-                     QString::compare(testType, "Ordinal", Qt::CaseInsensitive) == 0 )
+                if ( _csmTestHasRSquare.at(i) )
                 {
-                    _stream << "\t" << testName + "_RSqr";
+                    _stream << "\t" << _csmTestNames.at(i) + "_RSqr";
                 }
             }
         }
 
         _stream << "\n";
+        break;
+    case OutputFormat::Minimal:
+        _stream
+            << "Source"
+            << "\t" << "Target"
+            << "\t" << "Similarity_Score"
+            << "\t" << "Cluster_Index"
+            << "\t" << "Num_Clusters"
+            << "\n";
+        break;
+    case OutputFormat::GraphML:
+        _stream
+            << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            << "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\"\n"
+            << "         xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"\n"
+            << "         xsi:schemaLocation=\"http://graphml.graphdrawing.org/xmlns/1.0/graphml.xsd\">\n"
+            << "  <graph id=\"G\" edgedefault=\"undirected\">\n";
+
+        // write node list to file
+        for ( int i = 0; i < _geneNames.size(); i++ )
+        {
+            _stream << "    <node id=\"" << _geneNames.at(i) << "\"/>\n";
+        }
+        break;
+    case OutputFormat::Binary:
+    case OutputFormat::CSR:
+        break;
     }
+}
 
-    // read next pair
-    _cmxPair.readNext();
-    _ccmPair.read(_cmxPair.index());
-    if ( _csm )
+
+
+/*!
+ * Write the footer of the output file according to the output format.
+ */
+void Extract::writeFooter()
+{
+    EDEBUG_FUNC(this);
+
+    if ( _outputFormat == OutputFormat::GraphML )
+    {
+        _stream
+            << "  </graph>\n"
+            << "</graphml>\n";
+    }
+}
+
+
+
+/*!
+ * Read the next batch of pairs from the input data objects. The gene
+ * expressions of a pair are also read if the sample masks of the pair must
+ * be determined from the expression matrix.
+ */
+std::vector<Extract::Record> Extract::readBatch()
+{
+    EDEBUG_FUNC(this);
+
+    std::vector<Record> records;
+    records.reserve(BATCH_SIZE);
+
+    while ( _join.hasNext() && static_cast<int>(records.size()) < BATCH_SIZE )
+    {
+        // read next pair
+        _join.readNext();
+
+        Record record;
+        record.cmxPair = _cmxPair;
+
+        if ( _ccm )
+        {
+            record.ccmPair = _ccmPair;
+        }
+
+        if ( _csm )
+        {
+            record.csmPair = _csmPair;
+        }
+
+        // determine whether the sample masks are taken from the expression matrix
+        bool useExpressions {false};
+
+        switch ( _outputFormat )
+        {
+        case OutputFormat::Text:
+            useExpressions = (_ccmPair.clusterSize() == 0);
+            break;
+        case OutputFormat::Minimal:
+            useExpressions = false;
+            break;
+        case OutputFormat::GraphML:
+            useExpressions = (_cmxPair.clusterSize() <= 1);
+            break;
+        case OutputFormat::Binary:
+            useExpressions = (_maskBytes > 0 && _ccmPair.clusterSize() == 0);
+            break;
+        case OutputFormat::CSR:
+            useExpressions = false;
+            break;
+        }
+
+        // read in gene expressions if any cluster is written
+        bool included {false};
+
+        for ( int k = 0; k < _cmxPair.clusterSize(); k++ )
+        {
+            float correlation {_cmxPair.at(k)};
+
+            if ( _minCorrelation <= fabs(correlation) && fabs(correlation) <= _maxCorrelation )
+            {
+                included = true;
+                break;
+            }
+        }
+
+        if ( _emx && useExpressions && included )
+        {
+            ExpressionMatrix::Gene gene1(_emx);
+            ExpressionMatrix::Gene gene2(_emx);
+
+            gene1.read(_cmxPair.index().getX());
+            gene2.read(_cmxPair.index().getY());
+
+            record.expressions1.resize(_emx->sampleSize());
+            record.expressions2.resize(_emx->sampleSize());
+
+            for ( int i = 0; i < _emx->sampleSize(); ++i )
+            {
+                record.expressions1[i] = gene1.at(i);
+                record.expressions2[i] = gene2.at(i);
+            }
+        }
+
+        records.push_back(std::move(record));
+    }
+
+    return records;
+}
+
+
+
+/*!
+ * Format a batch of pairs according to the output format and return the
+ * text of each pair. The pairs are divided among the formatting threads.
+ *
+ * @param records
+ */
+std::vector<QString> Extract::formatBatch(const std::vector<Record>& records)
+{
+    EDEBUG_FUNC(this,&records);
+
+    std::vector<QString> texts(records.size());
+
+    runParallel(records.size(), [this, &records, &texts] (size_t j)
+    {
+        texts[j] = formatRecord(records[j]);
+    });
+
+    return texts;
+}
+
+
+
+/*!
+ * Apply the given function to each index in the range [0, size), dividing
+ * the indices among the formatting threads. The function is applied in the
+ * current thread if only one thread is used. Any error which occurs in a
+ * thread is rethrown after all threads have finished.
+ *
+ * @param size
+ * @param work
+ */
+void Extract::runParallel(size_t size, const std::function<void(size_t)>& work)
+{
+    EDEBUG_FUNC(this,size,&work);
+
+    int numThreads {static_cast<int>(min(static_cast<size_t>(_numThreads), size))};
+
+    if ( numThreads <= 1 )
+    {
+        for ( size_t j = 0; j < size; ++j )
+        {
+            work(j);
+        }
+
+        return;
+    }
+
+    std::atomic<size_t> next {0};
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors(numThreads);
+
+    for ( int t = 0; t < numThreads; ++t )
+    {
+        threads.emplace_back([t, size, &next, &work, &errors] ()
+        {
+            try
+            {
+                for ( size_t j = next++; j < size; j = next++ )
+                {
+                    work(j);
+                }
+            }
+            catch ( ... )
+            {
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+
+    for ( auto& thread : threads )
     {
-        _csmPair.read(_cmxPair.index());
+        thread.join();
     }
 
+    // rethrow the first error of any thread
+    for ( auto& error : errors )
+    {
+        if ( error )
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+
+
+/*!
+ * Format a pair according to the output format.
+ *
+ * @param record
+ */
+QString Extract::formatRecord(const Record& record) const
+{
+    EDEBUG_FUNC(this,&record);
+
+    switch ( _outputFormat )
+    {
+    case OutputFormat::Text:
+        return formatTextFormat(record);
+    case OutputFormat::Minimal:
+        return formatMinimalFormat(record);
+    case OutputFormat::GraphML:
+        return formatGraphMLFormat(record);
+    case OutputFormat::Binary:
+    case OutputFormat::CSR:
+        break;
+    }
+
+    return QString();
+}
+
+
+
+/*!
+ * Format a pair using the text format.
+ *
+ * @param record
+ */
+QString Extract::formatTextFormat(const Record& record) const
+{
+    EDEBUG_FUNC(this,&record);
+
+    const CorrelationMatrix::Pair& cmxPair {record.cmxPair};
+    const CCMatrix::Pair& ccmPair {record.ccmPair};
+    const CSMatrix::Pair& csmPair {record.csmPair};
+
+    // initialize workspace
+    QString text;
+    QString sampleMask(_ccm->sampleSize(), '0');
+
     // write pairwise data to output file
-    for ( int k = 0; k < _cmxPair.clusterSize(); k++ )
+    for ( int k = 0; k < cmxPair.clusterSize(); k++ )
     {
-        QString source {geneNames.at(_cmxPair.index().getX()).toString()};
-        QString target {geneNames.at(_cmxPair.index().getY()).toString()};
-        float correlation {_cmxPair.at(k)};
+        const QString& source {_geneNames.at(cmxPair.index().getX())};
+        const QString& target {_geneNames.at(cmxPair.index().getY())};
+        float correlation {cmxPair.at(k)};
         QString interaction {"co"};
         int numSamples {0};
 
@@ -125,105 +535,292 @@ void Extract::writeTextFormat(int index)
             continue;
         }
 
-        // If the condition-specific matrix is provided and there is a p-value filter then
-        // we want to exclude values that are higher than the p-value(s).
+        // If the condition-specific matrix is provided then exclude clusters
+        // which do not pass the p-value and r-squared filters.
+        if ( _csm )
+        {
+            if ( !testFilter(_pValuePlan, csmPair.pValues(k)) || !testFilter(_rSquarePlan, csmPair.rSquares(k)) )
+            {
+                continue;
+            }
+        }
+
+        // if cluster data exists then use it
+        if ( ccmPair.clusterSize() > 0 )
+        {
+            // compute cluster size
+            for ( int i = 0; i < _ccm->sampleSize(); i++ )
+            {
+                if ( ccmPair.at(k, i) == 1 )
+                {
+                    numSamples++;
+                }
+            }
+
+            // write sample mask to string
+            for ( int i = 0; i < _ccm->sampleSize(); i++ )
+            {
+                sampleMask[i] = '0' + ccmPair.at(k, i);
+            }
+        }
+
+        // otherwise use expression data if provided
+        else if ( _emx )
+        {
+            // determine sample mask, summary statistics from expression data
+            for ( int i = 0; i < _emx->sampleSize(); ++i )
+            {
+                if ( isnan(record.expressions1[i]) || isnan(record.expressions2[i]) )
+                {
+                    sampleMask[i] = '9';
+                }
+                else
+                {
+                    sampleMask[i] = '1';
+                    numSamples++;
+                }
+            }
+        }
+
+        // otherwise throw an error
+        else
+        {
+            E_MAKE_EXCEPTION(e);
+            e.setTitle(tr("Invalid Input"));
+            e.setDetails(tr("Expression Matrix was not provided but Cluster Matrix is missing sample data."));
+            throw e;
+        }
+
+        // write cluster to output file
+        text
+            += source
+            + "\t" + target
+            + "\t" + formatReal(correlation)
+            + "\t" + interaction
+            + "\t" + QString::number(k + 1)
+            + "\t" + QString::number(numSamples)
+            + "\t" + sampleMask;
+
+        if ( _csm )
+        {
+            for ( int i = 0; i < _csmTestNames.size(); i++ )
+            {
+                text += "\t" + formatReal(csmPair.pValues(k)[i]);
+
+                // If there is an R-squared value add it as well.
+                if ( _csmTestHasRSquare.at(i) )
+                {
+                    text += "\t" + formatReal(csmPair.rSquares(k)[i]);
+                }
+            }
+        }
+
+        text += "\n";
+    }
+
+    return text;
+}
+
+
+
+/*!
+ * Format a pair using the minimal format.
+ *
+ * @param record
+ */
+QString Extract::formatMinimalFormat(const Record& record) const
+{
+    EDEBUG_FUNC(this,&record);
+
+    const CorrelationMatrix::Pair& cmxPair {record.cmxPair};
+
+    // write pairwise data to output file
+    QString text;
+
+    for ( int k = 0; k < cmxPair.clusterSize(); k++ )
+    {
+        const QString& source {_geneNames.at(cmxPair.index().getX())};
+        const QString& target {_geneNames.at(cmxPair.index().getY())};
+        float correlation {cmxPair.at(k)};
+
+        // exclude cluster if correlation is not within thresholds
+        if ( fabs(correlation) < _minCorrelation || _maxCorrelation < fabs(correlation) )
+        {
+            continue;
+        }
+
+        // write cluster to output file
+        text
+            += source
+            + "\t" + target
+            + "\t" + formatReal(correlation)
+            + "\t" + QString::number(k + 1)
+            + "\t" + QString::number(cmxPair.clusterSize())
+            + "\n";
+    }
+
+    return text;
+}
+
+
+
+/*!
+ * Format a pair using the GraphML format.
+ *
+ * @param record
+ */
+QString Extract::formatGraphMLFormat(const Record& record) const
+{
+    EDEBUG_FUNC(this,&record);
+
+    const CorrelationMatrix::Pair& cmxPair {record.cmxPair};
+    const CCMatrix::Pair& ccmPair {record.ccmPair};
+
+    // initialize workspace
+    QString text;
+    QString sampleMask(_ccm->sampleSize(), '0');
+
+    // write pairwise data to net file
+    for ( int k = 0; k < cmxPair.clusterSize(); k++ )
+    {
+        const QString& source {_geneNames.at(cmxPair.index().getX())};
+        const QString& target {_geneNames.at(cmxPair.index().getY())};
+        float correlation {cmxPair.at(k)};
+
+        // exclude edge if correlation is not within thresholds
+        if ( fabs(correlation) < _minCorrelation || _maxCorrelation < fabs(correlation) )
+        {
+            continue;
+        }
+
+        // if there are multiple clusters then use cluster data
+        if ( cmxPair.clusterSize() > 1 )
+        {
+            // write sample mask to string
+            for ( int i = 0; i < _ccm->sampleSize(); i++ )
+            {
+                sampleMask[i] = '0' + ccmPair.at(k, i);
+            }
+        }
+
+        // otherwise use expression data if provided
+        else if ( _emx )
+        {
+            // determine sample mask from expression data
+            for ( int i = 0; i < _emx->sampleSize(); ++i )
+            {
+                if ( isnan(record.expressions1[i]) || isnan(record.expressions2[i]) )
+                {
+                    sampleMask[i] = '9';
+                }
+                else
+                {
+                    sampleMask[i] = '1';
+                }
+            }
+        }
+
+        // otherwise throw an error
+        else
+        {
+            E_MAKE_EXCEPTION(e);
+            e.setTitle(tr("Invalid Input"));
+            e.setDetails(tr("Expression Matrix was not provided but Cluster Matrix is missing sample data."));
+            throw e;
+        }
+
+        // write edge to file
+        text
+            += "    <edge"
+            "      source=\"" + source + "\""
+            "      target=\"" + target + "\""
+            "      samples=\"" + sampleMask + "\""
+            "    />\n";
+    }
+
+    return text;
+}
+
+
+
+/*!
+ * Encode the edges of a pair for the binary formats. An edge is encoded for
+ * each cluster which passes the correlation thresholds and, if the
+ * condition-specific matrix is provided, the p-value and r-squared filters.
+ * If sample masks are written, the sample mask of each edge is appended to
+ * the given byte array, where each sample is a bit which is set if the
+ * sample is in the cluster.
+ *
+ * @param record
+ * @param edges
+ * @param masks
+ */
+void Extract::encodeRecord(const Record& record, std::vector<Edge>* edges, QByteArray* masks) const
+{
+    EDEBUG_FUNC(this,&record,edges,masks);
+
+    const CorrelationMatrix::Pair& cmxPair {record.cmxPair};
+    const CCMatrix::Pair& ccmPair {record.ccmPair};
+    const CSMatrix::Pair& csmPair {record.csmPair};
+
+    for ( int k = 0; k < cmxPair.clusterSize(); k++ )
+    {
+        float correlation {cmxPair.at(k)};
+
+        // exclude cluster if correlation is not within thresholds
+        if ( fabs(correlation) < _minCorrelation || _maxCorrelation < fabs(correlation) )
+        {
+            continue;
+        }
+
+        // exclude cluster if it does not pass the condition-specific filters
         if ( _csm )
         {
-            // Run some pre-checks on any filters provided.
-            pValueFilterCheck();
-
-            // Iterate through teach test.
-            int notInclude = 0;
-            int include = 0;
-
-            for ( int i = 0; i < _csm->getTestCount(); i++ )
-            {
-                // Count the number of features that are not signficant for each feature-specific p-value provided.
-                if ( _csmPValueFilterFeatureNames.size() != 0 && !PValuefilter(_csm->getTestName(i), _csmPair.at(k, i, "pvalue")))
-                {
-                    notInclude++;
-                }
-
-                // Count the number of features that are signficant if only a single p-value filter was given.
-                if ( _csmPValueFilterFeatureNames.size() == 0 && PValuefilter(_csm->getTestName(i), _csmPair.at(k, i, "pvalue")))
-                {
-                    include++;
-                }
-            }
-
-            if ( notInclude > 0  || (_csmPValueFilterFeatureNames.size() == 0 && include == 0))
+            if ( !testFilter(_pValuePlan, csmPair.pValues(k)) || !testFilter(_rSquarePlan, csmPair.rSquares(k)) )
             {
                 continue;
             }
+        }
 
-            // Run some pre-checks on any filters provided.
-            rSquareFilterCheck();
-
-            // Iterate through teach test.
-            notInclude = 0;
-            include = 0;
-
-            for ( int i = 0; i < _csm->getTestCount(); i++ )
-            {
-                // Count the number of features that are not signficant for each feature-specific p-value provided.
-                if ( _csmRSquareFilterFeatureNames.size() != 0 && !RSquarefilter(_csm->getTestName(i), _csmPair.at(k, i, "r2")))
-                {
-                    notInclude++;
-                }
+        // encode edge
+        Edge edge;
+        edge.source = cmxPair.index().getX();
+        edge.target = cmxPair.index().getY();
+        edge.similarity = correlation;
+        edge.cluster = k + 1;
+        edge.clusterSize = cmxPair.clusterSize();
 
-                // Count the number of features that are signficant if only a single p-value filter was given.
-                if ( _csmRSquareFilterFeatureNames.size() == 0 && RSquarefilter(_csm->getTestName(i), _csmPair.at(k, i, "r2")))
-                {
-                    include++;
-                }
-            }
+        edges->push_back(edge);
 
-            if ( notInclude > 0  || (_csmPValueFilterFeatureNames.size() == 0 && include == 0))
-            {
-                continue;
-            }
+        // encode sample mask if it is written
+        if ( _maskBytes == 0 )
+        {
+            continue;
         }
 
+        QByteArray mask(_maskBytes, 0);
+        char* bits {mask.data()};
+
         // if cluster data exists then use it
-        if ( _ccmPair.clusterSize() > 0 )
+        if ( ccmPair.clusterSize() > 0 )
         {
-            // compute cluster size
             for ( int i = 0; i < _ccm->sampleSize(); i++ )
             {
-                if ( _ccmPair.at(k, i) == 1 )
+                if ( ccmPair.at(k, i) == 1 )
                 {
-                    numSamples++;
+                    bits[i / 8] |= (0x80 >> (i % 8));
                 }
             }
-
-            // write sample mask to string
-            for ( int i = 0; i < _ccm->sampleSize(); i++ )
-            {
-                sampleMask[i] = '0' + _ccmPair.at(k, i);
-            }
         }
 
         // otherwise use expression data if provided
         else if ( _emx )
         {
-            // read in gene expressions
-            ExpressionMatrix::Gene gene1(_emx);
-            ExpressionMatrix::Gene gene2(_emx);
-
-            gene1.read(_cmxPair.index().getX());
-            gene2.read(_cmxPair.index().getY());
-
-            // determine sample mask, summary statistics from expression data
             for ( int i = 0; i < _emx->sampleSize(); ++i )
             {
-                if ( isnan(gene1.at(i)) || isnan(gene2.at(i)) )
-                {
-                    sampleMask[i] = '9';
-                }
-                else
+                if ( !isnan(record.expressions1[i]) && !isnan(record.expressions2[i]) )
                 {
-                    sampleMask[i] = '1';
-                    numSamples++;
+                    bits[i / 8] |= (0x80 >> (i % 8));
                 }
             }
         }
@@ -237,227 +834,173 @@ void Extract::writeTextFormat(int index)
             throw e;
         }
 
-        // write cluster to output file
-        _stream
-            << source
-            << "\t" << target
-            << "\t" << correlation
-            << "\t" << interaction
-            << "\t" << k + 1
-            << "\t" << numSamples
-            << "\t" << sampleMask;
-
-        if ( _csm )
-        {
-            for ( int i = 0; i < _csm->getTestCount(); i++ )
-            {
-                _stream << "\t" << _csmPair.at(k, i, "pvalue");
-
-                // If there is an R-squared value add it as well.
-                QString testType = _csm->getTestType(i);
-
-                if ( QString::compare(testType, "Quantitative", Qt::CaseInsensitive) == 0 ||
-                     QString::compare(testType, "Ordinal", Qt::CaseInsensitive) == 0 )
-                {
-                    _stream << "\t" << _csmPair.at(k, i, "r2");
-                }
-            }
-        }
-
-        _stream << "\n";
-    }
-
-    // make sure writing output file worked
-    if ( _stream.status() != QTextStream::Ok )
-    {
-        E_MAKE_EXCEPTION(e);
-        e.setTitle(tr("File IO Error"));
-        e.setDetails(tr("Qt Text Stream encountered an unknown error."));
-        throw e;
+        masks->append(mask);
     }
 }
 
 
 
 /*!
- * Write the next pair using the minimal format.
+ * Write the adjacency matrix in compressed sparse row (CSR) form, given the
+ * degree of each gene which was counted from every batch. The network is
+ * undirected, so each edge is stored in the rows of both genes. Since the
+ * pairs are read in order, the columns of each row are sorted. The file
+ * consists of a header followed by the row offsets, the column indices, the
+ * similarity scores and the cluster indices. The rows are written in chunks
+ * of limited size, and the pairs are read again for each chunk so that only
+ * the entries of one chunk are held in memory.
  *
- * @param index
+ * @param stream
  */
-void Extract::writeMinimalFormat(int index)
+void Extract::writeCSR(QDataStream& stream)
 {
-    EDEBUG_FUNC(this);
+    EDEBUG_FUNC(this,&stream);
 
-    // get gene names
-    EMetaArray geneNames {_cmx->geneNames()};
-
-    // write header to file
-    if ( index == 0 )
+    // compute row offsets from the degree of each gene
+    for ( size_t i = 1; i < _offsets.size(); ++i )
     {
-        _stream
-            << "Source"
-            << "\t" << "Target"
-            << "\t" << "Similarity_Score"
-            << "\t" << "Cluster_Index"
-            << "\t" << "Num_Clusters"
-            << "\n";
+        _offsets[i] += _offsets[i - 1];
     }
 
-    // read next pair
-    _cmxPair.readNext();
+    qint64 size {_offsets.back()};
 
-    // write pairwise data to output file
-    for ( int k = 0; k < _cmxPair.clusterSize(); k++ )
-    {
-        QString source {geneNames.at(_cmxPair.index().getX()).toString()};
-        QString target {geneNames.at(_cmxPair.index().getY()).toString()};
-        float correlation {_cmxPair.at(k)};
-
-        // exclude cluster if correlation is not within thresholds
-        if ( fabs(correlation) < _minCorrelation || _maxCorrelation < fabs(correlation) )
-        {
-            continue;
-        }
+    // write header
+    stream
+        << CSR_MAGIC
+        << BINARY_VERSION
+        << static_cast<qint32>(_geneNames.size())
+        << static_cast<qint32>(0)
+        << size;
 
-        // write cluster to output file
-        _stream
-            << source
-            << "\t" << target
-            << "\t" << correlation
-            << "\t" << k + 1
-            << "\t" << _cmxPair.clusterSize()
-            << "\n";
-    }
-
-    // make sure writing output file worked
-    if ( _stream.status() != QTextStream::Ok )
+    // write row offsets
+    for ( auto& offset : _offsets )
     {
-        E_MAKE_EXCEPTION(e);
-        e.setTitle(tr("File IO Error"));
-        e.setDetails(tr("Qt Text Stream encountered an unknown error."));
-        throw e;
+        stream << offset;
     }
-}
-
-
-
-/*!
- * Write the next pair using the GraphML format.
- *
- * @param index
- */
-void Extract::writeGraphMLFormat(int index)
-{
-    EDEBUG_FUNC(this);
 
-    // get gene names
-    EMetaArray geneNames {_cmx->geneNames()};
+    // determine the position of each array in the output file
+    qint64 columnsStart {_output->pos()};
+    qint64 similaritiesStart {columnsStart + size * static_cast<qint64>(sizeof(qint32))};
+    qint64 clustersStart {similaritiesStart + size * static_cast<qint64>(sizeof(float))};
 
-    // initialize workspace
-    QString sampleMask(_ccm->sampleSize(), '0');
+    // fill and write the rows of the adjacency matrix in chunks
+    int geneSize {_geneNames.size()};
 
-    if ( index == 0 )
+    for ( int first = 0, last = 0; first < geneSize; first = last )
     {
-        // write header to file
-        _stream
-            << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
-            << "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\"\n"
-            << "         xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"\n"
-            << "         xsi:schemaLocation=\"http://graphml.graphdrawing.org/xmlns/1.0/graphml.xsd\">\n"
-            << "  <graph id=\"G\" edgedefault=\"undirected\">\n";
+        // select the rows of the next chunk, which has at least one row
+        last = first + 1;
 
-        // write node list to file
-        for ( int i = 0; i < _cmx->geneSize(); i++ )
+        while ( last < geneSize && _offsets[last + 1] - _offsets[first] <= CSR_CHUNK_SIZE )
         {
-            QString id {geneNames.at(i).toString()};
-
-            _stream << "    <node id=\"" << id << "\"/>\n";
+            ++last;
         }
-    }
 
-    // read next pair
-    _cmxPair.readNext();
+        qint64 base {_offsets[first]};
+        qint64 count {_offsets[last] - base};
 
-    if ( _cmxPair.clusterSize() > 1 )
-    {
-        _ccmPair.read(_cmxPair.index());
-    }
-
-    // write pairwise data to net file
-    for ( int k = 0; k < _cmxPair.clusterSize(); k++ )
-    {
-        QString source {geneNames.at(_cmxPair.index().getX()).toString()};
-        QString target {geneNames.at(_cmxPair.index().getY()).toString()};
-        float correlation {_cmxPair.at(k)};
-
-        // exclude edge if correlation is not within thresholds
-        if ( fabs(correlation) < _minCorrelation || _maxCorrelation < fabs(correlation) )
+        if ( count == 0 )
         {
             continue;
         }
 
-        // if there are multiple clusters then use cluster data
-        if ( _cmxPair.clusterSize() > 1 )
+        // read every pair and fill the rows of the chunk
+        std::vector<qint64> next(_offsets.begin() + first, _offsets.begin() + last);
+        std::vector<qint32> columns(count);
+        std::vector<float> similarities(count);
+        std::vector<quint8> clusters(count);
+
+        auto fill = [first, last, base, &next, &columns, &similarities, &clusters] (qint32 row, qint32 column, const Edge& edge)
         {
-            // write sample mask to string
-            for ( int i = 0; i < _ccm->sampleSize(); i++ )
+            if ( first <= row && row < last )
             {
-                sampleMask[i] = '0' + _ccmPair.at(k, i);
+                qint64 k {next[row - first]++ - base};
+
+                columns[k] = column;
+                similarities[k] = edge.similarity;
+                clusters[k] = edge.cluster;
             }
-        }
+        };
 
-        // otherwise use expression data if provided
-        else if ( _emx )
+        _join.reset();
+
+        while ( _join.hasNext() )
         {
-            // read in gene expressions
-            ExpressionMatrix::Gene gene1(_emx);
-            ExpressionMatrix::Gene gene2(_emx);
+            std::vector<Record> records {readBatch()};
+            std::vector<std::vector<Edge>> edges(records.size());
+            std::vector<QByteArray> masks(records.size());
 
-            gene1.read(_cmxPair.index().getX());
-            gene2.read(_cmxPair.index().getY());
+            runParallel(records.size(), [this, &records, &edges, &masks] (size_t j)
+            {
+                encodeRecord(records[j], &edges[j], &masks[j]);
+            });
 
-            // determine sample mask from expression data
-            for ( int i = 0; i < _emx->sampleSize(); ++i )
+            for ( auto& pairEdges : edges )
             {
-                if ( isnan(gene1.at(i)) || isnan(gene2.at(i)) )
+                for ( auto& edge : pairEdges )
                 {
-                    sampleMask[i] = '9';
-                }
-                else
-                {
-                    sampleMask[i] = '1';
+                    fill(edge.source, edge.target, edge);
+                    fill(edge.target, edge.source, edge);
                 }
             }
         }
 
-        // otherwise throw an error
-        else
+        // write each array of the chunk at its position in the output file
+        _output->seek(columnsStart + base * static_cast<qint64>(sizeof(qint32)));
+
+        for ( auto& column : columns )
         {
-            E_MAKE_EXCEPTION(e);
-            e.setTitle(tr("Invalid Input"));
-            e.setDetails(tr("Expression Matrix was not provided but Cluster Matrix is missing sample data."));
-            throw e;
+            stream << column;
         }
 
-        // write edge to file
-        _stream
-            << "    <edge"
-            << "      source=\"" << source << "\""
-            << "      target=\"" << target << "\""
-            << "      samples=\"" << sampleMask << "\""
-            << "    />\n";
+        _output->seek(similaritiesStart + base * static_cast<qint64>(sizeof(float)));
+
+        for ( auto& similarity : similarities )
+        {
+            stream << similarity;
+        }
+
+        _output->seek(clustersStart + base * static_cast<qint64>(sizeof(quint8)));
+
+        for ( auto& cluster : clusters )
+        {
+            stream << cluster;
+        }
     }
+}
 
-    // write footer to file
-    if ( index == size() - 1 )
+
+
+/*!
+ * Write the gene table of the binary formats, which is a text file with
+ * the name of each gene on a separate line in the order of the gene indices.
+ * The file name of the gene table is the output file name with the suffix
+ * ".genes.txt".
+ */
+void Extract::writeGeneTable()
+{
+    EDEBUG_FUNC(this);
+
+    QFile file(_output->fileName() + ".genes.txt");
+
+    if ( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) )
     {
-        _stream
-            << "  </graph>\n"
-            << "</graphml>\n";
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(tr("File IO Error"));
+        e.setDetails(tr("Could not create gene table %1.").arg(file.fileName()));
+        throw e;
     }
 
-    // make sure writing output file worked
-    if ( _stream.status() != QTextStream::Ok )
+    QTextStream stream(&file);
+
+    for ( auto& name : _geneNames )
+    {
+        stream << name << "\n";
+    }
+
+    stream.flush();
+
+    if ( stream.status() != QTextStream::Ok )
     {
         E_MAKE_EXCEPTION(e);
         e.setTitle(tr("File IO Error"));
@@ -468,6 +1011,19 @@ void Extract::writeGraphMLFormat(int index)
 
 
 
+/*!
+ * Format a real number in the same way as the output text stream, which uses
+ * the smart notation with a precision of 8 significant digits.
+ *
+ * @param value
+ */
+QString Extract::formatReal(double value)
+{
+    return QString::number(value, 'g', 8);
+}
+
+
+
 /*!
  * Make a new input object and return its pointer.
  */
@@ -497,27 +1053,101 @@ void Extract::initialize()
         throw e;
     }
 
-    if ( _outputFormat != OutputFormat::Minimal && !_ccm )
+    if ( (_outputFormat == OutputFormat::Text || _outputFormat == OutputFormat::GraphML) && !_ccm )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(tr("Invalid Argument"));
+        e.setDetails(tr("--ccm is required for the text and graphml output formats."));
+        throw e;
+    }
+
+    if ( _compress && (_outputFormat == OutputFormat::Binary || _outputFormat == OutputFormat::CSR) )
     {
         E_MAKE_EXCEPTION(e);
         e.setTitle(tr("Invalid Argument"));
-        e.setDetails(tr("--ccm is required for all output formats except minimal."));
+        e.setDetails(tr("--gzip is not supported for the binary and csr output formats."));
         throw e;
     }
 
     // initialize pairwise iterators
     _ccmPair = CCMatrix::Pair(_ccm);
     _cmxPair = CorrelationMatrix::Pair(_cmx);
+    _join = Pairwise::Join(&_cmxPair);
+
+    if ( _ccm )
+    {
+        _join.add(&_ccmPair);
+    }
 
     if ( _csm )
     {
         _csmPair = CSMatrix::Pair(_csm);
+        _join.add(&_csmPair);
         preparePValueFilter();
         prepareRSquareFilter();
+
+        // run some pre-checks on any filters provided
+        pValueFilterCheck();
+        rSquareFilterCheck();
+    }
+
+    // determine the size of the sample masks of the binary edge list
+    _maskSize = 0;
+
+    if ( _outputFormat == OutputFormat::Binary )
+    {
+        if ( _ccm )
+        {
+            _maskSize = _ccm->sampleSize();
+        }
+        else if ( _emx )
+        {
+            _maskSize = _emx->sampleSize();
+        }
+    }
+
+    _maskBytes = (_maskSize + 7) / 8;
+
+    // save gene names so that they can be shared by the formatting threads
+    _geneNames = _cmx->geneTable().toStringList();
+
+    // initialize the degree of each gene for the CSR format
+    _offsets.assign(_geneNames.size() + 1, 0);
+
+    // save test names and types of the condition-specific cluster matrix
+    _csmTestNames.clear();
+    _csmTestHasRSquare.clear();
+
+    if ( _csm )
+    {
+        for ( int i = 0; i < _csm->getTestCount(); i++ )
+        {
+            QString testType = _csm->getTestType(i);
+
+            _csmTestNames.append(_csm->getTestName(i));
+            _csmTestHasRSquare.append(
+                QString::compare(testType, "Quantitative", Qt::CaseInsensitive) == 0 ||
+                QString::compare(testType, "Ordinal", Qt::CaseInsensitive) == 0);
+        }
+    }
+
+    // compile the p-value and r-squared filters, where the r-squared filter
+    // requires a passing test whenever the p-value filter is not feature-specific
+    _pValuePlan = compileFilter(_csmPValueFilter, _csmPValueFilterThresh, _csmPValueFilterFeatureNames, _csmPValueFilterLabelNames, _csmPValueFilterFeatureNames.size() == 0);
+    _rSquarePlan = compileFilter(_csmRSquareFilter, _csmRSquareFilterThresh, _csmRSquareFilterFeatureNames, _csmRSquareFilterLabelNames, _csmPValueFilterFeatureNames.size() == 0);
+
+    // initialize output file stream, which is compressed if specified
+    if ( _compress )
+    {
+        _gzipDevice.reset(new GzipDevice(_output, _numThreads));
+        _gzipDevice->open(QIODevice::WriteOnly);
+        _stream.setDevice(_gzipDevice.get());
+    }
+    else
+    {
+        _stream.setDevice(_output);
     }
 
-    // initialize output file stream
-    _stream.setDevice(_output);
     _stream.setRealNumberPrecision(8);
 }
 
@@ -606,76 +1236,101 @@ void Extract::prepareRSquareFilter()
 
 
 /*!
- * Filters the given data by the name of the label and the pvalue.
+ * Compile a p-value or r-squared filter into a filter plan. The plan contains
+ * one step for each test of the condition-specific cluster matrix, which
+ * gives the threshold of the test, so that the filter can be applied to each
+ * cluster without looking up any test names. If the filter has feature-specific
+ * thresholds, a test without a threshold always passes and every test must
+ * pass; otherwise every test uses the first threshold and at least one test
+ * must pass.
  *
- * @param labelName The test name for the label.
+ * @param filter The filter input.
  *
- * @param pValue The pValue assosiated with the test.
+ * @param thresholds The thresholds of the filter.
  *
- * @return True if the test should be included, false otherwise.
+ * @param featureNames The feature names of the feature-specific thresholds.
+ *
+ * @param labelNames The label names of the feature-specific thresholds.
+ *
+ * @param requireAny Whether at least one test must pass if the filter does
+ *                   not have feature-specific thresholds.
  */
-bool Extract::PValuefilter(QString labelName, float pValue)
+Extract::FilterPlan Extract::compileFilter(const QString& filter, const QVector<float>& thresholds, const QVector<QString>& featureNames, const QVector<QString>& labelNames, bool requireAny) const
 {
-    if ( _csmPValueFilter != "" )
+    EDEBUG_FUNC(this,&filter,&thresholds,&featureNames,&labelNames,requireAny);
+
+    FilterPlan plan;
+    plan.requireAll = (featureNames.size() != 0);
+    plan.requireAny = requireAny;
+
+    for ( int i = 0; i < _csmTestNames.size(); i++ )
     {
-        // If there are feature-specific filters then apply the filter to the respective field.
-        if ( _csmPValueFilterFeatureNames.size() != 0 )
-        {
-            auto names = labelName.split("__");
+        FilterStep step;
+        step.test = i;
 
-            for ( int i = 0; i < _csmPValueFilterFeatureNames.size(); i++ )
+        if ( filter != "" )
+        {
+            // If there are feature-specific filters then apply the filter to the respective field.
+            if ( featureNames.size() != 0 )
             {
-                if ( names.at(0) == _csmPValueFilterFeatureNames.at(i) && names.at(1) == _csmPValueFilterLabelNames.at(i) )
+                auto names = _csmTestNames.at(i).split("__");
+
+                for ( int j = 0; j < featureNames.size(); j++ )
                 {
-                    return (pValue <= _csmPValueFilterThresh.at(i));
+                    if ( names.size() > 1 && names.at(0) == featureNames.at(j) && names.at(1) == labelNames.at(j) )
+                    {
+                        step.op = FilterOp::LessEqual;
+                        step.threshold = thresholds.at(j);
+                        break;
+                    }
                 }
             }
-        }
 
-        // If there are no names for the filter, then check any field.
-        else
-        {
-            return (pValue <= _csmPValueFilterThresh.at(0));
+            // If there are no names for the filter, then check any field.
+            else
+            {
+                step.op = FilterOp::LessEqual;
+                step.threshold = thresholds.at(0);
+            }
         }
+
+        plan.steps.push_back(step);
     }
 
-    return true;
+    return plan;
 }
 
 
 
 /*!
- * Filters the given data by the name of the label and the pvalue.
+ * Apply a filter plan to the test values of a cluster.
  *
- * @param labelName The test name for the label.
+ * @param plan The filter plan.
  *
- * @param pValue The pValue assosiated with the test.
+ * @param values The p-values or r-squared values of the cluster.
  *
- * @return True if the test should be included, false otherwise.
+ * @return True if the cluster should be included, false otherwise.
  */
-bool Extract::RSquarefilter(QString labelName, float rSquared)
+bool Extract::testFilter(const FilterPlan& plan, const double* values)
 {
-    if ( _csmRSquareFilter != "" )
+    for ( auto& step : plan.steps )
     {
-        if ( _csmRSquareFilterFeatureNames.size() != 0 )
-        {
-            auto names = labelName.split("__");
+        bool pass {step.op == FilterOp::Always || static_cast<float>(values[step.test]) <= step.threshold};
 
-            for ( int i = 0; i < _csmRSquareFilterFeatureNames.size(); i++ )
-            {
-                if ( names.at(0) == _csmRSquareFilterFeatureNames.at(i) && names.at(1) == _csmRSquareFilterLabelNames.at(i) )
-                {
-                    return (rSquared <= _csmRSquareFilterThresh.at(i));
-                }
-            }
+        // every test must pass if the filter is feature-specific
+        if ( plan.requireAll && !pass )
+        {
+            return false;
         }
-        else
+
+        // otherwise any passing test includes the cluster
+        if ( !plan.requireAll && pass )
         {
-            return (rSquared <= _csmRSquareFilterThresh.at(0));
+            return true;
         }
     }
 
-    return true;
+    return !plan.requireAny;
 }
 
 
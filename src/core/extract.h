@@ -1,12 +1,16 @@
 #ifndef EXTRACT_H
 #define EXTRACT_H
 #include <ace/core/core.h>
+#include <functional>
+#include <memory>
 
 #include "ccmatrix_pair.h"
 #include "ccmatrix.h"
 #include "correlationmatrix_pair.h"
 #include "correlationmatrix.h"
 #include "expressionmatrix.h"
+#include "gzipdevice.h"
+#include "pairwise_join.h"
 #include "conditionspecificclustersmatrix.h"
 #include "conditionspecificclustersmatrix_pair.h"
 
@@ -33,9 +37,7 @@ public:
     virtual void initialize();
     void preparePValueFilter();
     void prepareRSquareFilter();
-    bool PValuefilter(QString labelName, float pValue);
     bool pValueFilterCheck();
-    bool RSquarefilter(QString labelName, float rSquared);
     bool rSquareFilterCheck();
 private:
     /*!
@@ -55,11 +57,170 @@ private:
          * GraphML format
          */
         ,GraphML
+        /*!
+         * Binary edge list format
+         */
+        ,Binary
+        /*!
+         * Binary adjacency matrix in compressed sparse row (CSR) format
+         */
+        ,CSR
+    };
+    /*!
+     * Defines the comparisons of a filter step.
+     */
+    enum class FilterOp
+    {
+        /*!
+         * The test always passes
+         */
+        Always
+        /*!
+         * The test passes if its value is less than or equal to the threshold
+         */
+        ,LessEqual
+    };
+    /*!
+     * Defines the comparison of a single test in a filter plan.
+     */
+    struct FilterStep
+    {
+        /*!
+         * The index of the test in the condition-specific cluster matrix.
+         */
+        int test {0};
+        /*!
+         * The comparison to apply to the value of the test.
+         */
+        FilterOp op {FilterOp::Always};
+        /*!
+         * The threshold of the comparison.
+         */
+        float threshold {0};
+    };
+    /*!
+     * Defines a compiled p-value or r-squared filter.
+     */
+    struct FilterPlan
+    {
+        /*!
+         * The comparison of each test.
+         */
+        std::vector<FilterStep> steps;
+        /*!
+         * Whether every test must pass. Otherwise, a cluster is included as
+         * soon as any test passes.
+         */
+        bool requireAll {false};
+        /*!
+         * Whether a cluster is excluded if no test decides the result.
+         */
+        bool requireAny {true};
+    };
+    /*!
+     * Defines a pair which is read from the input data objects.
+     */
+    struct Record
+    {
+        /*!
+         * The correlations of the pair.
+         */
+        CorrelationMatrix::Pair cmxPair;
+        /*!
+         * The sample masks of the pair, if they exist.
+         */
+        CCMatrix::Pair ccmPair;
+        /*!
+         * The condition-specific test results of the pair, if they exist.
+         */
+        CSMatrix::Pair csmPair;
+        /*!
+         * The expressions of the first gene, which are read only if the
+         * sample masks are determined from the expression matrix.
+         */
+        std::vector<float> expressions1;
+        /*!
+         * The expressions of the second gene, which are read only if the
+         * sample masks are determined from the expression matrix.
+         */
+        std::vector<float> expressions2;
+    };
+    /*!
+     * Defines an edge of the binary formats.
+     */
+    struct Edge
+    {
+        /*!
+         * The index of the source gene.
+         */
+        qint32 source;
+        /*!
+         * The index of the target gene.
+         */
+        qint32 target;
+        /*!
+         * The similarity score of the edge.
+         */
+        float similarity;
+        /*!
+         * The cluster index of the edge, starting at 1.
+         */
+        quint8 cluster;
+        /*!
+         * The number of clusters of the pair.
+         */
+        quint8 clusterSize;
     };
 private:
-    void writeTextFormat(int index);
-    void writeMinimalFormat(int index);
-    void writeGraphMLFormat(int index);
+    void writeTextBatch(int index, const std::vector<Record>& records);
+    void writeBinaryBatch(int index, const std::vector<Record>& records);
+    void writeHeader();
+    void writeFooter();
+    std::vector<Record> readBatch();
+    std::vector<QString> formatBatch(const std::vector<Record>& records);
+    QString formatRecord(const Record& record) const;
+    QString formatTextFormat(const Record& record) const;
+    QString formatMinimalFormat(const Record& record) const;
+    QString formatGraphMLFormat(const Record& record) const;
+    FilterPlan compileFilter(const QString& filter, const QVector<float>& thresholds, const QVector<QString>& featureNames, const QVector<QString>& labelNames, bool requireAny) const;
+    static bool testFilter(const FilterPlan& plan, const double* values);
+    void runParallel(size_t size, const std::function<void(size_t)>& work);
+    void encodeRecord(const Record& record, std::vector<Edge>* edges, QByteArray* masks) const;
+    void writeCSR(QDataStream& stream);
+    void writeGeneTable();
+    static QString formatReal(double value);
+    /*!
+     * The number of pairs which are read and formatted in each work block.
+     */
+    constexpr static int BATCH_SIZE {10000};
+    /*!
+     * Identifies a file as a binary edge list.
+     */
+    constexpr static quint32 BINARY_MAGIC {0x4b424544};
+    /*!
+     * Identifies a file as a binary CSR adjacency matrix.
+     */
+    constexpr static quint32 CSR_MAGIC {0x4b435352};
+    /*!
+     * The version of the binary formats.
+     */
+    constexpr static quint32 BINARY_VERSION {1};
+    /*!
+     * The size (in bytes) of an edge in the binary edge list, not including
+     * the sample mask.
+     */
+    constexpr static int BINARY_EDGE_SIZE {14};
+    /*!
+     * The position of the number of edges in the header of the binary edge
+     * list.
+     */
+    constexpr static qint64 BINARY_EDGE_COUNT_OFFSET {24};
+    /*!
+     * The maximum number of entries of the CSR adjacency matrix which are held
+     * in memory while it is written. The pairs are read again for each chunk
+     * of this size.
+     */
+    constexpr static qint64 CSR_CHUNK_SIZE {1 << 24};
 private:
     /**
      * Workspace variables to write to the output file
@@ -68,6 +229,24 @@ private:
     CCMatrix::Pair _ccmPair;
     CorrelationMatrix::Pair _cmxPair;
     CSMatrix::Pair _csmPair;
+    /*!
+     * Join iterator which reads each pair of the correlation matrix along with
+     * the same pair of the cluster matrix and condition-specific cluster matrix.
+     */
+    Pairwise::Join _join;
+    /*!
+     * The gene names of the correlation matrix.
+     */
+    QStringList _geneNames;
+    /*!
+     * The test names of the condition-specific cluster matrix.
+     */
+    QStringList _csmTestNames;
+    /*!
+     * Whether each test of the condition-specific cluster matrix has an
+     * R-squared value.
+     */
+    QVector<bool> _csmTestHasRSquare;
     /*!
      * Pointer to the input expression matrix.
      */
@@ -104,6 +283,39 @@ private:
      * The maximum (absolute) correlation threshold.
      */
     float _maxCorrelation {1.00f};
+    /*!
+     * The number of threads to use when formatting pairs and compressing the
+     * output file.
+     */
+    int _numThreads {1};
+    /*!
+     * Whether to compress the output file in the gzip format.
+     */
+    bool _compress {false};
+    /*!
+     * Pointer to the gzip device which compresses the output text file, or
+     * null if the output file is not compressed.
+     */
+    std::unique_ptr<GzipDevice> _gzipDevice;
+    /*!
+     * The number of samples in each sample mask of the binary edge list, or
+     * zero if sample masks are not written.
+     */
+    int _maskSize {0};
+    /*!
+     * The size (in bytes) of each bit-packed sample mask of the binary edge
+     * list.
+     */
+    int _maskBytes {0};
+    /*!
+     * The number of edges which were written to the binary edge list.
+     */
+    qint64 _edgeCount {0};
+    /*!
+     * The row offsets of the CSR format, which are counted from the degree of
+     * each gene while the pairs are read for the first time.
+     */
+    std::vector<qint64> _offsets;
     /*!
      * Condition-Specific Cluster Matrix name filter input.
      */
@@ -131,6 +343,14 @@ private:
     QVector<float> _csmRSquareFilterThresh;
     QVector<QString> _csmRSquareFilterFeatureNames;
     QVector<QString> _csmRSquareFilterLabelNames;
+    /*!
+     * The compiled p-value filter.
+     */
+    FilterPlan _pValuePlan;
+    /*!
+     * The compiled r-squared filter.
+     */
+    FilterPlan _rSquarePlan;
 };
 
 
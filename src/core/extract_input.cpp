@@ -13,6 +13,8 @@ const QStringList Extract::Input::FORMAT_NAMES
     "text"
     ,"minimal"
     ,"graphml"
+    ,"binary"
+    ,"csr"
 };
 
 
@@ -64,6 +66,8 @@ EAbstractAnalyticInput::Type Extract::Input::type(int index) const
     case MaxCorrelation: return Type::Double;
     case CSMPValueFilter: return Type::String;
     case CSMRSquareFilter: return Type::String;
+    case NumThreads: return Type::Integer;
+    case Compress: return Type::Boolean;
     default: return Type::Boolean;
     }
 }
@@ -176,6 +180,26 @@ QVariant Extract::Input::data(int index, Role role) const
         case Role::Default: return "0.3";
         default: return QVariant();
         }
+    case NumThreads:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("threads");
+        case Role::Title: return tr("Number of Threads:");
+        case Role::WhatsThis: return tr("The number of threads to use when formatting and compressing the output file. The output file is the same for any number of threads.");
+        case Role::Default: return 1;
+        case Role::Minimum: return 1;
+        case Role::Maximum: return std::numeric_limits<int>::max();
+        default: return QVariant();
+        }
+    case Compress:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("gzip");
+        case Role::Title: return tr("Compress Output:");
+        case Role::WhatsThis: return tr("Whether to compress the output file in the gzip format as it is written. Only the text, minimal and graphml formats can be compressed.");
+        case Role::Default: return false;
+        default: return QVariant();
+        }
     default: return QVariant();
     }
 }
@@ -209,6 +233,12 @@ void Extract::Input::set(int index, const QVariant& value)
      case CSMRSquareFilter:
         _base->_csmRSquareFilter = value.toString();
         break;
+    case NumThreads:
+        _base->_numThreads = value.toInt();
+        break;
+    case Compress:
+        _base->_compress = value.toBool();
+        break;
     }
 }
 
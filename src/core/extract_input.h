@@ -26,6 +26,8 @@ public:
         ,MaxCorrelation
         ,CSMPValueFilter
         ,CSMRSquareFilter
+        ,NumThreads
+        ,Compress
         ,Total
     };
     explicit Input(Extract* parent);
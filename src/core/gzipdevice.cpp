@@ -0,0 +1,246 @@
+#include "gzipdevice.h"
+#include <zlib.h>
+#include <atomic>
+#include <exception>
+#include <thread>
+
+
+
+using namespace std;
+
+
+
+/*!
+ * Construct a new gzip device which writes to the given target device. The
+ * target device must already be open for writing.
+ *
+ * @param target
+ * @param numThreads
+ * @param blockSize
+ */
+GzipDevice::GzipDevice(QIODevice* target, int numThreads, int blockSize):
+    _target(target),
+    _numThreads(max(1, numThreads)),
+    _blockSize(max(1, blockSize))
+{
+    EDEBUG_FUNC(this,target,numThreads,blockSize);
+}
+
+
+
+/*!
+ * Open this device. Only write-only mode is supported.
+ *
+ * @param mode
+ */
+bool GzipDevice::open(OpenMode mode)
+{
+    EDEBUG_FUNC(this,static_cast<int>(mode));
+
+    if ( (mode & ReadOnly) || !(mode & WriteOnly) )
+    {
+        setErrorString(tr("Gzip device can only be opened for writing."));
+        return false;
+    }
+
+    _buffer.clear();
+    _memberCount = 0;
+
+    // open without an internal buffer since the text stream is buffered
+    return QIODevice::open(mode | Unbuffered);
+}
+
+
+
+/*!
+ * Compress any remaining data, write it to the target device and close this
+ * device. The target device is not closed.
+ */
+void GzipDevice::close()
+{
+    EDEBUG_FUNC(this);
+
+    if ( !isOpen() )
+    {
+        return;
+    }
+
+    writeBlocks(true);
+
+    QIODevice::close();
+}
+
+
+
+/*!
+ * Reading is not supported by this device.
+ *
+ * @param data
+ * @param maxSize
+ */
+qint64 GzipDevice::readData(char* data, qint64 maxSize)
+{
+    EDEBUG_FUNC(this,data,maxSize);
+
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+
+    return -1;
+}
+
+
+
+/*!
+ * Append the given data to the uncompressed buffer. Once the buffer contains
+ * a full block for each thread, the full blocks are compressed and written
+ * to the target device.
+ *
+ * @param data
+ * @param size
+ */
+qint64 GzipDevice::writeData(const char* data, qint64 size)
+{
+    EDEBUG_FUNC(this,data,size);
+
+    _buffer.append(data, size);
+
+    if ( _buffer.size() >= static_cast<qint64>(_blockSize) * _numThreads )
+    {
+        if ( !writeBlocks(false) )
+        {
+            return -1;
+        }
+    }
+
+    return size;
+}
+
+
+
+/*!
+ * Compress the blocks of the uncompressed buffer in parallel and write them
+ * to the target device in order. Only full blocks are compressed unless this
+ * is the final write, in which case the remaining partial block is also
+ * compressed. The final write always produces at least one gzip member so
+ * that the output is a valid gzip file even if nothing was written. Return
+ * false if writing to the target device failed.
+ *
+ * @param final
+ */
+bool GzipDevice::writeBlocks(bool final)
+{
+    EDEBUG_FUNC(this,final);
+
+    // determine the blocks to compress
+    int numBlocks {_buffer.size() / _blockSize};
+
+    if ( final && (_buffer.size() % _blockSize != 0 || (numBlocks == 0 && _memberCount == 0)) )
+    {
+        ++numBlocks;
+    }
+
+    // compress each block in a separate thread
+    vector<QByteArray> members(numBlocks);
+    int numThreads {min(_numThreads, numBlocks)};
+    atomic<int> next {0};
+    vector<thread> threads;
+    vector<exception_ptr> errors(numThreads);
+
+    for ( int t = 0; t < numThreads; ++t )
+    {
+        threads.emplace_back([this, t, numBlocks, &next, &members, &errors] ()
+        {
+            try
+            {
+                for ( int j = next++; j < numBlocks; j = next++ )
+                {
+                    int offset {j * _blockSize};
+                    int size {min(_blockSize, _buffer.size() - offset)};
+
+                    members[j] = compressBlock(_buffer.constData() + offset, size);
+                }
+            }
+            catch ( ... )
+            {
+                errors[t] = current_exception();
+            }
+        });
+    }
+
+    for ( auto& thread : threads )
+    {
+        thread.join();
+    }
+
+    // rethrow the first error of any thread
+    for ( auto& error : errors )
+    {
+        if ( error )
+        {
+            rethrow_exception(error);
+        }
+    }
+
+    // remove the compressed blocks from the buffer
+    _buffer.remove(0, min(_buffer.size(), numBlocks * _blockSize));
+
+    // write the gzip members in order
+    for ( auto& member : members )
+    {
+        if ( _target->write(member) != member.size() )
+        {
+            setErrorString(_target->errorString());
+            return false;
+        }
+
+        ++_memberCount;
+    }
+
+    return true;
+}
+
+
+
+/*!
+ * Compress the given data into a single gzip member.
+ *
+ * @param data
+ * @param size
+ */
+QByteArray GzipDevice::compressBlock(const char* data, int size)
+{
+    // initialize deflate stream with a gzip header and trailer
+    z_stream stream {};
+
+    if ( deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(QObject::tr("Compression Error"));
+        e.setDetails(QObject::tr("Failed to initialize zlib deflate stream."));
+        throw e;
+    }
+
+    // compress the data in a single pass
+    QByteArray member;
+    member.resize(static_cast<int>(deflateBound(&stream, size)));
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = size;
+    stream.next_out = reinterpret_cast<Bytef*>(member.data());
+    stream.avail_out = member.size();
+
+    int status {deflate(&stream, Z_FINISH)};
+
+    member.resize(static_cast<int>(stream.total_out));
+    deflateEnd(&stream);
+
+    if ( status != Z_STREAM_END )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(QObject::tr("Compression Error"));
+        e.setDetails(QObject::tr("Failed to compress block with zlib."));
+        throw e;
+    }
+
+    return member;
+}
@@ -0,0 +1,59 @@
+#ifndef GZIPDEVICE_H
+#define GZIPDEVICE_H
+#include <ace/core/core.h>
+
+
+
+/*!
+ * This class implements a write-only device which compresses everything that
+ * is written to it in the gzip format and writes the compressed data to a
+ * target device, so that a text stream can write a compressed file without
+ * an uncompressed intermediate. Data is compressed in blocks of a fixed size,
+ * and each block is compressed independently as a separate gzip member, so
+ * that several blocks can be compressed in parallel. A file of concatenated
+ * gzip members is a valid gzip file which is decompressed by any gzip tool.
+ * The device must be closed once all data has been written in order to
+ * compress the last block.
+ */
+class GzipDevice : public QIODevice
+{
+public:
+    explicit GzipDevice(QIODevice* target, int numThreads = 1, int blockSize = DEFAULT_BLOCK_SIZE);
+    virtual bool isSequential() const override final { return true; }
+    virtual bool open(OpenMode mode) override final;
+    virtual void close() override final;
+protected:
+    virtual qint64 readData(char* data, qint64 maxSize) override final;
+    virtual qint64 writeData(const char* data, qint64 size) override final;
+private:
+    bool writeBlocks(bool final);
+    static QByteArray compressBlock(const char* data, int size);
+    /*!
+     * The default size (in bytes) of an uncompressed block.
+     */
+    constexpr static int DEFAULT_BLOCK_SIZE {1 << 20};
+    /*!
+     * Pointer to the device which receives the compressed data.
+     */
+    QIODevice* _target;
+    /*!
+     * The number of threads to use for compression.
+     */
+    int _numThreads;
+    /*!
+     * The size (in bytes) of an uncompressed block.
+     */
+    int _blockSize;
+    /*!
+     * The uncompressed data which has not been compressed yet.
+     */
+    QByteArray _buffer;
+    /*!
+     * The number of gzip members which have been written to the target device.
+     */
+    qint64 _memberCount {0};
+};
+
+
+
+#endif
@@ -0,0 +1,277 @@
+#include "mergeshards.h"
+#include "mergeshards_input.h"
+#include "ccmatrix_pair.h"
+#include "correlationmatrix_pair.h"
+#include "datafactory.h"
+#include <algorithm>
+
+
+
+using namespace std;
+
+
+
+/*!
+ * Return the total number of blocks this analytic must process as steps
+ * or blocks of work. This implementation uses a work block for each segment
+ * of the shard files.
+ */
+int MergeShards::size() const
+{
+    EDEBUG_FUNC(this);
+
+    return _segments.size();
+}
+
+
+
+/*!
+ * Process the given index with a possible block of results if this analytic
+ * produces work blocks. This implementation reads the segment with the same
+ * index as the result block and writes its pairs to the output matrices at
+ * the position of the segment.
+ *
+ * @param result
+ */
+void MergeShards::process(const EAbstractAnalyticBlock* result)
+{
+    EDEBUG_FUNC(this,result);
+
+    // read segment data
+    const Segment& segment {_segments[result->index()]};
+    QByteArray data {segment.shard->read(segment.header)};
+
+    QDataStream stream(data);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    // write each pair in the segment to the output matrices
+    int sampleSize {_emx->sampleSize()};
+    qint64 position {segment.position};
+
+    for ( qint64 p = 0; p < segment.header.pairSize; ++p )
+    {
+        // read pair header
+        qint32 x;
+        qint32 y;
+        qint8 numClusters;
+
+        stream >> x >> y >> numClusters;
+
+        // read correlation and sample mask of each cluster
+        CCMatrix::Pair ccmPair(_ccm);
+        CorrelationMatrix::Pair cmxPair(_cmx);
+
+        ccmPair.addCluster(numClusters);
+        cmxPair.addCluster(numClusters);
+
+        for ( qint8 k = 0; k < numClusters; ++k )
+        {
+            stream >> cmxPair.at(k);
+
+            for ( int i = 0; i < sampleSize; i += 2 )
+            {
+                qint8 value;
+                stream >> value;
+
+                ccmPair.at(k, i) = value & 0x0F;
+
+                if ( i + 1 < sampleSize )
+                {
+                    ccmPair.at(k, i + 1) = (value >> 4) & 0x0F;
+                }
+            }
+        }
+
+        // make sure reading segment data worked
+        if ( stream.status() != QDataStream::Ok )
+        {
+            E_MAKE_EXCEPTION(e);
+            e.setTitle(tr("File IO Error"));
+            e.setDetails(tr("Segment %1 of a shard file is truncated.").arg(segment.header.index));
+            throw e;
+        }
+
+        // save pairs
+        Pairwise::Index index(x, y);
+
+        ccmPair.write(index, position);
+        cmxPair.write(index, position);
+
+        position += numClusters;
+    }
+}
+
+
+
+/*!
+ * Make a new input object and return its pointer.
+ */
+EAbstractAnalyticInput* MergeShards::makeInput()
+{
+    EDEBUG_FUNC(this);
+
+    return new Input(this);
+}
+
+
+
+/*!
+ * Initialize this analytic. This implementation reads the manifest of the
+ * given prefix, opens every shard file listed in it, makes sure that each shard
+ * file was written by the run of the manifest, makes sure that the shard files
+ * are consistent with each other and with the expression matrix, and makes sure
+ * that the segments of all shard files cover every pair exactly once. The position of each segment
+ * in the output matrices is the exclusive prefix sum of the cluster counts of
+ * the preceding segments in pairwise order.
+ */
+void MergeShards::initialize()
+{
+    EDEBUG_FUNC(this);
+
+    // make sure input arguments are valid
+    if ( !_emx )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(tr("Invalid Argument"));
+        e.setDetails(tr("Did not get a valid input argument."));
+        throw e;
+    }
+
+    // read the manifest of the shard files
+    Similarity::Shard::Manifest manifest {Similarity::Shard::readManifest(_shardPrefix)};
+
+    if ( manifest.fileNames.isEmpty() )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(tr("Invalid Argument"));
+        e.setDetails(tr("Shard manifest %1 does not list any shard files.").arg(Similarity::Shard::manifestName(_shardPrefix)));
+        throw e;
+    }
+
+    // open each shard file listed in the manifest
+    QDir dir {QFileInfo(_shardPrefix).absoluteDir()};
+
+    _shards.clear();
+    _segments.clear();
+
+    for ( auto& entry : manifest.fileNames )
+    {
+        QString fileName {dir.filePath(entry)};
+
+        _shards.emplace_back(new Similarity::Shard(fileName));
+
+        auto& shard {_shards.back()};
+        auto& first {_shards.front()};
+
+        shard->open();
+
+        // make sure shard file belongs to the run of the manifest
+        if ( shard->runId() != manifest.runId )
+        {
+            E_MAKE_EXCEPTION(e);
+            e.setTitle(tr("Invalid Argument"));
+            e.setDetails(tr("Shard file %1 was not written by the run of the shard manifest.").arg(fileName));
+            throw e;
+        }
+
+        // make sure shard file matches the expression matrix
+        if ( shard->geneSize() != _emx->geneSize() || shard->sampleSize() != _emx->sampleSize() )
+        {
+            E_MAKE_EXCEPTION(e);
+            e.setTitle(tr("Invalid Argument"));
+            e.setDetails(tr("Shard file %1 does not match the expression matrix.").arg(fileName));
+            throw e;
+        }
+
+        // make sure shard file matches the other shard files
+        if ( shard->maxClusterSize() != first->maxClusterSize() || shard->correlationName() != first->correlationName() || shard->pairSize() != first->pairSize() )
+        {
+            E_MAKE_EXCEPTION(e);
+            e.setTitle(tr("Invalid Argument"));
+            e.setDetails(tr("Shard file %1 was created with different parameters than the other shard files.").arg(fileName));
+            throw e;
+        }
+
+        // append segments of shard file
+        for ( auto& header : shard->segments() )
+        {
+            _segments.append({ shard.get(), header, 0 });
+        }
+    }
+
+    // sort segments by pairwise index
+    QVector<Segment*> sorted;
+
+    for ( auto& segment : _segments )
+    {
+        sorted.append(&segment);
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [] (const Segment* a, const Segment* b)
+    {
+        return a->header.start < b->header.start;
+    });
+
+    // make sure segments cover every pair exactly once and compute the
+    // position of each segment
+    qint64 totalPairs {_shards.front()->pairSize()};
+    qint64 next {0};
+
+    _pairSize = 0;
+    _clusterSize = 0;
+
+    for ( auto segment : sorted )
+    {
+        if ( segment->header.start != next )
+        {
+            E_MAKE_EXCEPTION(e);
+            e.setTitle(tr("Invalid Argument"));
+            e.setDetails(tr("Shard files have missing or overlapping work blocks at pairwise index %1.").arg(next));
+            throw e;
+        }
+
+        segment->position = _clusterSize;
+
+        next += segment->header.size;
+        _pairSize += segment->header.pairSize;
+        _clusterSize += segment->header.clusterSize;
+    }
+
+    if ( next != totalPairs )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(tr("Invalid Argument"));
+        e.setDetails(tr("Shard files cover %1 of %2 pairs.").arg(next).arg(totalPairs));
+        throw e;
+    }
+}
+
+
+
+/*!
+ * Initialize the output data objects of this analytic. The output data
+ * objects are initialized with the parameters of the similarity run and space
+ * is reserved for every pair, so that each segment can be written directly at
+ * its position while each shard file is read sequentially.
+ */
+void MergeShards::initializeOutputs()
+{
+    EDEBUG_FUNC(this);
+
+    // make sure output data is valid
+    if ( !_ccm || !_cmx )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(tr("Invalid Argument"));
+        e.setDetails(tr("Did not get valid output data objects."));
+        throw e;
+    }
+
+    // initialize output data
+    _ccm->initialize(_emx->geneNames(), _shards.front()->maxClusterSize(), _emx->sampleNames());
+    _cmx->initialize(_emx->geneNames(), _shards.front()->maxClusterSize(), _shards.front()->correlationName());
+
+    // reserve space for every pair in the output data
+    _ccm->reserve(_pairSize, _clusterSize);
+    _cmx->reserve(_pairSize, _clusterSize);
+}
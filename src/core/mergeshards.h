@@ -0,0 +1,92 @@
+#ifndef MERGESHARDS_H
+#define MERGESHARDS_H
+#include <ace/core/core.h>
+
+#include "ccmatrix.h"
+#include "correlationmatrix.h"
+#include "expressionmatrix.h"
+#include "similarity_shard.h"
+
+
+
+/*!
+ * This class implements the merge shards analytic. This analytic takes the
+ * shard files written by the similarity analytic and combines them into a
+ * correlation matrix and a cluster matrix, which are identical to the output
+ * matrices that the similarity analytic would have produced without shards.
+ * Only the shard files listed in the manifest of the similarity run are read.
+ * The shard files must cover every work block of the similarity run exactly
+ * once. Since each segment records how many clusters it contains, the position
+ * of every segment in the output matrices is known in advance, so the segments
+ * are written in the order in which they are stored in the shard files.
+ */
+class MergeShards : public EAbstractAnalytic
+{
+    Q_OBJECT
+public:
+    class Input;
+    virtual int size() const override final;
+    virtual void process(const EAbstractAnalyticBlock* result) override final;
+    virtual EAbstractAnalyticInput* makeInput() override final;
+    virtual void initialize() override final;
+    virtual void initializeOutputs() override final;
+private:
+    /*!
+     * Defines a segment of a shard file along with the shard file that
+     * contains it.
+     */
+    struct Segment
+    {
+        /*!
+         * Pointer to the shard file which contains the segment.
+         */
+        Similarity::Shard* shard;
+        /*!
+         * The header of the segment.
+         */
+        Similarity::Shard::Segment header;
+        /*!
+         * The position of the first cluster of the segment in the output
+         * matrices.
+         */
+        qint64 position;
+    };
+private:
+    /*!
+     * Pointer to the input expression matrix.
+     */
+    ExpressionMatrix* _emx {nullptr};
+    /*!
+     * Pointer to the output cluster matrix.
+     */
+    CCMatrix* _ccm {nullptr};
+    /*!
+     * Pointer to the output correlation matrix.
+     */
+    CorrelationMatrix* _cmx {nullptr};
+    /*!
+     * The file name prefix of the shard files.
+     */
+    QString _shardPrefix;
+    /*!
+     * The list of shard files.
+     */
+    std::vector<std::unique_ptr<Similarity::Shard>> _shards;
+    /*!
+     * The list of segments from all shard files, in the order in which they
+     * are stored in the shard files.
+     */
+    QVector<Segment> _segments;
+    /*!
+     * The total number of pairs in all segments.
+     */
+    qint64 _pairSize {0};
+    /*!
+     * The total number of clusters in all segments.
+     */
+    qint64 _clusterSize {0};
+};
+
+
+
+#endif
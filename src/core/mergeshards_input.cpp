@@ -0,0 +1,162 @@
+#include "mergeshards_input.h"
+#include "datafactory.h"
+
+
+
+/*!
+ * Construct a new input object with the given analytic as its parent.
+ *
+ * @param parent
+ */
+MergeShards::Input::Input(MergeShards* parent):
+    EAbstractAnalyticInput(parent),
+    _base(parent)
+{
+    EDEBUG_FUNC(this,parent);
+}
+
+
+
+/*!
+ * Return the total number of arguments this analytic type contains.
+ */
+int MergeShards::Input::size() const
+{
+    EDEBUG_FUNC(this);
+
+    return Total;
+}
+
+
+
+/*!
+ * Return the argument type for a given index.
+ *
+ * @param index
+ */
+EAbstractAnalyticInput::Type MergeShards::Input::type(int index) const
+{
+    EDEBUG_FUNC(this,index);
+
+    switch (index)
+    {
+    case InputData: return Type::DataIn;
+    case ClusterData: return Type::DataOut;
+    case CorrelationData: return Type::DataOut;
+    case ShardPrefix: return Type::String;
+    default: return Type::Boolean;
+    }
+}
+
+
+
+/*!
+ * Return data for a given role on an argument with the given index.
+ *
+ * @param index
+ * @param role
+ */
+QVariant MergeShards::Input::data(int index, Role role) const
+{
+    EDEBUG_FUNC(this,index,role);
+
+    switch (index)
+    {
+    case InputData:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("input");
+        case Role::Title: return tr("Expression Matrix:");
+        case Role::WhatsThis: return tr("A data file created by KINC containing the gene expression matrix that was given to the similarity analytic.");
+        case Role::DataType: return DataFactory::ExpressionMatrixType;
+        default: return QVariant();
+        }
+    case ClusterData:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("ccm");
+        case Role::Title: return tr("Output Cluster Matrix:");
+        case Role::WhatsThis: return tr("A data file created by KINC containing the cluster sample masks created by the similarity analytic.");
+        case Role::DataType: return DataFactory::CCMatrixType;
+        default: return QVariant();
+        }
+    case CorrelationData:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("cmx");
+        case Role::Title: return tr("Output Correlation Matrix:");
+        case Role::WhatsThis: return tr("A data file created by KINC containing the correlation matrix values created by the similarity analytic.");
+        case Role::DataType: return DataFactory::CorrelationMatrixType;
+        default: return QVariant();
+        }
+    case ShardPrefix:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("shards");
+        case Role::Title: return tr("Shard Prefix:");
+        case Role::WhatsThis: return tr("File name prefix of the shard files that was given to the similarity analytic. Only the shard files listed in the manifest with this prefix are merged.");
+        default: return QVariant();
+        }
+    default: return QVariant();
+    }
+}
+
+
+
+/*!
+ * Set an argument with the given index to the given value.
+ *
+ * @param index
+ * @param value
+ */
+void MergeShards::Input::set(int index, const QVariant& value)
+{
+    EDEBUG_FUNC(this,index,&value);
+
+    switch (index)
+    {
+    case ShardPrefix:
+        _base->_shardPrefix = value.toString();
+        break;
+    }
+}
+
+
+
+/*!
+ * Set a file argument with the given index to the given qt file pointer. This
+ * implementation does nothing because this analytic has no file arguments.
+ *
+ * @param index
+ * @param file
+ */
+void MergeShards::Input::set(int, QFile*)
+{
+    EDEBUG_FUNC(this);
+}
+
+
+
+/*!
+ * Set a data argument with the given index to the given data object pointer.
+ *
+ * @param index
+ * @param data
+ */
+void MergeShards::Input::set(int index, EAbstractData* data)
+{
+    EDEBUG_FUNC(this,index,data);
+
+    switch (index)
+    {
+    case InputData:
+        _base->_emx = data->cast<ExpressionMatrix>();
+        break;
+    case ClusterData:
+        _base->_ccm = data->cast<CCMatrix>();
+        break;
+    case CorrelationData:
+        _base->_cmx = data->cast<CorrelationMatrix>();
+        break;
+    }
+}
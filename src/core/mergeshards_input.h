@@ -0,0 +1,41 @@
+#ifndef MERGESHARDS_INPUT_H
+#define MERGESHARDS_INPUT_H
+#include "mergeshards.h"
+
+
+
+/*!
+ * This class implements the abstract input of the merge shards analytic.
+ */
+class MergeShards::Input : public EAbstractAnalyticInput
+{
+    Q_OBJECT
+public:
+    /*!
+     * Defines all input arguments for this analytic.
+     */
+    enum Argument
+    {
+        InputData = 0
+        ,ClusterData
+        ,CorrelationData
+        ,ShardPrefix
+        ,Total
+    };
+    explicit Input(MergeShards* parent);
+    virtual int size() const override final;
+    virtual EAbstractAnalyticInput::Type type(int index) const override final;
+    virtual QVariant data(int index, Role role) const override final;
+    virtual void set(int index, const QVariant& value) override final;
+    virtual void set(int index, QFile* file) override final;
+    virtual void set(int index, EAbstractData* data) override final;
+private:
+    /*!
+     * Pointer to the base analytic for this object.
+     */
+    MergeShards* _base;
+};
+
+
+
+#endif
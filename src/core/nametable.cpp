@@ -0,0 +1,83 @@
+#include "nametable.h"
+
+
+
+/*!
+ * Construct a new name table from the given metadata array of names.
+ *
+ * @param names
+ */
+NameTable::NameTable(const EMetaArray& names)
+{
+    EDEBUG_FUNC(this,&names);
+
+    // decode each name and append its UTF-8 text to the table
+    _strings.reserve(names.size());
+    _offsets.reserve(names.size() + 1);
+
+    for ( int i = 0; i < names.size(); ++i )
+    {
+        QString name {names.at(i).toString()};
+
+        _offsets.push_back(_data.size());
+        _data.append(name.toUtf8());
+        _strings.append(name);
+    }
+
+    _offsets.push_back(_data.size());
+
+    // build the hash index once the text is complete, since the keys refer
+    // directly to the text of the table
+    _index.reserve(names.size());
+
+    for ( int i = names.size() - 1; i >= 0; --i )
+    {
+        _index.insert(utf8(i), i);
+    }
+}
+
+
+
+/*!
+ * Return the UTF-8 text of the name at the given position. The returned
+ * array refers directly to the text of the table, so it is only valid as
+ * long as the table exists.
+ *
+ * @param index
+ */
+QByteArray NameTable::utf8(int index) const
+{
+    EDEBUG_FUNC(this,index);
+
+    return QByteArray::fromRawData(_data.constData() + _offsets[index], _offsets[index + 1] - _offsets[index]);
+}
+
+
+
+/*!
+ * Return the position of the given name in the table, or -1 if the name is
+ * not in the table.
+ *
+ * @param name
+ */
+int NameTable::indexOf(const QString& name) const
+{
+    EDEBUG_FUNC(this,&name);
+
+    return indexOf(name.toUtf8());
+}
+
+
+
+/*!
+ * Return the position of the given UTF-8 name in the table, or -1 if the name
+ * is not in the table.
+ *
+ * @param name
+ */
+int NameTable::indexOf(const QByteArray& name) const
+{
+    EDEBUG_FUNC(this,&name);
+
+    return _index.value(name, -1);
+}
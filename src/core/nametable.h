@@ -0,0 +1,65 @@
+#ifndef NAMETABLE_H
+#define NAMETABLE_H
+#include <ace/core/core.h>
+
+
+
+/*!
+ * This class implements an immutable table of names, such as the gene names
+ * or sample names of a data object. The names are stored once as contiguous
+ * UTF-8 text along with the offset of each name, and a hash index maps each
+ * name to its position in the table. Data objects build the table from their
+ * metadata the first time it is requested, so that analytics can look up
+ * names by position or position by name without walking the metadata again.
+ * A table is safe to read from multiple threads once it has been built.
+ */
+class NameTable
+{
+public:
+    NameTable() = default;
+    explicit NameTable(const EMetaArray& names);
+    /*!
+     * Return the number of names in the table.
+     */
+    int size() const { return _strings.size(); }
+    /*!
+     * Return whether the table is empty.
+     */
+    bool isEmpty() const { return _strings.isEmpty(); }
+    /*!
+     * Return the name at the given position.
+     *
+     * @param index
+     */
+    const QString& at(int index) const { return _strings.at(index); }
+    /*!
+     * Return all names of the table in order.
+     */
+    const QStringList& toStringList() const { return _strings; }
+    QByteArray utf8(int index) const;
+    int indexOf(const QString& name) const;
+    int indexOf(const QByteArray& name) const;
+private:
+    /*!
+     * The UTF-8 text of all names, stored contiguously in order.
+     */
+    QByteArray _data;
+    /*!
+     * The offset of each name in the UTF-8 text, followed by the size of the
+     * text.
+     */
+    std::vector<int> _offsets;
+    /*!
+     * The decoded names, which share the same order as the UTF-8 text.
+     */
+    QStringList _strings;
+    /*!
+     * The position of each name, keyed by views into the UTF-8 text. If a
+     * name occurs more than once, the first position is used.
+     */
+    QHash<QByteArray,int> _index;
+};
+
+
+
+#endif
@@ -0,0 +1,67 @@
+#include "pairwise_join.h"
+
+
+
+using namespace Pairwise;
+
+
+
+/*!
+ * Construct a join iterator with the given primary iterator.
+ *
+ * @param primary
+ */
+Join::Join(const Matrix::Pair* primary):
+    _primary(primary)
+{
+    EDEBUG_FUNC(this,primary);
+}
+
+
+
+/*!
+ * Add a secondary iterator to this join iterator.
+ *
+ * @param secondary
+ */
+void Join::add(const Matrix::Pair* secondary)
+{
+    EDEBUG_FUNC(this,secondary);
+
+    _secondaries.append(secondary);
+}
+
+
+
+/*!
+ * Reset all iterators to the beginning of their pairwise matrices.
+ */
+void Join::reset() const
+{
+    EDEBUG_FUNC(this);
+
+    _primary->reset();
+
+    for ( auto secondary : _secondaries )
+    {
+        secondary->reset();
+    }
+}
+
+
+
+/*!
+ * Read the next pair of the primary iterator and the pair with the same
+ * pairwise index from each secondary iterator.
+ */
+void Join::readNext() const
+{
+    EDEBUG_FUNC(this);
+
+    _primary->readNext();
+
+    for ( auto secondary : _secondaries )
+    {
+        secondary->readForward(_primary->index());
+    }
+}
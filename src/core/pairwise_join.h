@@ -0,0 +1,40 @@
+#ifndef PAIRWISE_JOIN_H
+#define PAIRWISE_JOIN_H
+#include "pairwise_matrix_pair.h"
+
+
+
+namespace Pairwise
+{
+    /*!
+     * This class implements the pairwise join iterator, which iterates through
+     * several pairwise matrices in lockstep. The primary iterator reads every
+     * pair of its matrix in order, and each secondary iterator reads the pair
+     * with the same pairwise index from its own matrix, or no clusters if the
+     * pair does not exist. Since all pairwise matrices are sorted by pairwise
+     * index, each matrix is read with a single sequential pass.
+     */
+    class Join
+    {
+    public:
+        Join() = default;
+        explicit Join(const Matrix::Pair* primary);
+        void add(const Matrix::Pair* secondary);
+        void reset() const;
+        bool hasNext() const { return _primary->hasNext(); }
+        void readNext() const;
+    private:
+        /*!
+         * Pointer to the iterator which determines the pairs that are read.
+         */
+        const Matrix::Pair* _primary {nullptr};
+        /*!
+         * Pointers to the iterators which follow the primary iterator.
+         */
+        QVector<const Matrix::Pair*> _secondaries;
+    };
+}
+
+
+
+#endif
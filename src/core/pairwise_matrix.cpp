@@ -48,6 +48,7 @@ void Matrix::writeNewData()
 
     // initialize metadata
     setMeta(EMetaObject());
+    _geneTable.reset();
 
     // seek to the beginning of the data
     seek(0);
@@ -93,6 +94,57 @@ EMetaArray Matrix::geneNames() const
 
 
 
+/*!
+ * Return the table of gene names in this pairwise matrix. The table is built
+ * from the metadata on the first call, which should not be made concurrently
+ * from several threads.
+ */
+const NameTable& Matrix::geneTable() const
+{
+    EDEBUG_FUNC(this);
+
+    if ( !_geneTable )
+    {
+        _geneTable.reset(new NameTable(geneNames()));
+    }
+
+    return *_geneTable;
+}
+
+
+
+/*!
+ * Return the offset of the first cluster of the first pair which begins at
+ * or after the given cluster offset, or the total number of clusters if there
+ * is no such pair. Since each pair has at most the max cluster size, this
+ * function reads at most that many item headers, so it can be used to divide
+ * the matrix into ranges of whole pairs without reading the entire matrix.
+ *
+ * @param offset
+ */
+qint64 Matrix::findPairStart(qint64 offset) const
+{
+    EDEBUG_FUNC(this,offset);
+
+    // skip clusters until the first cluster of a pair is reached
+    while ( offset < _clusterSize )
+    {
+        qint8 cluster;
+        getPair(offset, &cluster);
+
+        if ( cluster == 0 )
+        {
+            break;
+        }
+
+        ++offset;
+    }
+
+    return std::min(offset, _clusterSize);
+}
+
+
+
 /*!
  * Initialize this pairwise matrix with a list of gene names, the max cluster
  * size, the pairwise data size, and the sub-header size.
@@ -136,6 +188,7 @@ void Matrix::initialize(const EMetaArray& geneNames, qint32 maxClusterSize, qint
     EMetaObject metaObject {meta().toObject()};
     metaObject.insert("genes", geneNames);
     setMeta(metaObject);
+    _geneTable.reset();
 
     // initiailze new data within object
     _geneSize = geneNames.size();
@@ -145,6 +198,58 @@ void Matrix::initialize(const EMetaArray& geneNames, qint32 maxClusterSize, qint
     _pairSize = 0;
     _clusterSize = 0;
     _lastWrite = -1;
+    _reserved = false;
+}
+
+
+
+/*!
+ * Reserve space for the given number of pairs and clusters in this pairwise
+ * matrix. After the space is reserved, pairs can no longer be appended and
+ * must instead be written at a given cluster position, which allows pairs to
+ * be written in any order as long as the caller knows where each pair goes in
+ * the sorted list of pairs. This is used by the merge-shards analytic, which
+ * determines the position of each segment of pairs by an exclusive prefix sum
+ * of the number of clusters in each segment. The header is updated with the reserved sizes when the matrix is finished.
+ *
+ * @param pairSize
+ * @param clusterSize
+ */
+void Matrix::reserve(qint64 pairSize, qint64 clusterSize)
+{
+    EDEBUG_FUNC(this,pairSize,clusterSize);
+
+    // make sure this is a new data object that has not been written to
+    if ( _lastWrite != -1 || _reserved )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(tr("Pairwise Matrix Logical Error"));
+        e.setDetails(tr("Can only reserve space in an initialized object that has not been written to."));
+        throw e;
+    }
+
+    // make sure arguments are valid
+    if ( pairSize < 0 || clusterSize < pairSize )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(tr("Pairwise Matrix Logical Error"));
+        e.setDetails(tr("Cannot reserve %1 clusters for %2 pairs.")
+            .arg(clusterSize)
+            .arg(pairSize));
+        throw e;
+    }
+
+    // save reserved sizes
+    _pairSize = pairSize;
+    _clusterSize = clusterSize;
+    _reserved = true;
+
+    // extend the data object to the end of the reserved space
+    if ( _clusterSize > 0 )
+    {
+        seek(dataEnd() - 1);
+        stream() << static_cast<qint8>(0);
+    }
 }
 
 
@@ -168,6 +273,15 @@ void Matrix::write(const Index& index, qint8 cluster)
         throw e;
     }
 
+    // make sure space was not reserved, in which case pairs must be written by position
+    if ( _reserved )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(tr("Pairwise Matrix Logical Error"));
+        e.setDetails(tr("Attempting to append data to object with reserved space."));
+        throw e;
+    }
+
     // make sure the new pair has a higher indent than the previous written so the list of
     // all indents are sorted
     if ( index.indent(cluster) <= _lastWrite )
@@ -191,6 +305,47 @@ void Matrix::write(const Index& index, qint8 cluster)
 
 
 
+/*!
+ * Write the header of a pair given a pairwise index, cluster index, and the
+ * position of the cluster within the reserved space of this matrix. The caller
+ * is responsible for writing clusters at positions that keep the list of
+ * indents sorted.
+ *
+ * @param index
+ * @param cluster
+ * @param position
+ */
+void Matrix::write(const Index& index, qint8 cluster, qint64 position)
+{
+    EDEBUG_FUNC(this,&index,cluster,position);
+
+    // make sure space was reserved for positional writes
+    if ( !_reserved )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(tr("Pairwise Matrix Logical Error"));
+        e.setDetails(tr("Attempting to write data by position without reserved space."));
+        throw e;
+    }
+
+    // make sure the position is within the reserved space
+    if ( position < 0 || position >= _clusterSize )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(tr("Pairwise Matrix Logical Error"));
+        e.setDetails(tr("Attempting to write cluster at position %1 outside of reserved space of %2 clusters.")
+            .arg(position)
+            .arg(_clusterSize));
+        throw e;
+    }
+
+    // seek to the given position and write indent value
+    seekPair(position);
+    stream() << index.getX() << index.getY() << cluster;
+}
+
+
+
 /*!
  * Get a pair at the given index in the data object file and return the
  * pairwise index and cluster index of that pair.
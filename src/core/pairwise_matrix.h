@@ -1,7 +1,9 @@
 #ifndef PAIRWISE_MATRIX_H
 #define PAIRWISE_MATRIX_H
 #include <ace/core/core.h>
+#include <memory>
 
+#include "nametable.h"
 #include "pairwise_index.h"
 
 
@@ -31,13 +33,18 @@ namespace Pairwise
         qint32 geneSize() const { return _geneSize; }
         qint32 maxClusterSize() const { return _maxClusterSize; }
         qint64 size() const { return _pairSize; }
+        qint64 clusterSize() const { return _clusterSize; }
         EMetaArray geneNames() const;
+        const NameTable& geneTable() const;
+        void reserve(qint64 pairSize, qint64 clusterSize);
+        qint64 findPairStart(qint64 offset) const;
     protected:
         virtual void writeHeader() = 0;
         virtual void readHeader() = 0;
         void initialize(const EMetaArray& geneNames, qint32 maxClusterSize, qint32 dataSize, qint16 subHeaderSize);
     private:
         void write(const Index& index, qint8 cluster);
+        void write(const Index& index, qint8 cluster, qint64 position);
         Index getPair(qint64 index, qint8* cluster) const;
         qint64 findPair(qint64 indent, qint64 first, qint64 last) const;
         void seekPair(qint64 index) const;
@@ -81,6 +88,16 @@ namespace Pairwise
          * The index of the last pair that was written to the matrix.
          */
         qint64 _lastWrite {-2};
+        /*!
+         * Whether the pairs and clusters of the matrix were reserved, in which
+         * case each pair is written at a given position instead of appended.
+         */
+        bool _reserved {false};
+        /*!
+         * The cached table of gene names, which is built from the metadata
+         * when it is first requested.
+         */
+        mutable std::unique_ptr<NameTable> _geneTable;
     };
 }
 
@@ -40,6 +40,40 @@ void Matrix::Pair::write(const Index& index)
 
 
 
+/*!
+ * Write the iterator's pairwise data to the data object file with the given
+ * pairwise index, starting at the given cluster position within the space
+ * that was reserved in the parent matrix. The pair size of the parent matrix
+ * is not changed because it was set when the space was reserved.
+ *
+ * @param index
+ * @param position
+ */
+void Matrix::Pair::write(const Index& index, qint64 position)
+{
+    EDEBUG_FUNC(this,&index,position);
+
+    // make sure cluster size of pair does not exceed max
+    if ( clusterSize() > _matrix->_maxClusterSize )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(tr("Pairwise Logical Error"));
+        e.setDetails(tr("Cannot write pair with cluster size %1 exceeding the max of %2.")
+            .arg(clusterSize())
+            .arg(_matrix->_maxClusterSize));
+        throw e;
+    }
+
+    // go through each cluster and write it to data object
+    for ( qint8 i = 0; i < clusterSize(); ++i )
+    {
+        _matrix->write(index,i,position + i);
+        writeCluster(_matrix->stream(),i);
+    }
+}
+
+
+
 /*!
  * Read the pair with the given pairwise index from the data object file.
  *
@@ -65,6 +99,48 @@ void Matrix::Pair::read(const Index& index) const
 
 
 
+/*!
+ * Read the pair with the given pairwise index by scanning forward from the
+ * iterator's current position. Since pairs are stored in order, a sequence of
+ * increasing indices can be read with a single sequential pass over the data
+ * object file instead of a binary search for each pair. The given index must
+ * not precede the pair which was read last. If the pair does not exist, the
+ * iterator has no clusters and remains at the first pair after the given
+ * index.
+ *
+ * @param index
+ */
+void Matrix::Pair::readForward(const Index& index) const
+{
+    EDEBUG_FUNC(this,&index);
+
+    // clear any existing clusters
+    clearClusters();
+
+    // skip clusters until the given index is reached or passed
+    qint64 indent {index.indent(0)};
+
+    while ( _rawIndex < _cMatrix->_clusterSize )
+    {
+        qint8 cluster;
+        Index next {_cMatrix->getPair(_rawIndex,&cluster)};
+
+        if ( next.indent(cluster) >= indent )
+        {
+            // pair found, read in all clusters
+            if ( next == index )
+            {
+                readNext();
+            }
+            break;
+        }
+
+        ++_rawIndex;
+    }
+}
+
+
+
 /*!
  * Read the next pair in the data object file.
  */
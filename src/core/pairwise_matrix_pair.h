@@ -32,8 +32,12 @@ namespace Pairwise
         virtual int clusterSize() const = 0;
         virtual bool isEmpty() const = 0;
         void write(const Index& index);
+        void write(const Index& index, qint64 position);
         void read(const Index& index) const;
+        void readForward(const Index& index) const;
         void reset() const { _rawIndex = 0; }
+        void seek(qint64 offset) const { _rawIndex = offset; }
+        qint64 offset() const { return _rawIndex; }
         void readNext() const;
         bool hasNext() const { return _rawIndex != _cMatrix->_clusterSize; }
         const Index& index() const { return _index; }
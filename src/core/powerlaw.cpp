@@ -1,11 +1,15 @@
 #include "powerlaw.h"
 #include "powerlaw_input.h"
 #include "correlationmatrix.h"
+#include "thresholdsummary.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
 
 
 
 using namespace std;
-using RawPair = CorrelationMatrix::RawPair;
+using CompactData = CorrelationMatrix::CompactData;
 
 
 
@@ -35,45 +39,110 @@ void PowerLaw::process(const EAbstractAnalyticBlock*)
     // initialize log text stream
     QTextStream stream(_logfile);
 
-    // load raw correlation data, row-wise maximums
-    std::vector<RawPair> pairs {_input->dumpRawData()};
-    std::vector<float> maximums {computeMaximums(pairs)};
-
-    // continue until network is sufficiently scale-free
+    // load threshold summary if it was provided
     float threshold {_thresholdStart};
+    qint64 capacity {0};
+
+    if ( !_summaryFileName.isEmpty() )
+    {
+        ThresholdSummary summary;
+        summary.load(_summaryFileName);
+
+        // make sure that the summary was produced from the input correlation matrix
+        if ( summary.hash() != _input->contentHash() )
+        {
+            E_MAKE_EXCEPTION(e);
+            e.setTitle(tr("Invalid Argument"));
+            e.setDetails(tr("Threshold summary %1 does not match the input correlation matrix.").arg(_summaryFileName));
+            throw e;
+        }
+
+        // skip the thresholds at which the network is empty; each skipped
+        // threshold is still written to the log file as an empty network, so
+        // that the log file is the same as when no summary is provided
+        while ( threshold - _thresholdStep >= _thresholdStop && summary.geneCount(threshold) == 0 )
+        {
+            Fit fit;
+
+            qInfo("threshold: %0.3f, network: 0, skipped", threshold);
+
+            stream
+                << QString::number(threshold, 'f', 3) << "\t"
+                << 0 << "\t"
+                << 0.0f << "\t"
+                << fit.alpha << "\t"
+                << fit.xmin << "\t"
+                << fit.distance << "\n";
+
+            threshold -= _thresholdStep;
+        }
+
+        // allocate the compact data for every pair above the stopping threshold
+        capacity = summary.edgeCount(_thresholdStop);
+    }
+
+    // load compact correlation data and row-wise maximums, discarding pairs
+    // below the stopping threshold
+    {
+        CompactData data = _input->dumpCompactData(CorrelationMatrix::ReductionMethod::First, _thresholdStop, false, capacity);
+
+        _maximums = std::move(data.maximums);
+        computeEdges(data);
+    }
+
+    _nextGene = 0;
+    _nextEdge = 0;
+    _degrees.assign(_input->geneSize(), 0);
+    _histogram.clear();
+    _maxDegree = 0;
 
+    // continue until network is sufficiently scale-free
     while ( true )
     {
         qInfo("\n");
         qInfo("threshold: %0.3f", threshold);
 
-        // compute adjacency matrix based on threshold
-        size_t size;
-        std::vector<bool> adjacencyMatrix {computeAdjacencyMatrix(pairs, maximums, threshold, &size)};
+        // add the genes and edges of the network which are included at threshold
+        updateDegrees(threshold);
 
-        qInfo("adjacency matrix: %lu", size);
+        size_t size = _nextGene;
 
-        // make sure that adjacency matrix is not empty
+        qInfo("network: %lu", size);
+
+        // make sure that network is not empty
         float correlation {0};
+        Fit fit;
 
         if ( size > 0 )
         {
-            // compute degree distribution of matrix
-            std::vector<int> histogram {computeDegreeDistribution(adjacencyMatrix, size)};
+            // compute degree distribution of network
+            std::vector<int> histogram {computeDegreeDistribution()};
 
             // compute correlation of degree distribution
             correlation = computeCorrelation(histogram);
 
             qInfo("correlation: %8.3f", correlation);
+
+            // fit power law to degree distribution
+            fit = computeFit(histogram);
+
+            qInfo("power law: alpha = %0.3f, xmin = %d, tail = %d, distance = %0.4f", fit.alpha, fit.xmin, fit.tailSize, fit.distance);
         }
 
         // output to log file
         stream
             << QString::number(threshold, 'f', 3) << "\t"
             << size << "\t"
-            << correlation << "\n";
+            << correlation << "\t"
+            << fit.alpha << "\t"
+            << fit.xmin << "\t"
+            << fit.distance << "\n";
 
-        // TODO: break if network is sufficently scale-free
+        // stop once network is sufficiently scale-free
+        if ( fit.tailSize >= _minTailSize && fit.distance <= _maxDistance )
+        {
+            break;
+        }
 
         // decrement threshold and fail if minimum threshold is reached
         threshold -= _thresholdStep;
@@ -135,153 +204,135 @@ void PowerLaw::initialize()
 
 
 /*!
- * Compute the row-wise maximums of a correlation matrix.
+ * Compute the sorted lists of genes and edges of the network. A gene is
+ * included in the network at a given threshold if its row-wise maximum is at
+ * least the threshold, and an edge is included if both of its genes are
+ * included and the correlation of its first cluster is at least the threshold
+ * in absolute value. Therefore the lowest threshold at which an edge is
+ * included is the minimum of its correlation and the row-wise maximums of its
+ * genes. Genes and edges which are not included at the stopping threshold are
+ * discarded, and the remaining genes and edges are sorted in descending order
+ * of the threshold at which they are included, so that the network at any
+ * threshold consists of a prefix of each list.
  *
- * @param pairs
+ * @param data
  */
-std::vector<float> PowerLaw::computeMaximums(const std::vector<RawPair>& pairs)
+void PowerLaw::computeEdges(const CompactData& data)
 {
-    EDEBUG_FUNC(this,&pairs);
+    EDEBUG_FUNC(this,&data);
 
-    // initialize elements to minimum value
-    std::vector<float> maximums(_input->geneSize(), 0);
+    // compute sorted list of genes
+    _genes.clear();
 
-    // compute maximum correlation of each row
-    for ( auto& pair : pairs )
+    for ( size_t i = 0; i < _maximums.size(); ++i )
     {
-        int i = pair.index.getX();
-
-        for ( size_t k = 0; k < pair.correlations.size(); ++k )
+        if ( _maximums[i] >= _thresholdStop )
         {
-            float correlation = fabs(pair.correlations[k]);
+            _genes.push_back(i);
+        }
+    }
 
-            if ( maximums[i] < correlation )
-            {
-                maximums[i] = correlation;
-            }
+    std::stable_sort(_genes.begin(), _genes.end(), [this] (qint32 a, qint32 b)
+    {
+        return _maximums[a] > _maximums[b];
+    });
+
+    // compute sorted list of edges
+    _edges.clear();
+
+    for ( size_t k = 0; k < data.correlations.size(); ++k )
+    {
+        Edge edge;
+        edge.x = data.x[k];
+        edge.y = data.y[k];
+        edge.key = min<float>(fabs(data.correlations[k]), min(_maximums[edge.x], _maximums[edge.y]));
+
+        if ( edge.key >= _thresholdStop )
+        {
+            _edges.push_back(edge);
         }
     }
 
-    // return row-wise maximums
-    return maximums;
+    std::stable_sort(_edges.begin(), _edges.end(), [] (const Edge& a, const Edge& b)
+    {
+        return a.key > b.key;
+    });
 }
 
 
 
 /*!
- * Compute the adjacency matrix of a correlation matrix with a given threshold.
- * This function uses the pre-computed row-wise maximums for faster computation.
- * Additionally, all zero-columns removed. The number of rows in the adjacency
- * matrix is returned as a pointer argument.
+ * Update the degree of each gene in the network as the threshold is lowered
+ * to the given threshold. Only the genes and edges which are included between
+ * the previous threshold and the given threshold are visited, and each one
+ * updates the degrees and the degree histogram in constant time. Each included
+ * gene has a degree of one for itself, which corresponds to the diagonal of
+ * the adjacency matrix. The threshold must not be raised.
  *
- * @param pairs
- * @param maximums
  * @param threshold
- * @param size
  */
-std::vector<bool> PowerLaw::computeAdjacencyMatrix(const std::vector<RawPair>& pairs, const std::vector<float>& maximums, float threshold, size_t* size)
+void PowerLaw::updateDegrees(float threshold)
 {
-    EDEBUG_FUNC(this,&pairs,&maximums,threshold,size);
-
-    // generate vector of row indices that have a correlation above threshold
-    std::vector<int> indices(_input->geneSize(), -1);
-    size_t pruneSize = 0;
+    EDEBUG_FUNC(this,threshold);
 
-    for ( size_t i = 0; i < maximums.size(); ++i )
+    // include each new gene
+    while ( _nextGene < _genes.size() && _maximums[_genes[_nextGene]] >= threshold )
     {
-        if ( maximums[i] >= threshold )
-        {
-            indices[i] = pruneSize;
-            pruneSize++;
-        }
-    }
-
-    // extract adjacency matrix from correlation matrix
-    std::vector<bool> adjacencyMatrix(pruneSize * pruneSize);
-
-    // initialize diagonal
-    for ( size_t i = 0; i < pruneSize; ++i )
-    {
-        adjacencyMatrix[i * pruneSize + i] = 1;
+        incrementDegree(_genes[_nextGene++]);
     }
 
-    // iterate through all pairs
-    for ( auto& pair : pairs )
+    // include each new edge
+    while ( _nextEdge < _edges.size() && _edges[_nextEdge].key >= threshold )
     {
-        // get indices into pruned matrix
-        int i = indices[pair.index.getX()];
-        int j = indices[pair.index.getY()];
-
-        // skip pair if it was pruned
-        if ( i == -1 || j == -1 )
-        {
-            continue;
-        }
-
-        // select correlation from pair
-        float correlation = pair.correlations[0];
+        const Edge& edge {_edges[_nextEdge++]};
 
-        // save correlation if it is above threshold
-        if ( fabs(correlation) >= threshold )
-        {
-            adjacencyMatrix[i * pruneSize + j] = 1;
-            adjacencyMatrix[j * pruneSize + i] = 1;
-        }
+        incrementDegree(edge.x);
+        incrementDegree(edge.y);
     }
-
-    // save size of adjacency matrix
-    *size = pruneSize;
-
-    // return adjacency matrix
-    return adjacencyMatrix;
 }
 
 
 
 /*!
- * Compute the degree distribution of an adjacency matrix.
+ * Increment the degree of a gene and move the gene to the next bin of the
+ * degree histogram.
  *
- * @param matrix
- * @param size
+ * @param gene
  */
-std::vector<int> PowerLaw::computeDegreeDistribution(const std::vector<bool>& matrix, size_t size)
+void PowerLaw::incrementDegree(qint32 gene)
 {
-    EDEBUG_FUNC(this,&matrix,&size);
+    EDEBUG_FUNC(this,gene);
 
-    // compute degree of each node
-    std::vector<int> degrees(size);
+    int& degree = _degrees[gene];
 
-    for ( size_t i = 0; i < size; i++ )
+    if ( degree > 0 )
     {
-        for ( size_t j = 0; j < size; j++ )
-        {
-            degrees[i] += matrix[i * size + j];
-        }
+        --_histogram[degree - 1];
     }
 
-    // compute max degree
-    int max {0};
+    ++degree;
 
-    for ( size_t i = 0; i < degrees.size(); i++ )
+    if ( _histogram.size() < static_cast<size_t>(degree) )
     {
-        if ( max < degrees[i] )
-        {
-            max = degrees[i];
-        }
+        _histogram.resize(degree, 0);
     }
 
-    // compute histogram of degrees
-    std::vector<int> histogram(max);
+    ++_histogram[degree - 1];
 
-    for ( size_t i = 0; i < degrees.size(); i++ )
-    {
-        if ( degrees[i] > 0 )
-        {
-            histogram[degrees[i] - 1]++;
-        }
-    }
+    _maxDegree = max(_maxDegree, degree);
+}
+
+
+
+/*!
+ * Return the degree distribution of the network, which is a histogram of the
+ * degree of each gene up to the maximum degree.
+ */
+std::vector<int> PowerLaw::computeDegreeDistribution() const
+{
+    EDEBUG_FUNC(this);
 
-    return histogram;
+    return std::vector<int>(_histogram.begin(), _histogram.begin() + _maxDegree);
 }
 
 
@@ -342,3 +393,209 @@ float PowerLaw::computeCorrelation(const std::vector<int>& histogram)
 
     return (n*sumxy - sumx*sumy) / sqrtf((n*sumx2 - sumx*sumx) * (n*sumy2 - sumy*sumy));
 }
+
+
+
+/*!
+ * Fit a discrete power-law distribution to a degree distribution with the
+ * method of Clauset, Shalizi and Newman. For each candidate lower bound xmin,
+ * the exponent is estimated by maximum likelihood from the degrees which are
+ * at least xmin, and the fit with the smallest Kolmogorov-Smirnov distance
+ * between the degrees and the fitted distribution is selected. Only lower
+ * bounds with at least the minimum tail size are considered. The candidates
+ * are divided among several threads. The degree distribution is a histogram
+ * in which the first element corresponds to a degree of one including the
+ * gene itself, so the degree of each gene in the network is one less than its
+ * position in the histogram and genes without edges are ignored.
+ *
+ * @param histogram
+ */
+PowerLaw::Fit PowerLaw::computeFit(const std::vector<int>& histogram)
+{
+    EDEBUG_FUNC(this,&histogram);
+
+    // determine candidate lower bounds, which are the degrees with a large
+    // enough tail
+    std::vector<int> candidates;
+    int tailSize {0};
+
+    for ( int k = static_cast<int>(histogram.size()) - 1; k >= 1; --k )
+    {
+        tailSize += histogram[k];
+
+        if ( histogram[k] > 0 && tailSize >= max(2, _minTailSize) )
+        {
+            candidates.push_back(k);
+        }
+    }
+
+    // compute the fit of each candidate
+    std::vector<Fit> fits(candidates.size());
+    int numThreads = min<int>(_numThreads, candidates.size());
+
+    if ( numThreads <= 1 )
+    {
+        for ( size_t i = 0; i < candidates.size(); ++i )
+        {
+            fits[i] = computeFitAt(histogram, candidates[i]);
+        }
+    }
+    else
+    {
+        std::vector<std::thread> threads;
+
+        for ( int t = 0; t < numThreads; ++t )
+        {
+            threads.emplace_back([this, t, numThreads, &histogram, &candidates, &fits] ()
+            {
+                for ( size_t i = t; i < candidates.size(); i += numThreads )
+                {
+                    fits[i] = computeFitAt(histogram, candidates[i]);
+                }
+            });
+        }
+
+        for ( auto& thread : threads )
+        {
+            thread.join();
+        }
+    }
+
+    // select the fit with the smallest distance, preferring the larger tail
+    Fit best;
+
+    for ( auto& fit : fits )
+    {
+        if ( fit.distance < best.distance || (fit.distance == best.distance && fit.tailSize > best.tailSize) )
+        {
+            best = fit;
+        }
+    }
+
+    return best;
+}
+
+
+
+/*!
+ * Fit a discrete power-law distribution to the degrees of a degree
+ * distribution which are at least the given lower bound. The exponent alpha
+ * maximizes the log-likelihood -n * log(zeta(alpha, xmin)) - alpha * sum(log(k)),
+ * which is concave, with a golden-section search. The Kolmogorov-Smirnov
+ * distance is the maximum difference between the empirical and the fitted
+ * cumulative distributions over the degrees in the tail.
+ *
+ * @param histogram
+ * @param xmin
+ */
+PowerLaw::Fit PowerLaw::computeFitAt(const std::vector<int>& histogram, int xmin)
+{
+    EDEBUG_FUNC(this,&histogram,xmin);
+
+    Fit fit;
+    fit.xmin = xmin;
+
+    // compute number of degrees and sum of log-degrees in the tail
+    int n {0};
+    double sumLog {0};
+
+    for ( size_t k = xmin; k < histogram.size(); ++k )
+    {
+        n += histogram[k];
+        sumLog += histogram[k] * log(static_cast<double>(k));
+    }
+
+    fit.tailSize = n;
+
+    if ( n == 0 )
+    {
+        return fit;
+    }
+
+    // estimate alpha by maximizing the log-likelihood
+    auto logLikelihood = [n, sumLog, xmin] (double alpha)
+    {
+        return -n * log(computeZeta(alpha, xmin)) - alpha * sumLog;
+    };
+
+    const double ratio {(sqrt(5.0) - 1) / 2};
+    double a {1.01};
+    double b {10.0};
+    double c {b - ratio * (b - a)};
+    double d {a + ratio * (b - a)};
+    double fc {logLikelihood(c)};
+    double fd {logLikelihood(d)};
+
+    while ( b - a > 1e-6 )
+    {
+        if ( fc > fd )
+        {
+            b = d;
+            d = c;
+            fd = fc;
+            c = b - ratio * (b - a);
+            fc = logLikelihood(c);
+        }
+        else
+        {
+            a = c;
+            c = d;
+            fc = fd;
+            d = a + ratio * (b - a);
+            fd = logLikelihood(d);
+        }
+    }
+
+    fit.alpha = (a + b) / 2;
+
+    // compute Kolmogorov-Smirnov distance, using zeta(alpha, k + 1) =
+    // zeta(alpha, k) - k^-alpha for the tail sums of the fitted distribution
+    double zetaMin {computeZeta(fit.alpha, xmin)};
+    double zeta {zetaMin};
+    int count {0};
+
+    fit.distance = 0;
+
+    for ( size_t k = xmin; k < histogram.size(); ++k )
+    {
+        zeta -= pow(static_cast<double>(k), -fit.alpha);
+        count += histogram[k];
+
+        double empirical {static_cast<double>(count) / n};
+        double model {1 - zeta / zetaMin};
+
+        fit.distance = max(fit.distance, fabs(empirical - model));
+    }
+
+    return fit;
+}
+
+
+
+/*!
+ * Compute the Hurwitz zeta function zeta(s, q), which is the sum of k^-s for
+ * k = q, q + 1, ..., for s > 1. The first terms are summed directly and the
+ * remainder is approximated with the Euler-Maclaurin formula.
+ *
+ * @param s
+ * @param q
+ */
+double PowerLaw::computeZeta(double s, double q)
+{
+    const int numTerms {10};
+    double sum {0};
+
+    for ( int i = 0; i < numTerms; ++i )
+    {
+        sum += pow(q + i, -s);
+    }
+
+    double N {q + numTerms};
+
+    sum += pow(N, 1 - s) / (s - 1);
+    sum += pow(N, -s) / 2;
+    sum += s * pow(N, -s - 1) / 12;
+    sum -= s * (s + 1) * (s + 2) * pow(N, -s - 3) / 720;
+
+    return sum;
+}
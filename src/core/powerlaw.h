@@ -23,10 +23,95 @@ public:
     virtual EAbstractAnalyticInput* makeInput() override final;
     virtual void initialize();
 private:
-    std::vector<float> computeMaximums(const std::vector<CorrelationMatrix::RawPair>& pairs);
-    std::vector<bool> computeAdjacencyMatrix(const std::vector<CorrelationMatrix::RawPair>& pairs, const std::vector<float>& maximums, float threshold, size_t* size);
-    std::vector<int> computeDegreeDistribution(const std::vector<bool>& matrix, size_t size);
+    /*!
+     * Defines an edge of the network, which consists of the genes of a pair
+     * along with the lowest threshold at which the pair is included in the
+     * network.
+     */
+    struct Edge
+    {
+        /*!
+         * The lowest threshold at which the edge is included.
+         */
+        float key;
+        /*!
+         * The row index of the pair.
+         */
+        qint32 x;
+        /*!
+         * The column index of the pair.
+         */
+        qint32 y;
+    };
+    /*!
+     * Defines a power-law fit of a degree distribution.
+     */
+    struct Fit
+    {
+        /*!
+         * The lower bound of the degrees to which the power law is fitted.
+         */
+        int xmin {0};
+        /*!
+         * The estimated exponent of the power law.
+         */
+        double alpha {0};
+        /*!
+         * The Kolmogorov-Smirnov distance between the degrees and the fitted
+         * power law.
+         */
+        double distance {1};
+        /*!
+         * The number of genes whose degree is at least the lower bound.
+         */
+        int tailSize {0};
+    };
+private:
+    void computeEdges(const CorrelationMatrix::CompactData& data);
+    void updateDegrees(float threshold);
+    void incrementDegree(qint32 gene);
+    std::vector<int> computeDegreeDistribution() const;
     float computeCorrelation(const std::vector<int>& histogram);
+    Fit computeFit(const std::vector<int>& histogram);
+    Fit computeFitAt(const std::vector<int>& histogram, int xmin);
+    static double computeZeta(double s, double q);
+    /*!
+     * The row-wise maximums of the correlation matrix, which determine the
+     * threshold at which each gene is included in the network.
+     */
+    std::vector<float> _maximums;
+    /*!
+     * The genes which are included in the network at or above the stopping
+     * threshold, sorted by the threshold at which they are included.
+     */
+    std::vector<qint32> _genes;
+    /*!
+     * The edges which are included in the network at or above the stopping
+     * threshold, sorted by the threshold at which they are included.
+     */
+    std::vector<Edge> _edges;
+    /*!
+     * The number of sorted genes which have been included in the network.
+     */
+    size_t _nextGene {0};
+    /*!
+     * The number of sorted edges which have been included in the network.
+     */
+    size_t _nextEdge {0};
+    /*!
+     * The degree of each gene in the network, including the gene itself, or
+     * zero if the gene has not been included.
+     */
+    std::vector<int> _degrees;
+    /*!
+     * The number of included genes with each degree, where the first element
+     * corresponds to a degree of one.
+     */
+    std::vector<int> _histogram;
+    /*!
+     * The maximum degree of any gene in the network.
+     */
+    int _maxDegree {0};
     /*!
      * Pointer to the input correlation matrix.
      */
@@ -48,6 +133,25 @@ private:
      * proper threshold before reaching the stopping threshold.
      */
     float _thresholdStop {0.5f};
+    /*!
+     * The maximum Kolmogorov-Smirnov distance between the degree distribution
+     * and the fitted power law for the network to be considered scale-free.
+     */
+    float _maxDistance {0.05f};
+    /*!
+     * The minimum number of genes in the tail of the degree distribution to
+     * which the power law is fitted.
+     */
+    int _minTailSize {50};
+    /*!
+     * The number of threads to use during power-law fitting.
+     */
+    int _numThreads {1};
+    /*!
+     * The path of the threshold summary file of the input correlation matrix,
+     * or an empty string if no summary was provided.
+     */
+    QString _summaryFileName;
 };
 
 
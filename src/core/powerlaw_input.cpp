@@ -46,6 +46,10 @@ EAbstractAnalyticInput::Type PowerLaw::Input::type(int index) const
     case ThresholdStart: return Type::Double;
     case ThresholdStep: return Type::Double;
     case ThresholdStop: return Type::Double;
+    case MaxDistance: return Type::Double;
+    case MinTailSize: return Type::Integer;
+    case NumThreads: return Type::Integer;
+    case SummaryFile: return Type::String;
     default: return Type::Boolean;
     }
 }
@@ -115,6 +119,48 @@ QVariant PowerLaw::Input::data(int index, Role role) const
         case Role::Maximum: return 1;
         default: return QVariant();
         }
+    case MaxDistance:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("maxks");
+        case Role::Title: return tr("Maximum KS Distance:");
+        case Role::WhatsThis: return tr("Maximum Kolmogorov-Smirnov distance between the degree distribution and the fitted power-law distribution for the network to be considered scale-free.");
+        case Role::Default: return 0.05;
+        case Role::Minimum: return 0;
+        case Role::Maximum: return 1;
+        default: return QVariant();
+        }
+    case MinTailSize:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("mintail");
+        case Role::Title: return tr("Minimum Tail Size:");
+        case Role::WhatsThis: return tr("Minimum number of genes whose degree is at least the lower bound of the fitted power-law distribution.");
+        case Role::Default: return 50;
+        case Role::Minimum: return 2;
+        case Role::Maximum: return std::numeric_limits<int>::max();
+        default: return QVariant();
+        }
+    case NumThreads:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("threads");
+        case Role::Title: return tr("Number of Threads:");
+        case Role::WhatsThis: return tr("The number of threads to use during power-law fitting.");
+        case Role::Default: return 1;
+        case Role::Minimum: return 1;
+        case Role::Maximum: return std::numeric_limits<int>::max();
+        default: return QVariant();
+        }
+    case SummaryFile:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("summary");
+        case Role::Title: return tr("Threshold Summary File:");
+        case Role::WhatsThis: return tr("Threshold summary file of the input correlation matrix, which is produced by the similarity analytic. If provided, it is used to skip the thresholds at which the network is empty and to allocate memory in advance.");
+        case Role::Default: return QString();
+        default: return QVariant();
+        }
     default: return QVariant();
     }
 }
@@ -142,6 +188,18 @@ void PowerLaw::Input::set(int index, const QVariant& value)
     case ThresholdStop:
         _base->_thresholdStop = value.toFloat();
         break;
+    case MaxDistance:
+        _base->_maxDistance = value.toFloat();
+        break;
+    case MinTailSize:
+        _base->_minTailSize = value.toInt();
+        break;
+    case NumThreads:
+        _base->_numThreads = value.toInt();
+        break;
+    case SummaryFile:
+        _base->_summaryFileName = value.toString();
+        break;
     }
 }
 
@@ -21,6 +21,10 @@ public:
         ,ThresholdStart
         ,ThresholdStep
         ,ThresholdStop
+        ,MaxDistance
+        ,MinTailSize
+        ,NumThreads
+        ,SummaryFile
         ,Total
     };
     explicit Input(PowerLaw* parent);
@@ -3,6 +3,11 @@
 #include <gsl/gsl_interp.h>
 #include <gsl/gsl_spline.h>
 #include <lapacke.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <random>
+#include <thread>
 
 #define MAJOR_VERSION KINC_MAJOR_VERSION
 #define MINOR_VERSION KINC_MINOR_VERSION
@@ -12,11 +17,13 @@
 
 #include "rmt.h"
 #include "rmt_input.h"
+#include "rmt_cache.h"
+#include "thresholdsummary.h"
 
 
 
 using namespace std;
-using RawPair = CorrelationMatrix::RawPair;
+using CompactData = CorrelationMatrix::CompactData;
 
 
 
@@ -41,6 +48,14 @@ using RawPair = CorrelationMatrix::RawPair;
 
 
 
+/*!
+ * Destroy this analytic. This destructor is defined here because the cache
+ * class is incomplete in the header.
+ */
+RMT::~RMT() = default;
+
+
+
 /*!
  * Return the total number of blocks this analytic must process as steps
  * or blocks of work.
@@ -67,86 +82,86 @@ void RMT::process(const EAbstractAnalyticBlock*)
     // initialize log text stream
     QTextStream stream(_logfile);
 
-    // initialize helper variables
-    float finalThreshold {0};
-    float finalChi {numeric_limits<float>::infinity()};
-    float maxChi {-numeric_limits<float>::infinity()};
-
-    float threshold {_thresholdStart};
-
-    // load raw correlation data, row-wise maximums
-    std::vector<RawPair> pairs {_input->dumpRawData()};
-    std::vector<float> maximums {computeMaximums(pairs)};
-
-    // continue while max chi is less than final threshold
-    while ( maxChi < _chiSquareThreshold2 )
+    // open eigenvalue cache if it was provided
+    if ( !_cacheFileName.isEmpty() )
     {
-        qInfo("\n");
-        qInfo("threshold: %0.3f", threshold);
-
-        // compute pruned matrix based on threshold
-        size_t size;
-        std::vector<float> pruneMatrix {computePruneMatrix(pairs, maximums, threshold, &size)};
-
-        qInfo("prune matrix: %lu", size);
+        QByteArray hash {_input->contentHash()};
+        qint32 reductionMethod {static_cast<qint32>(_reductionMethod)};
+        qint32 eigenSolver {static_cast<qint32>(_eigenSolver)};
 
-        // make sure that pruned matrix is not empty
-        float chi = -1;
-        std::vector<float> eigens;
+        _cache.reset(new Cache(_cacheFileName));
 
-        if ( size > 0 )
+        if ( !_cache->load(hash, reductionMethod, eigenSolver) )
         {
-            // compute eigenvalues of pruned matrix
-            eigens = computeEigenvalues(&pruneMatrix, size);
-
-            qInfo("eigenvalues: %lu", eigens.size());
-
-            // compute unique eigenvalues
-            eigens = computeUnique(eigens);
-
-            qInfo("unique eigenvalues: %lu", eigens.size());
-
-            // compute chi-squared value from NNSD of eigenvalues
-            chi = computeChiSquare(eigens);
-
-            qInfo("chi-squared: %g", chi);
-        }
-
-        // make sure that chi-squared test succeeded
-        if ( chi != -1 )
-        {
-            // save the most recent chi-squared value less than critical value
-            if ( chi < _chiSquareThreshold1 )
+            // make sure that the cache exists in statistics-only mode
+            if ( _statsOnly )
             {
-                finalChi = chi;
-                finalThreshold = threshold;
+                E_MAKE_EXCEPTION(e);
+                e.setTitle(tr("Invalid Argument"));
+                e.setDetails(tr("Eigenvalue cache %1 does not exist or does not match the input correlation matrix, reduction method and eigen solver.").arg(_cacheFileName));
+                throw e;
             }
 
-            // save the largest chi-squared value which occurs after finalChi
-            if ( finalChi < _chiSquareThreshold1 && chi > finalChi )
-            {
-                maxChi = chi;
-            }
+            _cache->create(hash, reductionMethod, eigenSolver);
         }
+    }
+
+    // load threshold summary if it was provided
+    qint64 capacity {0};
 
-        // output to log file
-        stream
-            << QString::number(threshold, 'f', 3) << "\t"
-            << size << "\t"
-            << eigens.size() << "\t"
-            << chi << "\n";
+    if ( !_summaryFileName.isEmpty() )
+    {
+        ThresholdSummary summary;
+        summary.load(_summaryFileName);
 
-        // decrement threshold and fail if minimum threshold is reached
-        threshold -= _thresholdStep;
-        if ( threshold < _thresholdStop )
+        // make sure that the summary was produced from the input correlation matrix
+        if ( summary.hash() != _input->contentHash() )
         {
             E_MAKE_EXCEPTION(e);
-            e.setTitle(tr("RMT Threshold Error"));
-            e.setDetails(tr("Could not find non-random threshold above stopping threshold."));
+            e.setTitle(tr("Invalid Argument"));
+            e.setDetails(tr("Threshold summary %1 does not match the input correlation matrix.").arg(_summaryFileName));
             throw e;
         }
+
+        // skip the thresholds at which no gene has a correlation above the
+        // threshold, since the pruned matrix is empty there
+        while ( _startIndex < numThresholds() && summary.geneCount(thresholdAt(_startIndex)) == 0 )
+        {
+            ++_startIndex;
+        }
+
+        // allocate the compact data for every pair above the stopping threshold
+        capacity = summary.edgeCount(_thresholdStop);
+    }
+
+    // load compact correlation data, save row-wise maximums and compute sorted
+    // edges, discarding pairs below the stopping threshold
+    if ( !_statsOnly )
+    {
+        CompactData data = _input->dumpCompactData(_reductionMethod, _thresholdStop, false, capacity);
+
+        _maximums = std::move(data.maximums);
+        computeEdges(data);
+    }
+
+    resetPruneMatrix();
+
+    // search for the final threshold
+    float finalThreshold {0};
+
+    switch ( _searchMethod )
+    {
+    case SearchMethod::Linear:
+        finalThreshold = searchLinear(stream);
+        break;
+    case SearchMethod::Coarse:
+        finalThreshold = searchCoarse(stream);
+        break;
     }
 
+    // release the pruned matrix buffers
+    _pruneBuffers.clear();
+
     // write threshold where chi was first above final threshold
     stream << finalThreshold << "\n";
 }
@@ -192,6 +207,15 @@ void RMT::initialize()
         throw e;
     }
 
+    // make sure coarse step is valid
+    if ( _searchMethod == SearchMethod::Coarse && _thresholdCoarseStep < _thresholdStep )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(tr("Invalid Argument"));
+        e.setDetails(tr("Threshold coarse step must be greater than or equal to threshold step."));
+        throw e;
+    }
+
     // make sure pace arguments are valid
     if ( _minSplinePace >= _maxSplinePace )
     {
@@ -201,250 +225,1503 @@ void RMT::initialize()
         throw e;
     }
 
-    // set the number of openblas threads
-    openblas_set_num_threads(_numThreads);
+    // make sure eigenvalue cache was provided in statistics-only mode
+    if ( _statsOnly && _cacheFileName.isEmpty() )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(tr("Invalid Argument"));
+        e.setDetails(tr("Statistics-only mode requires an eigenvalue cache file."));
+        throw e;
+    }
+}
+
+
+
+/*!
+ * Return the index of the lowest threshold step which is not below the
+ * stopping threshold.
+ */
+int RMT::numThresholds() const
+{
+    EDEBUG_FUNC(this);
+
+    return static_cast<int>(floor((_thresholdStart - _thresholdStop) / _thresholdStep + 1e-3f));
+}
+
+
+
+/*!
+ * Return the threshold of the threshold step with the given index.
+ *
+ * @param index
+ */
+float RMT::thresholdAt(int index) const
+{
+    EDEBUG_FUNC(this,index);
+
+    return _thresholdStart - index * _thresholdStep;
 }
 
 
 
 /*!
- * Compute the row-wise maximums of a correlation matrix.
+ * Search for the final threshold by testing every threshold step from the
+ * starting threshold until the chi-squared value rises above the final
+ * chi-squared threshold after it has been below the critical value. The final
+ * threshold is the lowest threshold whose chi-squared value was below the
+ * critical value. Threshold steps are tested concurrently in windows of the
+ * window size, but the results are processed and logged in threshold order,
+ * and the results after the stopping point are discarded, so the log file
+ * is the same as if each threshold step were tested one at a time.
  *
- * @param pairs
+ * @param stream
  */
-std::vector<float> RMT::computeMaximums(const std::vector<RawPair>& pairs)
+float RMT::searchLinear(QTextStream& stream)
 {
-    EDEBUG_FUNC(this,&pairs);
+    EDEBUG_FUNC(this,&stream);
+
+    // initialize helper variables
+    float finalThreshold {0};
+    float finalChi {numeric_limits<float>::infinity()};
+    float maxChi {-numeric_limits<float>::infinity()};
 
-    // initialize elements to minimum value
-    std::vector<float> maximums(_input->geneSize(), 0);
+    // write the thresholds which were skipped
+    writeSkipped(stream, 1);
 
-    // compute maximum correlation of each row
-    for ( auto& pair : pairs )
+    // continue while max chi is less than final threshold
+    int i {_startIndex};
+
+    while ( maxChi < _chiSquareThreshold2 )
     {
-        int i = pair.index.getX();
+        // fail if minimum threshold is reached
+        if ( i > numThresholds() )
+        {
+            E_MAKE_EXCEPTION(e);
+            e.setTitle(tr("RMT Threshold Error"));
+            e.setDetails(tr("Could not find non-random threshold above stopping threshold."));
+            throw e;
+        }
+
+        // compute chi-squared values of the next window of thresholds
+        std::vector<int> indices;
+
+        for ( ; i <= numThresholds() && static_cast<int>(indices.size()) < _windowSize; ++i )
+        {
+            indices.push_back(i);
+        }
+
+        std::vector<Evaluation> evaluations {computeEvaluations(indices)};
 
-        for ( size_t k = 0; k < pair.correlations.size(); ++k )
+        // process each threshold in order
+        for ( auto& evaluation : evaluations )
         {
-            float correlation = fabs(pair.correlations[k]);
+            float chi {evaluation.chi};
+
+            writeEvaluation(stream, evaluation);
+
+            // make sure that chi-squared test succeeded
+            if ( chi != -1 )
+            {
+                // save the most recent chi-squared value less than critical value
+                if ( chi < _chiSquareThreshold1 )
+                {
+                    finalChi = chi;
+                    finalThreshold = evaluation.threshold;
+                }
+
+                // save the largest chi-squared value which occurs after finalChi
+                if ( finalChi < _chiSquareThreshold1 && chi > finalChi )
+                {
+                    maxChi = chi;
+                }
+            }
 
-            if ( maximums[i] < correlation )
+            // discard remaining thresholds once max chi reaches the final threshold
+            if ( maxChi >= _chiSquareThreshold2 )
             {
-                maximums[i] = correlation;
+                break;
             }
         }
     }
 
-    // return row-wise maximums
-    return maximums;
+    return finalThreshold;
 }
 
 
 
 /*!
- * Compute the pruned matrix of a correlation matrix with a given threshold. This
- * function uses the pre-computed row-wise maximums for faster computation. The
- * returned matrix is equivalent to the correlation matrix with all correlations
- * below the given threshold removed, and all zero-columns removed. Additionally,
- * the number of rows in the pruned matrix is returned as a pointer argument.
+ * Search for the final threshold with a coarse-to-fine search. The coarse
+ * search is identical to the linear search except that only every coarse
+ * threshold step is tested. Once the chi-squared value rises above the final
+ * chi-squared threshold, the final threshold lies between the last coarse
+ * threshold whose chi-squared value was below the critical value and the next
+ * coarse threshold. This bracket is searched over the threshold steps to find
+ * the lowest threshold whose chi-squared value is below the critical value.
+ * Each round of the search tests a window of evenly spaced thresholds inside
+ * the bracket and shrinks the bracket to the first interval in which the
+ * chi-squared value crosses the critical value, which is a bisection if the
+ * window size is one. If the chi-squared value decreases monotonically with
+ * the threshold, the result is the same as that of the linear search, while
+ * only a few dozen thresholds are tested.
  *
- * @param pairs
- * @param maximums
- * @param threshold
- * @param size
+ * @param stream
  */
-std::vector<float> RMT::computePruneMatrix(const std::vector<RawPair>& pairs, const std::vector<float>& maximums, float threshold, size_t* size)
+float RMT::searchCoarse(QTextStream& stream)
 {
-    EDEBUG_FUNC(this,&pairs,&maximums,threshold,size);
+    EDEBUG_FUNC(this,&stream);
 
-    // generate vector of row indices that have a correlation above threshold
-    std::vector<int> indices(_input->geneSize(), -1);
-    size_t pruneSize = 0;
+    // determine the number of threshold steps in a coarse step
+    int stride {max(1, static_cast<int>(lround(_thresholdCoarseStep / _thresholdStep)))};
 
-    for ( size_t i = 0; i < maximums.size(); ++i )
-    {
-        if ( maximums[i] >= threshold )
-        {
-            indices[i] = pruneSize;
-            pruneSize++;
-        }
-    }
+    // initialize helper variables
+    int finalIndex {-1};
+    float finalChi {numeric_limits<float>::infinity()};
+    float maxChi {-numeric_limits<float>::infinity()};
 
-    // extract pruned matrix from correlation matrix
-    std::vector<float> pruneMatrix(pruneSize * pruneSize);
+    // write the coarse thresholds which were skipped
+    writeSkipped(stream, stride);
 
-    // initialize diagonal
-    for ( size_t i = 0; i < pruneSize; ++i )
-    {
-        pruneMatrix[i * pruneSize + i] = 1;
-    }
+    // perform coarse search, starting at the first coarse threshold which was
+    // not skipped so that the same thresholds are tested as without a summary
+    int next {min((_startIndex + stride - 1) / stride * stride, numThresholds())};
+    int last {next};
 
-    // iterate through all pairs
-    for ( auto& pair : pairs )
+    while ( maxChi < _chiSquareThreshold2 )
     {
-        // get indices into pruned matrix
-        int i = indices[pair.index.getX()];
-        int j = indices[pair.index.getY()];
-
-        // skip pair if it was pruned
-        if ( i == -1 || j == -1 )
+        // fail if minimum threshold is reached
+        if ( next > numThresholds() )
         {
-            continue;
+            E_MAKE_EXCEPTION(e);
+            e.setTitle(tr("RMT Threshold Error"));
+            e.setDetails(tr("Could not find non-random threshold above stopping threshold."));
+            throw e;
         }
 
-        // select correlation from pair using reduction method
-        float correlation = 0;
+        // compute chi-squared values of the next window of coarse thresholds
+        std::vector<int> indices;
 
-        switch ( _reductionMethod )
-        {
-        case ReductionMethod::First:
+        while ( next <= numThresholds() && static_cast<int>(indices.size()) < _windowSize )
         {
-            correlation = pair.correlations[0];
-            break;
+            indices.push_back(next);
+
+            next = (next < numThresholds())
+                ? min(next + stride, numThresholds())
+                : next + 1;
         }
-        case ReductionMethod::MaximumCorrelation:
+
+        std::vector<Evaluation> evaluations {computeEvaluations(indices)};
+
+        // process each threshold in order
+        for ( size_t j = 0; j < evaluations.size(); ++j )
         {
-            for ( size_t k = 0; k < pair.correlations.size(); k++ )
+            float chi {evaluations[j].chi};
+
+            writeEvaluation(stream, evaluations[j]);
+            last = indices[j];
+
+            // make sure that chi-squared test succeeded
+            if ( chi != -1 )
             {
-                float r = fabs(pair.correlations[k]);
+                // save the most recent chi-squared value less than critical value
+                if ( chi < _chiSquareThreshold1 )
+                {
+                    finalChi = chi;
+                    finalIndex = indices[j];
+                }
 
-                if ( correlation < r )
+                // save the largest chi-squared value which occurs after finalChi
+                if ( finalChi < _chiSquareThreshold1 && chi > finalChi )
                 {
-                    correlation = r;
+                    maxChi = chi;
                 }
             }
-            break;
-        }
-        case ReductionMethod::MaximumSize:
-        {
-            E_MAKE_EXCEPTION(e);
-            e.setTitle(tr("Unsupported Option"));
-            e.setDetails(tr("Pairwise reduction by maximum size is not yet supported."));
-            throw e;
+
+            // discard remaining thresholds once max chi reaches the final threshold
+            if ( maxChi >= _chiSquareThreshold2 )
+            {
+                break;
+            }
         }
-        case ReductionMethod::Random:
+    }
+
+    // search the coarse step below the final coarse threshold
+    int lo {finalIndex};
+    int hi {min(finalIndex + stride, last)};
+
+    while ( hi - lo > 1 )
+    {
+        // select evenly spaced thresholds inside the bracket
+        std::vector<int> indices;
+        int count {min(_windowSize, hi - lo - 1)};
+
+        for ( int j = 1; j <= count; ++j )
         {
-            int k = qrand() % pair.correlations.size();
-            correlation = pair.correlations[k];
-            break;
+            int index {lo + static_cast<int>(static_cast<qint64>(hi - lo) * j / (count + 1))};
+
+            if ( indices.empty() || indices.back() != index )
+            {
+                indices.push_back(index);
+            }
         }
-        };
 
-        // save correlation if it is above threshold
-        if ( fabs(correlation) >= threshold )
+        std::vector<Evaluation> evaluations {computeEvaluations(indices)};
+
+        // shrink the bracket to the first interval where the critical value is crossed
+        int newHi {hi};
+
+        for ( size_t j = 0; j < evaluations.size(); ++j )
         {
-            pruneMatrix[i * pruneSize + j] = correlation;
-            pruneMatrix[j * pruneSize + i] = correlation;
+            float chi {evaluations[j].chi};
+
+            writeEvaluation(stream, evaluations[j]);
+
+            if ( newHi != hi )
+            {
+                continue;
+            }
+
+            if ( chi != -1 && chi < _chiSquareThreshold1 )
+            {
+                lo = indices[j];
+            }
+            else
+            {
+                newHi = indices[j];
+            }
         }
-    }
 
-    // save size of pruned matrix
-    *size = pruneSize;
+        hi = newHi;
+    }
 
-    // return pruned matrix
-    return pruneMatrix;
+    return thresholdAt(lo);
 }
 
 
 
 /*!
- * Compute the eigenvalues of a correlation matrix.
+ * Compute the chi-squared values of the thresholds with the given indices,
+ * which must be in increasing order. Thresholds whose eigenvalues are in the
+ * eigenvalue cache are computed from the cached eigenvalues. For the remaining
+ * thresholds, the pruned matrix of each threshold is computed first in order
+ * of decreasing threshold so that the persistent pruned matrix only grows, and
+ * then the eigenvalues and chi-squared values of all pruned matrices are
+ * computed concurrently, with one thread for each threshold. If a CUDA device
+ * is used, the thresholds are instead computed one at a time, since the device
+ * context belongs to the main thread. Each concurrent test uses its own
+ * pruned matrix buffer, which is reused by later calls. The eigenvalues of
+ * these thresholds are then added to the eigenvalue cache in threshold order.
  *
- * @param matrix
- * @param size
+ * @param indices
  */
-std::vector<float> RMT::computeEigenvalues(std::vector<float>* matrix, size_t size)
+std::vector<RMT::Evaluation> RMT::computeEvaluations(const std::vector<int>& indices)
 {
-    EDEBUG_FUNC(this,matrix,&size);
+    EDEBUG_FUNC(this,&indices);
 
-    // initialize helper variables
-    int n = size;
-    int lda = size;
+    std::vector<Evaluation> evaluations(indices.size());
+    std::vector<size_t> pending;
 
-    // determine whether a device is available
-    if ( Ace::Settings::instance().cudaDevicePointer() )
+    // use cached eigenvalues where possible
+    for ( size_t j = 0; j < indices.size(); ++j )
     {
-        // initialize cuSOLVER handle
-        cusolverDnHandle_t cusolver_handle;
+        float threshold {thresholdAt(indices[j])};
+        const Cache::Entry* entry {_cache ? _cache->find(threshold) : nullptr};
 
-        CHECK_CUSOLVER(cusolverDnCreate(&cusolver_handle));
+        if ( entry )
+        {
+            evaluations[j].threshold = threshold;
+            evaluations[j].size = entry->size;
+            evaluations[j].eigens = entry->eigens;
 
-        // allocate device buffers
-        ::CUDA::Buffer<float> matrixBuffer(n * n);
-        ::CUDA::Buffer<float> eigensBuffer(n);
-        ::CUDA::Buffer<int> info(1);
+            computeStatistics(&evaluations[j]);
+        }
+        else if ( _statsOnly )
+        {
+            E_MAKE_EXCEPTION(e);
+            e.setTitle(tr("RMT Threshold Error"));
+            e.setDetails(tr("Threshold %1 is not in the eigenvalue cache.").arg(QString::number(threshold, 'f', 3)));
+            throw e;
+        }
+        else
+        {
+            pending.push_back(j);
+        }
+    }
 
-        // copy pruned matrix to device
-        memcpy(matrixBuffer.hostData(), matrix->data(), matrix->size() * sizeof(float));
-        matrixBuffer.write();
+    // use the main thread if there is only one threshold, only one thread,
+    // or a device is used
+    if ( pending.size() <= 1 || _numThreads <= 1 || Ace::Settings::instance().cudaDevicePointer() )
+    {
+        _pruneBuffers.resize(max<size_t>(_pruneBuffers.size(), 1));
 
-        // determine the size of the workspace
-        int lwork;
+        for ( size_t j : pending )
+        {
+            float threshold {thresholdAt(indices[j])};
 
-        CHECK_CUSOLVER(cusolverDnSsyevd_bufferSize(
-            cusolver_handle,
-            CUSOLVER_EIG_MODE_NOVECTOR,
-            CUBLAS_FILL_MODE_UPPER,
-            n, (float *)matrixBuffer.deviceData(), lda,
-            (float *)eigensBuffer.deviceData(),
-            &lwork
-        ));
+            computePruneMatrix(threshold, &_pruneBuffers[0]);
 
-        // allocate device buffer for workspace
-        ::CUDA::Buffer<float> work(lwork);
+            evaluations[j] = computeEvaluation(threshold, &_pruneBuffers[0], false);
+        }
+    }
+    else
+    {
+        // compute pruned matrix of each threshold
+        _pruneBuffers.resize(max(_pruneBuffers.size(), pending.size()));
 
-        // compute eigenvalues
-        CHECK_CUSOLVER(cusolverDnSsyevd(
-            cusolver_handle,
-            CUSOLVER_EIG_MODE_NOVECTOR,
-            CUBLAS_FILL_MODE_UPPER,
-            n, (float *)matrixBuffer.deviceData(), lda,
-            (float *)eigensBuffer.deviceData(),
-            (float *)work.deviceData(), lwork,
-            (int *)info.deviceData()
-        ));
+        for ( size_t p = 0; p < pending.size(); ++p )
+        {
+            computePruneMatrix(thresholdAt(indices[pending[p]]), &_pruneBuffers[p]);
+        }
 
-        // destroy cuSOLVER handle
-        CHECK_CUSOLVER(cusolverDnDestroy(cusolver_handle));
+        // compute chi-squared value of each threshold with a pool of threads,
+        // which is no larger than the total number of threads; the eigensolver
+        // calls of concurrent tests run in parallel, so each of them must use a
+        // single OpenBLAS thread
+        openblas_set_num_threads(1);
 
-        // copy results to host
-        std::vector<float> eigens(n);
+        int numThreads = min<int>(_numThreads, pending.size());
+        std::atomic<size_t> next {0};
+        std::vector<std::thread> threads;
+        std::vector<std::exception_ptr> errors(indices.size());
 
-        info.read().wait();
-        eigensBuffer.read().wait();
-        memcpy(eigens.data(), eigensBuffer.hostData(), eigens.size() * sizeof(float));
+        for ( int t = 0; t < numThreads; ++t )
+        {
+            threads.emplace_back([this, &next, &pending, &indices, &evaluations, &errors] ()
+            {
+                for ( size_t p = next++; p < pending.size(); p = next++ )
+                {
+                    size_t j = pending[p];
+
+                    try
+                    {
+                        evaluations[j] = computeEvaluation(thresholdAt(indices[j]), &_pruneBuffers[p], true);
+                    }
+                    catch ( ... )
+                    {
+                        errors[j] = std::current_exception();
+                    }
+                }
+            });
+        }
 
-        // print warning if cuSOLVER returned error code
-        if ( info.at(0) != 0 )
+        for ( auto& thread : threads )
         {
-            qInfo("warning: cuSOLVER ssyev returned %d", info.at(0));
+            thread.join();
         }
 
-        // return eigenvalues
-        return eigens;
+        // rethrow the first error of any thread
+        for ( auto& error : errors )
+        {
+            if ( error )
+            {
+                std::rethrow_exception(error);
+            }
+        }
     }
-    else
-    {
-        // initialize eigenvalues and workspace
-        std::vector<float> eigens(n);
-        std::vector<float> work(5 * n);
-
-        // compute eigenvalues
-        int info = LAPACKE_ssyev_work(
-            LAPACK_COL_MAJOR, 'N', 'U',
-            n, matrix->data(), lda,
-            eigens.data(),
-            work.data(), work.size());
 
-        // print warning if LAPACKE returned error code
-        if ( info != 0 )
+    // save eigenvalues of computed thresholds to cache
+    if ( _cache )
+    {
+        for ( size_t j : pending )
         {
-            qInfo("warning: LAPACKE ssyev returned %d", info);
-        }
+            Cache::Entry entry;
+            entry.threshold = evaluations[j].threshold;
+            entry.size = evaluations[j].size;
+            entry.eigens = evaluations[j].eigens;
 
-        // return eigenvalues
-        return eigens;
+            _cache->append(entry);
+        }
     }
+
+    return evaluations;
+}
+
+
+
+/*!
+ * Compute the eigenvalues and the chi-squared value of the given pruned matrix
+ * for the given threshold. The pruned matrix is overwritten.
+ *
+ * @param threshold
+ * @param pruneMatrix
+ * @param concurrent
+ */
+RMT::Evaluation RMT::computeEvaluation(float threshold, PruneMatrix* pruneMatrix, bool concurrent)
+{
+    EDEBUG_FUNC(this,threshold,pruneMatrix,concurrent);
+
+    qInfo("threshold: %0.3f, prune matrix: %lu", threshold, pruneMatrix->size);
+
+    Evaluation evaluation;
+    evaluation.threshold = threshold;
+    evaluation.size = pruneMatrix->size;
+
+    // compute eigenvalues of pruned matrix if it is not empty
+    if ( pruneMatrix->size > 0 )
+    {
+        evaluation.eigens = computeEigenvalues(pruneMatrix, concurrent);
+    }
+
+    computeStatistics(&evaluation);
+
+    return evaluation;
+}
+
+
+
+/*!
+ * Compute the number of unique eigenvalues and the chi-squared value of a
+ * tested threshold from its eigenvalues. The chi-squared value is -1 if there
+ * are not enough unique eigenvalues for the chi-squared test.
+ *
+ * @param evaluation
+ */
+void RMT::computeStatistics(Evaluation* evaluation)
+{
+    EDEBUG_FUNC(this,evaluation);
+
+    evaluation->uniqueSize = 0;
+    evaluation->chi = -1;
+
+    // make sure that pruned matrix is not empty
+    if ( evaluation->size > 0 )
+    {
+        // compute unique eigenvalues
+        std::vector<float> eigens {computeUnique(evaluation->eigens)};
+        evaluation->uniqueSize = eigens.size();
+
+        // compute chi-squared value from NNSD of eigenvalues
+        evaluation->chi = computeChiSquare(eigens);
+
+        qInfo("threshold: %0.3f, unique eigenvalues: %lu, chi-squared: %g", evaluation->threshold, eigens.size(), evaluation->chi);
+    }
+}
+
+
+
+/*!
+ * Write the result of testing a threshold to the log file.
+ *
+ * @param stream
+ * @param evaluation
+ */
+void RMT::writeEvaluation(QTextStream& stream, const Evaluation& evaluation)
+{
+    EDEBUG_FUNC(this,&stream,&evaluation);
+
+    stream
+        << QString::number(evaluation.threshold, 'f', 3) << "\t"
+        << evaluation.size << "\t"
+        << evaluation.uniqueSize << "\t"
+        << evaluation.chi << "\n";
+}
+
+
+
+/*!
+ * Write the threshold steps which were skipped because of the threshold
+ * summary to the log file, so that the log file is the same as when no
+ * summary is provided. Every threshold step which is a multiple of the given
+ * stride is written. The pruned matrix of a skipped threshold is empty, so it
+ * is written with no rows, no unique eigenvalues and a chi-squared value of -1.
+ *
+ * @param stream
+ * @param stride
+ */
+void RMT::writeSkipped(QTextStream& stream, int stride)
+{
+    EDEBUG_FUNC(this,&stream,stride);
+
+    for ( int i = 0; i < _startIndex; i += stride )
+    {
+        Evaluation evaluation;
+        evaluation.threshold = thresholdAt(i);
+        evaluation.size = 0;
+        evaluation.uniqueSize = 0;
+        evaluation.chi = -1;
+
+        qInfo("threshold: %0.3f, prune matrix: %lu, skipped", evaluation.threshold, evaluation.size);
+
+        writeEvaluation(stream, evaluation);
+    }
+}
+
+
+
+/*!
+ * Compute the sorted lists of genes and edges of the pruned matrix. A gene is
+ * included in the pruned matrix at a given threshold if its row-wise maximum
+ * is at least the threshold, and an edge is included if both of its genes are
+ * included and its reduced correlation is at least the threshold. Therefore
+ * the lowest threshold at which an edge is included is the minimum of its
+ * reduced correlation and the row-wise maximums of its genes. Genes and edges
+ * which are not included at the stopping threshold are discarded, and the
+ * remaining genes and edges are sorted in descending order of the threshold
+ * at which they are included, so that the pruned matrix at any threshold
+ * consists of a prefix of each list. The reduction method is applied once to
+ * each pair when the data is loaded, so a random reduction selects the same
+ * cluster at every threshold.
+ *
+ * @param data
+ */
+void RMT::computeEdges(const CompactData& data)
+{
+    EDEBUG_FUNC(this,&data);
+
+    const std::vector<float>& maximums = _maximums;
+
+    // compute sorted list of genes
+    _genes.clear();
+
+    for ( size_t i = 0; i < maximums.size(); ++i )
+    {
+        if ( maximums[i] >= _thresholdStop )
+        {
+            _genes.push_back(i);
+        }
+    }
+
+    std::stable_sort(_genes.begin(), _genes.end(), [&maximums] (qint32 a, qint32 b)
+    {
+        return maximums[a] > maximums[b];
+    });
+
+    // compute sorted list of edges
+    _edges.clear();
+
+    for ( size_t k = 0; k < data.correlations.size(); ++k )
+    {
+        Edge edge;
+        edge.x = data.x[k];
+        edge.y = data.y[k];
+        edge.correlation = data.correlations[k];
+        edge.key = min<float>(fabs(edge.correlation), min(maximums[edge.x], maximums[edge.y]));
+
+        if ( edge.key >= _thresholdStop )
+        {
+            _edges.push_back(edge);
+        }
+    }
+
+    std::stable_sort(_edges.begin(), _edges.end(), [] (const Edge& a, const Edge& b)
+    {
+        return a.key > b.key;
+    });
+}
+
+
+
+/*!
+ * Reset the persistent pruned matrix to an empty matrix.
+ */
+void RMT::resetPruneMatrix()
+{
+    EDEBUG_FUNC(this);
+
+    _pruneMatrix.clear();
+    _pruneEntries = std::make_shared<std::vector<SparseEntry>>();
+    _pruneSize = 0;
+    _pruneIndices.assign(_input->geneSize(), -1);
+    _nextGene = 0;
+    _nextEdge = 0;
+    _pruneThreshold = numeric_limits<float>::infinity();
+}
+
+
+
+/*!
+ * Compute the pruned matrix of a correlation matrix with a given threshold. The
+ * pruned matrix is equivalent to the correlation matrix with all correlations
+ * below the given threshold removed, and all zero-columns removed, up to a
+ * permutation of the rows and columns, which does not affect the eigenvalues.
+ * The pruned matrix is dense unless the Lanczos solver is used, in which case
+ * it is stored in sparse form and is never densified.
+ *
+ * The pruned matrix is built incrementally. When the threshold is lowered,
+ * only the genes and edges which are included between the previous threshold
+ * and the given threshold are added to the persistent pruned matrix. The
+ * persistent pruned matrix is rebuilt only if the threshold is raised. The
+ * dense form is copied from the packed lower triangle of the persistent
+ * pruned matrix into the given pruned matrix, whose memory is reused if it
+ * was used for an earlier threshold. The sparse form shares the list of
+ * elements of the persistent pruned matrix, so it is not copied at all.
+ *
+ * @param threshold
+ * @param pruneMatrix
+ */
+void RMT::computePruneMatrix(float threshold, PruneMatrix* pruneMatrix)
+{
+    EDEBUG_FUNC(this,threshold,pruneMatrix);
+
+    bool sparse {_eigenSolver == EigenSolver::Lanczos};
+
+    // rebuild the persistent pruned matrix if the threshold was raised
+    if ( threshold > _pruneThreshold )
+    {
+        resetPruneMatrix();
+    }
+
+    // append a row for each newly included gene
+    while ( _nextGene < _genes.size() && _maximums[_genes[_nextGene]] >= threshold )
+    {
+        qint32 gene = _genes[_nextGene++];
+
+        _pruneIndices[gene] = _pruneSize;
+
+        if ( !sparse )
+        {
+            _pruneMatrix.resize(_pruneMatrix.size() + _pruneSize + 1, 0);
+            _pruneMatrix.back() = 1;
+        }
+
+        ++_pruneSize;
+    }
+
+    // save each newly included edge
+    while ( _nextEdge < _edges.size() && _edges[_nextEdge].key >= threshold )
+    {
+        const Edge& edge {_edges[_nextEdge++]};
+
+        qint32 i = _pruneIndices[edge.x];
+        qint32 j = _pruneIndices[edge.y];
+
+        if ( i < j )
+        {
+            swap(i, j);
+        }
+
+        if ( sparse )
+        {
+            _pruneEntries->push_back({ i, j, edge.correlation });
+        }
+        else
+        {
+            _pruneMatrix[static_cast<size_t>(i) * (i + 1) / 2 + j] = edge.correlation;
+        }
+    }
+
+    _pruneThreshold = threshold;
+
+    // copy the persistent pruned matrix to the given pruned matrix
+    pruneMatrix->size = _pruneSize;
+    pruneMatrix->sparse = sparse;
+
+    if ( sparse )
+    {
+        pruneMatrix->values.clear();
+        pruneMatrix->entries = _pruneEntries;
+        pruneMatrix->entrySize = _pruneEntries->size();
+    }
+    else
+    {
+        pruneMatrix->values.assign(_pruneMatrix.begin(), _pruneMatrix.end());
+        pruneMatrix->entries.reset();
+        pruneMatrix->entrySize = 0;
+    }
+}
+
+
+
+/*!
+ * Compute the eigenvalues of a pruned matrix. The matrix is block diagonal
+ * up to a permutation of its rows and columns, with one block for each
+ * connected component of the network, and its eigenvalues are the union of the
+ * eigenvalues of each block. Blocks with one or two rows are solved in closed
+ * form, and the remaining blocks are solved independently. If other
+ * thresholds are tested concurrently, OpenBLAS is already limited to one
+ * thread, and the blocks are solved in parallel by this test's share of the
+ * threads. Otherwise the largest block is solved first with every OpenBLAS
+ * thread, and the remaining blocks are solved in parallel by every thread
+ * with one OpenBLAS thread each. The returned eigenvalues are sorted in
+ * ascending order. The matrix is overwritten.
+ *
+ * @param matrix
+ * @param concurrent
+ */
+std::vector<float> RMT::computeEigenvalues(PruneMatrix* matrix, bool concurrent)
+{
+    EDEBUG_FUNC(this,matrix,concurrent);
+
+    size_t size = matrix->size;
+    bool useDevice = !matrix->sparse && Ace::Settings::instance().cudaDevicePointer();
+
+    // find connected components of matrix
+    std::vector<std::vector<qint32>> components {computeComponents(*matrix)};
+
+    // solve the whole matrix directly if it is connected
+    if ( components.size() == 1 && size > 2 )
+    {
+        if ( !concurrent )
+        {
+            openblas_set_num_threads(_numThreads);
+        }
+
+        return computeBlockEigenvalues(matrix);
+    }
+
+    // extract the block of each component with more than one row
+    std::vector<PruneMatrix> componentBlocks {extractBlocks(*matrix, components)};
+
+    // solve blocks with one or two rows in closed form, using the fact that
+    // the diagonal of a pruned matrix is 1, and keep the remaining blocks
+    std::vector<float> eigens;
+    std::vector<PruneMatrix> blocks;
+
+    eigens.reserve(size);
+
+    for ( auto& component : components )
+    {
+        if ( component.size() == 1 )
+        {
+            eigens.push_back(1);
+        }
+    }
+
+    for ( auto& block : componentBlocks )
+    {
+        if ( block.size == 2 )
+        {
+            float b {0};
+
+            if ( block.sparse )
+            {
+                b = (block.entrySize > 0) ? (*block.entries)[0].value : 0;
+            }
+            else
+            {
+                b = block.values[1];
+            }
+
+            eigens.push_back(1 - fabs(b));
+            eigens.push_back(1 + fabs(b));
+        }
+        else
+        {
+            blocks.push_back(std::move(block));
+        }
+    }
+
+    // solve the largest block first with every OpenBLAS thread if this is the
+    // only test, and then the remaining blocks with one OpenBLAS thread each
+    std::vector<std::vector<float>> blockEigens(blocks.size());
+    size_t first {0};
+
+    if ( !concurrent && !useDevice && !blocks.empty() )
+    {
+        auto largest = std::max_element(blocks.begin(), blocks.end(), [] (const PruneMatrix& a, const PruneMatrix& b)
+        {
+            return a.size < b.size;
+        });
+
+        std::swap(blocks.front(), *largest);
+
+        openblas_set_num_threads(_numThreads);
+        blockEigens[0] = computeBlockEigenvalues(&blocks[0]);
+        openblas_set_num_threads(1);
+
+        first = 1;
+    }
+
+    // solve the remaining blocks, using one thread for each block if there are
+    // several blocks and no device is used; the threads are divided among the
+    // concurrent tests so that their total does not exceed the thread count
+    int numThreads = min<int>(concurrent ? max(1, _numThreads / _windowSize) : _numThreads, blocks.size() - first);
+
+    if ( numThreads <= 1 || useDevice )
+    {
+        for ( size_t k = first; k < blocks.size(); ++k )
+        {
+            blockEigens[k] = computeBlockEigenvalues(&blocks[k]);
+        }
+    }
+    else
+    {
+        std::atomic<size_t> next {first};
+        std::vector<std::thread> threads;
+        std::vector<std::exception_ptr> errors(numThreads);
+
+        for ( int t = 0; t < numThreads; ++t )
+        {
+            threads.emplace_back([this, t, &next, &blocks, &blockEigens, &errors] ()
+            {
+                try
+                {
+                    for ( size_t k = next++; k < blocks.size(); k = next++ )
+                    {
+                        blockEigens[k] = computeBlockEigenvalues(&blocks[k]);
+                    }
+                }
+                catch ( ... )
+                {
+                    errors[t] = std::current_exception();
+                }
+            });
+        }
+
+        for ( auto& thread : threads )
+        {
+            thread.join();
+        }
+
+        // rethrow the first error of any thread
+        for ( auto& error : errors )
+        {
+            if ( error )
+            {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    // merge eigenvalues of all blocks
+    for ( auto& values : blockEigens )
+    {
+        eigens.insert(eigens.end(), values.begin(), values.end());
+    }
+
+    std::sort(eigens.begin(), eigens.end());
+
+    return eigens;
+}
+
+
+
+/*!
+ * Find the connected components of the network represented by a pruned
+ * matrix, in which two genes are connected if their correlation is non-zero.
+ * Each component is returned as a list of row indices in increasing order, and
+ * the components are ordered by their lowest row index.
+ *
+ * @param matrix
+ */
+std::vector<std::vector<qint32>> RMT::computeComponents(const PruneMatrix& matrix)
+{
+    EDEBUG_FUNC(this,&matrix);
+
+    size_t size = matrix.size;
+
+    // initialize disjoint sets
+    std::vector<qint32> parents(size);
+    std::vector<qint32> ranks(size, 0);
+
+    for ( size_t i = 0; i < size; ++i )
+    {
+        parents[i] = i;
+    }
+
+    auto find = [&parents] (qint32 i)
+    {
+        while ( parents[i] != i )
+        {
+            parents[i] = parents[parents[i]];
+            i = parents[i];
+        }
+
+        return i;
+    };
+
+    auto merge = [&parents, &ranks, &find] (qint32 i, qint32 j)
+    {
+        qint32 a = find(i);
+        qint32 b = find(j);
+
+        if ( a == b )
+        {
+            return;
+        }
+
+        if ( ranks[a] < ranks[b] )
+        {
+            swap(a, b);
+        }
+
+        parents[b] = a;
+
+        if ( ranks[a] == ranks[b] )
+        {
+            ++ranks[a];
+        }
+    };
+
+    // merge the sets of each pair of connected genes
+    if ( matrix.sparse )
+    {
+        for ( size_t k = 0; k < matrix.entrySize; ++k )
+        {
+            const SparseEntry& entry {(*matrix.entries)[k]};
+
+            if ( entry.value != 0 )
+            {
+                merge(entry.row, entry.column);
+            }
+        }
+    }
+    else
+    {
+        for ( size_t i = 0; i < size; ++i )
+        {
+            const float* row = &matrix.values[i * (i + 1) / 2];
+
+            for ( size_t j = 0; j < i; ++j )
+            {
+                if ( row[j] != 0 )
+                {
+                    merge(i, j);
+                }
+            }
+        }
+    }
+
+    // collect the rows of each component
+    std::vector<std::vector<qint32>> components;
+    std::vector<qint32> componentIndices(size, -1);
+
+    for ( size_t i = 0; i < size; ++i )
+    {
+        qint32 root = find(i);
+
+        if ( componentIndices[root] == -1 )
+        {
+            componentIndices[root] = components.size();
+            components.emplace_back();
+        }
+
+        components[componentIndices[root]].push_back(i);
+    }
+
+    return components;
+}
+
+
+
+/*!
+ * Extract the block of a pruned matrix which consists of the rows and columns
+ * of each connected component with more than one row, in the order of the
+ * components. Each block has the same form as the pruned matrix. Since each
+ * component lists its rows in increasing order, the lower triangle of a block
+ * comes from the lower triangle of the pruned matrix. The elements of a sparse
+ * matrix are distributed to their blocks in a single pass.
+ *
+ * @param matrix
+ * @param components
+ */
+std::vector<RMT::PruneMatrix> RMT::extractBlocks(const PruneMatrix& matrix, const std::vector<std::vector<qint32>>& components)
+{
+    EDEBUG_FUNC(this,&matrix,&components);
+
+    // determine the block and the local index of each row
+    std::vector<PruneMatrix> blocks;
+    std::vector<qint32> blockIndices(matrix.size, -1);
+    std::vector<qint32> localIndices(matrix.size, -1);
+
+    for ( auto& component : components )
+    {
+        if ( component.size() < 2 )
+        {
+            continue;
+        }
+
+        for ( size_t i = 0; i < component.size(); ++i )
+        {
+            blockIndices[component[i]] = blocks.size();
+            localIndices[component[i]] = i;
+        }
+
+        PruneMatrix block;
+        block.size = component.size();
+        block.sparse = matrix.sparse;
+
+        blocks.push_back(std::move(block));
+    }
+
+    if ( matrix.sparse )
+    {
+        // distribute the elements of the matrix to their blocks
+        std::vector<std::shared_ptr<std::vector<SparseEntry>>> entries(blocks.size());
+
+        for ( size_t b = 0; b < blocks.size(); ++b )
+        {
+            entries[b] = std::make_shared<std::vector<SparseEntry>>();
+        }
+
+        for ( size_t k = 0; k < matrix.entrySize; ++k )
+        {
+            const SparseEntry& entry {(*matrix.entries)[k]};
+            qint32 b = blockIndices[entry.row];
+
+            if ( entry.value == 0 )
+            {
+                continue;
+            }
+
+            entries[b]->push_back({ localIndices[entry.row], localIndices[entry.column], entry.value });
+        }
+
+        for ( size_t b = 0; b < blocks.size(); ++b )
+        {
+            blocks[b].entrySize = entries[b]->size();
+            blocks[b].entries = std::move(entries[b]);
+        }
+    }
+    else
+    {
+        // copy the lower triangle of each block
+        size_t b = 0;
+
+        for ( auto& component : components )
+        {
+            if ( component.size() < 2 )
+            {
+                continue;
+            }
+
+            PruneMatrix& block {blocks[b++]};
+            size_t n = component.size();
+
+            block.values.resize(n * (n + 1) / 2);
+
+            for ( size_t i = 0; i < n; ++i )
+            {
+                const float* row = &matrix.values[static_cast<size_t>(component[i]) * (component[i] + 1) / 2];
+
+                for ( size_t j = 0; j <= i; ++j )
+                {
+                    block.values[i * (i + 1) / 2 + j] = row[component[j]];
+                }
+            }
+        }
+    }
+
+    return blocks;
+}
+
+
+
+/*!
+ * Compute the eigenvalues of a connected block of a pruned matrix with the
+ * selected eigensolver. The returned eigenvalues are sorted in ascending
+ * order. The block is overwritten.
+ *
+ * @param block
+ */
+std::vector<float> RMT::computeBlockEigenvalues(PruneMatrix* block)
+{
+    EDEBUG_FUNC(this,block);
+
+    if ( block->sparse )
+    {
+        return computeLanczosEigenvalues(*block);
+    }
+
+    return computeDenseEigenvalues(&block->values, block->size);
+}
+
+
+
+/*!
+ * Compute the eigenvalues of a dense symmetric matrix, which is given as its
+ * packed lower triangle, with a single solver call. The CUDA device is used if
+ * it is available, in which case the matrix is unpacked into the device
+ * buffer. Otherwise the packed LAPACK driver which corresponds to the
+ * selected solver is used with an optimally sized workspace, so that the
+ * matrix is never stored in full. This function may be called by several
+ * threads at once, in which case OpenBLAS must be limited to one thread. The
+ * returned eigenvalues are sorted in ascending order. The matrix is
+ * overwritten.
+ *
+ * @param matrix
+ * @param size
+ */
+std::vector<float> RMT::computeDenseEigenvalues(std::vector<float>* matrix, size_t size)
+{
+    EDEBUG_FUNC(this,matrix,size);
+
+    // initialize helper variables
+    int n = size;
+    int lda = size;
+
+    // determine whether a device is available
+    if ( Ace::Settings::instance().cudaDevicePointer() )
+    {
+        // initialize cuSOLVER handle
+        cusolverDnHandle_t cusolver_handle;
+
+        CHECK_CUSOLVER(cusolverDnCreate(&cusolver_handle));
+
+        // allocate device buffers
+        ::CUDA::Buffer<float> matrixBuffer(n * n);
+        ::CUDA::Buffer<float> eigensBuffer(n);
+        ::CUDA::Buffer<int> info(1);
+
+        // unpack pruned matrix and copy it to device
+        float* full = matrixBuffer.hostData();
+
+        for ( size_t i = 0; i < size; ++i )
+        {
+            const float* row = &(*matrix)[i * (i + 1) / 2];
+
+            for ( size_t j = 0; j <= i; ++j )
+            {
+                full[i * size + j] = row[j];
+                full[j * size + i] = row[j];
+            }
+        }
+
+        matrixBuffer.write();
+
+        // determine the size of the workspace
+        int lwork;
+
+        CHECK_CUSOLVER(cusolverDnSsyevd_bufferSize(
+            cusolver_handle,
+            CUSOLVER_EIG_MODE_NOVECTOR,
+            CUBLAS_FILL_MODE_UPPER,
+            n, (float *)matrixBuffer.deviceData(), lda,
+            (float *)eigensBuffer.deviceData(),
+            &lwork
+        ));
+
+        // allocate device buffer for workspace
+        ::CUDA::Buffer<float> work(lwork);
+
+        // compute eigenvalues
+        CHECK_CUSOLVER(cusolverDnSsyevd(
+            cusolver_handle,
+            CUSOLVER_EIG_MODE_NOVECTOR,
+            CUBLAS_FILL_MODE_UPPER,
+            n, (float *)matrixBuffer.deviceData(), lda,
+            (float *)eigensBuffer.deviceData(),
+            (float *)work.deviceData(), lwork,
+            (int *)info.deviceData()
+        ));
+
+        // destroy cuSOLVER handle
+        CHECK_CUSOLVER(cusolverDnDestroy(cusolver_handle));
+
+        // copy results to host
+        std::vector<float> eigens(n);
+
+        info.read().wait();
+        eigensBuffer.read().wait();
+        memcpy(eigens.data(), eigensBuffer.hostData(), eigens.size() * sizeof(float));
+
+        // print warning if cuSOLVER returned error code
+        if ( info.at(0) != 0 )
+        {
+            qInfo("warning: cuSOLVER ssyev returned %d", info.at(0));
+        }
+
+        // return eigenvalues
+        return eigens;
+    }
+
+    // initialize eigenvalues and workspace query; the packed lower triangle
+    // in row order is the packed upper triangle in column order
+    std::vector<float> eigens(n);
+    int info {0};
+
+    switch ( _eigenSolver )
+    {
+    case EigenSolver::Ssyev:
+    {
+        std::vector<float> work(max(1, 3 * n));
+
+        // compute eigenvalues with the QR algorithm
+        info = LAPACKE_sspev_work(
+            LAPACK_COL_MAJOR, 'N', 'U',
+            n, matrix->data(),
+            eigens.data(),
+            nullptr, 1,
+            work.data());
+        break;
+    }
+    case EigenSolver::Ssyevd:
+    case EigenSolver::Lanczos:
+    {
+        float workSize {0};
+        lapack_int iworkSize {0};
+
+        // query workspace sizes
+        LAPACKE_sspevd_work(
+            LAPACK_COL_MAJOR, 'N', 'U',
+            n, matrix->data(),
+            eigens.data(),
+            nullptr, 1,
+            &workSize, -1,
+            &iworkSize, -1);
+
+        std::vector<float> work(max(1, static_cast<int>(workSize)));
+        std::vector<lapack_int> iwork(max<lapack_int>(1, iworkSize));
+
+        // compute eigenvalues with the divide-and-conquer algorithm
+        info = LAPACKE_sspevd_work(
+            LAPACK_COL_MAJOR, 'N', 'U',
+            n, matrix->data(),
+            eigens.data(),
+            nullptr, 1,
+            work.data(), work.size(),
+            iwork.data(), iwork.size());
+        break;
+    }
+    case EigenSolver::Ssyevr:
+    {
+        lapack_int numEigens {0};
+        float abstol {LAPACKE_slamch('S')};
+        std::vector<float> work(max(1, 8 * n));
+        std::vector<lapack_int> iwork(max(1, 5 * n));
+        std::vector<lapack_int> ifail(max(1, n));
+
+        // compute eigenvalues with the bisection algorithm
+        info = LAPACKE_sspevx_work(
+            LAPACK_COL_MAJOR, 'N', 'A', 'U',
+            n, matrix->data(),
+            0, 0, 0, 0, abstol,
+            &numEigens, eigens.data(),
+            nullptr, 1,
+            work.data(), iwork.data(), ifail.data());
+
+        eigens.resize(numEigens);
+        break;
+    }
+    }
+
+    // print warning if LAPACKE returned error code
+    if ( info != 0 )
+    {
+        qInfo("warning: LAPACKE eigensolver returned %d", info);
+    }
+
+    // return eigenvalues
+    return eigens;
+}
+
+
+
+/*!
+ * Compute the eigenvalues of a sparse symmetric matrix with the Lanczos
+ * algorithm of Cullum and Willoughby, without densifying the matrix. The
+ * Lanczos vectors are not reorthogonalized, so only the current and previous
+ * Lanczos vectors are kept and the memory usage is linear in the size of the
+ * matrix and the number of steps, and no eigenvectors are computed. Because
+ * the Lanczos vectors lose orthogonality, the tridiagonal matrix has extra
+ * copies of converged eigenvalues and spurious eigenvalues, which are removed
+ * by computeLanczosGoodEigenvalues(). The good eigenvalues are computed after
+ * a number of steps which doubles at each check, and the recurrence stops
+ * once they are the same at two consecutive checks, when it reaches an
+ * invariant subspace, which is detected when the norm of the next Lanczos
+ * vector vanishes, or after a maximum number of steps. Since the Lanczos
+ * algorithm finds only one copy of each eigenvalue, the result is the unique
+ * eigenvalues of the matrix, which is sufficient since only the unique
+ * eigenvalues are used by the chi-squared test. The returned eigenvalues are
+ * sorted in ascending order.
+ *
+ * @param matrix
+ */
+std::vector<float> RMT::computeLanczosEigenvalues(const PruneMatrix& matrix)
+{
+    EDEBUG_FUNC(this,&matrix);
+
+    size_t n = matrix.size;
+
+    // initialize starting vector with a fixed seed so that results are reproducible
+    std::vector<double> u(n, 0);
+    std::vector<double> v(n);
+    std::vector<double> w(n);
+    std::minstd_rand generator(n);
+    std::uniform_real_distribution<double> distribution(-1, 1);
+
+    double norm {0};
+
+    for ( size_t i = 0; i < n; ++i )
+    {
+        v[i] = distribution(generator);
+        norm += v[i] * v[i];
+    }
+
+    norm = sqrt(norm);
+
+    for ( size_t i = 0; i < n; ++i )
+    {
+        v[i] /= norm;
+    }
+
+    // perform the Lanczos recurrence, in which u is the previous Lanczos vector
+    // and v is the current Lanczos vector
+    std::vector<double> alphas;
+    std::vector<double> betas;
+    std::vector<double> eigens;
+    std::vector<double> previousEigens;
+    double normT {0};
+    double beta {0};
+    size_t maxSteps {static_cast<size_t>(LANCZOS_MAX_STEPS) * n};
+    size_t nextCheck {min(static_cast<size_t>(LANCZOS_FIRST_CHECK), maxSteps)};
+    bool converged {false};
+
+    for ( size_t step = 0; step < maxSteps; ++step )
+    {
+        // compute w = A * v - beta * u from the unit diagonal and the lower
+        // triangle; BLAS is not used since this function runs in several threads
+        for ( size_t i = 0; i < n; ++i )
+        {
+            w[i] = v[i] - beta * u[i];
+        }
+
+        for ( size_t k = 0; k < matrix.entrySize; ++k )
+        {
+            const SparseEntry& entry {(*matrix.entries)[k]};
+
+            w[entry.row] += entry.value * v[entry.column];
+            w[entry.column] += entry.value * v[entry.row];
+        }
+
+        // remove the component of w along v
+        double alpha {0};
+
+        for ( size_t i = 0; i < n; ++i )
+        {
+            alpha += w[i] * v[i];
+        }
+
+        norm = 0;
+
+        for ( size_t i = 0; i < n; ++i )
+        {
+            w[i] -= alpha * v[i];
+            norm += w[i] * w[i];
+        }
+
+        double nextBeta {sqrt(norm)};
+
+        normT = max(normT, beta + fabs(alpha) + nextBeta);
+        alphas.push_back(alpha);
+
+        // compute the good eigenvalues at each check and stop if they have
+        // converged or if an invariant subspace was found, in which case the
+        // norm of the next Lanczos vector is only the rounding error of the
+        // matrix product, which grows with the square root of its size
+        double tolerance {LANCZOS_TOLERANCE * (step + 1) * numeric_limits<double>::epsilon() * max(1.0, normT)};
+        bool breakdown {nextBeta <= tolerance * sqrt(static_cast<double>(n))};
+
+        if ( breakdown || alphas.size() >= nextCheck )
+        {
+            eigens = computeLanczosGoodEigenvalues(alphas, betas, tolerance);
+
+            bool same {eigens.size() == previousEigens.size()};
+
+            for ( size_t i = 0; same && i < eigens.size(); ++i )
+            {
+                same = fabs(eigens[i] - previousEigens[i]) <= tolerance;
+            }
+
+            if ( breakdown || same )
+            {
+                converged = true;
+                break;
+            }
+
+            previousEigens = eigens;
+            nextCheck = min(2 * nextCheck, maxSteps);
+        }
+
+        betas.push_back(nextBeta);
+
+        // advance to the next Lanczos vector
+        std::swap(u, v);
+
+        for ( size_t i = 0; i < n; ++i )
+        {
+            v[i] = w[i] / nextBeta;
+        }
+
+        beta = nextBeta;
+    }
+
+    if ( !converged )
+    {
+        qInfo("warning: Lanczos eigenvalues did not converge after %zu steps", maxSteps);
+    }
+
+    return std::vector<float>(eigens.begin(), eigens.end());
+}
+
+
+
+/*!
+ * Compute the good eigenvalues of the Lanczos tridiagonal matrix with the
+ * given diagonal and off-diagonal, using the test of Cullum and Willoughby.
+ * Eigenvalues which are equal within the given tolerance are copies of one
+ * eigenvalue, which is kept once. An eigenvalue with only one copy is
+ * spurious if it is also an eigenvalue of the tridiagonal matrix without its
+ * first row and column, in which case it is discarded. Only eigenvalues are
+ * computed, so the memory usage is linear in the number of Lanczos steps. The
+ * returned eigenvalues are sorted in ascending order.
+ *
+ * @param alphas
+ * @param betas
+ * @param tolerance
+ */
+std::vector<double> RMT::computeLanczosGoodEigenvalues(const std::vector<double>& alphas, const std::vector<double>& betas, double tolerance)
+{
+    EDEBUG_FUNC(this,&alphas,&betas,tolerance);
+
+    size_t m = alphas.size();
+
+    // compute eigenvalues of the tridiagonal matrix
+    std::vector<double> thetas {alphas};
+    std::vector<double> offDiagonal(betas.begin(), betas.begin() + (m - 1));
+
+    int info = LAPACKE_dstev(LAPACK_COL_MAJOR, 'N', m, thetas.data(), offDiagonal.data(), nullptr, 1);
+
+    if ( info != 0 )
+    {
+        qInfo("warning: LAPACKE dstev returned %d", info);
+    }
+
+    // compute eigenvalues of the tridiagonal matrix without its first row and column
+    std::vector<double> hats;
+
+    if ( m > 1 )
+    {
+        hats.assign(alphas.begin() + 1, alphas.end());
+        offDiagonal.assign(betas.begin() + 1, betas.begin() + (m - 1));
+
+        info = LAPACKE_dstev(LAPACK_COL_MAJOR, 'N', m - 1, hats.data(), offDiagonal.data(), nullptr, 1);
+
+        if ( info != 0 )
+        {
+            qInfo("warning: LAPACKE dstev returned %d", info);
+        }
+    }
+
+    // keep one copy of each eigenvalue unless it is spurious
+    std::vector<double> eigens;
+
+    for ( size_t i = 0; i < m; )
+    {
+        size_t j {i + 1};
+
+        while ( j < m && thetas[j] - thetas[j - 1] <= tolerance )
+        {
+            ++j;
+        }
+
+        bool spurious {false};
+
+        if ( j - i == 1 )
+        {
+            auto iter = std::lower_bound(hats.begin(), hats.end(), thetas[i] - tolerance);
+
+            spurious = (iter != hats.end() && *iter <= thetas[i] + tolerance);
+        }
+
+        if ( !spurious )
+        {
+            eigens.push_back(thetas[i]);
+        }
+
+        i = j;
+    }
+
+    return eigens;
 }
 
 
@@ -2,6 +2,7 @@
 #define RMT_H
 #include <ace/core/core.h>
 #include "correlationmatrix.h"
+#include <memory>
 
 
 
@@ -23,42 +24,251 @@ class RMT : public EAbstractAnalytic
     Q_OBJECT
 public:
     class Input;
+    class Cache;
+    virtual ~RMT();
     virtual int size() const override final;
     virtual void process(const EAbstractAnalyticBlock* result) override final;
     virtual EAbstractAnalyticInput* makeInput() override final;
     virtual void initialize();
 private:
     /*!
-     * Defines the reduction methods this analytic supports.
+     * Defines the threshold search methods this analytic supports.
      */
-    enum class ReductionMethod
+    enum class SearchMethod
     {
         /*!
-         * Select the first cluster
+         * Test every threshold step
          */
-        First
+        Linear
         /*!
-         * Select the cluster with the highest absolute correlation
+         * Test every coarse threshold step and bisect the crossing
          */
-        ,MaximumCorrelation
+        ,Coarse
+    };
+    /*!
+     * Defines the eigensolvers this analytic supports.
+     */
+    enum class EigenSolver
+    {
+        /*!
+         * Dense QR algorithm (LAPACK sspev, the packed form of ssyev)
+         */
+        Ssyev
+        /*!
+         * Dense divide-and-conquer algorithm (LAPACK sspevd, the packed form of ssyevd)
+         */
+        ,Ssyevd
+        /*!
+         * Dense bisection algorithm (LAPACK sspevx, the packed counterpart of ssyevr)
+         */
+        ,Ssyevr
+        /*!
+         * Sparse Lanczos algorithm on the sparse form of the pruned matrix
+         */
+        ,Lanczos
+    };
+    /*!
+     * Defines an off-diagonal element of the lower triangle of a sparse
+     * pruned matrix.
+     */
+    struct SparseEntry
+    {
+        /*!
+         * The row index of the element, which is greater than its column index.
+         */
+        qint32 row;
+        /*!
+         * The column index of the element.
+         */
+        qint32 column;
+        /*!
+         * The value of the element.
+         */
+        float value;
+    };
+    /*!
+     * Defines a pruned matrix, which is stored either as the packed lower
+     * triangle of a dense matrix or as a list of the non-zero elements of the
+     * lower triangle of a sparse matrix. The diagonal elements of a sparse
+     * matrix are always 1 and are not stored.
+     */
+    struct PruneMatrix
+    {
+        /*!
+         * The number of rows in the matrix.
+         */
+        size_t size {0};
+        /*!
+         * Whether the matrix is stored in sparse form.
+         */
+        bool sparse {false};
+        /*!
+         * The lower triangle of a dense matrix, stored row by row, which is
+         * the upper triangle in column-major packed storage used by LAPACK.
+         */
+        std::vector<float> values;
+        /*!
+         * The list of off-diagonal elements of a sparse matrix. The list may
+         * be shared with the persistent pruned matrix and may be longer than
+         * the matrix, in which case only the first elements belong to it.
+         */
+        std::shared_ptr<const std::vector<SparseEntry>> entries;
+        /*!
+         * The number of elements of the list which belong to a sparse matrix.
+         */
+        size_t entrySize {0};
+    };
+    /*!
+     * Defines the result of testing a threshold.
+     */
+    struct Evaluation
+    {
+        /*!
+         * The threshold.
+         */
+        float threshold;
+        /*!
+         * The number of rows in the pruned matrix.
+         */
+        size_t size;
+        /*!
+         * The number of unique eigenvalues of the pruned matrix.
+         */
+        size_t uniqueSize;
+        /*!
+         * The chi-squared value, or -1 if the chi-squared test was skipped.
+         */
+        float chi;
+        /*!
+         * The sorted eigenvalues of the pruned matrix.
+         */
+        std::vector<float> eigens;
+    };
+    /*!
+     * Defines an edge of the pruned matrix, which is the reduced correlation
+     * of a pair along with the lowest threshold at which the pair is included
+     * in the pruned matrix.
+     */
+    struct Edge
+    {
+        /*!
+         * The lowest threshold at which the edge is included.
+         */
+        float key;
         /*!
-         * Select the cluster with the largest sample size
+         * The reduced correlation of the pair.
          */
-        ,MaximumSize
+        float correlation;
         /*!
-         * Select a random cluster
+         * The row index of the pair.
          */
-        ,Random
+        qint32 x;
+        /*!
+         * The column index of the pair.
+         */
+        qint32 y;
     };
 private:
-    std::vector<float> computeMaximums(const std::vector<CorrelationMatrix::RawPair>& pairs);
-    std::vector<float> computePruneMatrix(const std::vector<CorrelationMatrix::RawPair>& pairs, const std::vector<float>& maximums, float threshold, size_t* size);
-    std::vector<float> computeEigenvalues(std::vector<float>* pruneMatrix, size_t size);
+    int numThresholds() const;
+    float thresholdAt(int index) const;
+    float searchLinear(QTextStream& stream);
+    float searchCoarse(QTextStream& stream);
+    std::vector<Evaluation> computeEvaluations(const std::vector<int>& indices);
+    Evaluation computeEvaluation(float threshold, PruneMatrix* pruneMatrix, bool concurrent);
+    void computeStatistics(Evaluation* evaluation);
+    void writeEvaluation(QTextStream& stream, const Evaluation& evaluation);
+    void writeSkipped(QTextStream& stream, int stride);
+    void computeEdges(const CorrelationMatrix::CompactData& data);
+    void resetPruneMatrix();
+    void computePruneMatrix(float threshold, PruneMatrix* pruneMatrix);
+    std::vector<float> computeEigenvalues(PruneMatrix* matrix, bool concurrent);
+    std::vector<std::vector<qint32>> computeComponents(const PruneMatrix& matrix);
+    std::vector<PruneMatrix> extractBlocks(const PruneMatrix& matrix, const std::vector<std::vector<qint32>>& components);
+    std::vector<float> computeBlockEigenvalues(PruneMatrix* block);
+    std::vector<float> computeDenseEigenvalues(std::vector<float>* matrix, size_t size);
+    std::vector<float> computeLanczosEigenvalues(const PruneMatrix& matrix);
+    std::vector<double> computeLanczosGoodEigenvalues(const std::vector<double>& alphas, const std::vector<double>& betas, double tolerance);
     std::vector<float> computeUnique(const std::vector<float>& values);
     float computeChiSquare(const std::vector<float>& eigens);
     float computeChiSquareHelper(const std::vector<float>& values);
     std::vector<float> computeSpline(const std::vector<float>& values, int pace);
     std::vector<float> computeSpacings(const std::vector<float>& values);
+    /*!
+     * The tolerance, in multiples of the machine epsilon per Lanczos step, used
+     * to detect an invariant subspace, to identify copies of an eigenvalue of
+     * the Lanczos tridiagonal matrix, and to identify spurious eigenvalues.
+     */
+    constexpr static double LANCZOS_TOLERANCE {10};
+    /*!
+     * The number of Lanczos steps after which the eigenvalues of the Lanczos
+     * tridiagonal matrix are first checked for convergence. The number of
+     * steps is doubled after each check.
+     */
+    constexpr static int LANCZOS_FIRST_CHECK {32};
+    /*!
+     * The maximum number of Lanczos steps per row of the matrix.
+     */
+    constexpr static int LANCZOS_MAX_STEPS {4};
+    /*!
+     * The genes which are included in the pruned matrix at or above the
+     * stopping threshold, sorted by the threshold at which they are included.
+     */
+    std::vector<qint32> _genes;
+    /*!
+     * The row-wise maximums of the correlation matrix, which determine the
+     * threshold at which each gene is included in the pruned matrix.
+     */
+    std::vector<float> _maximums;
+    /*!
+     * The edges which are included in the pruned matrix at or above the
+     * stopping threshold, sorted by the threshold at which they are included.
+     */
+    std::vector<Edge> _edges;
+    /*!
+     * The persistent pruned matrix, which contains the genes and edges that
+     * were included so far. Rows are assigned to genes in the order in which
+     * they are included, and the lower triangle of the matrix is stored row by
+     * row, so that including a gene only appends a row to the matrix. The
+     * persistent pruned matrix is only used for dense pruned matrices.
+     */
+    std::vector<float> _pruneMatrix;
+    /*!
+     * The off-diagonal elements of the persistent pruned matrix in the order
+     * in which they were included, which is only used for sparse pruned
+     * matrices. The sparse pruned matrix of a threshold shares this list, so
+     * the list only grows while no pruned matrix of an earlier threshold is
+     * being solved, and it is replaced by a new list when it is reset.
+     */
+    std::shared_ptr<std::vector<SparseEntry>> _pruneEntries;
+    /*!
+     * The pruned matrices which are passed to the eigensolver, one for each
+     * concurrent test. They are reused across thresholds so that the memory
+     * of a dense pruned matrix is not allocated for every threshold.
+     */
+    std::vector<PruneMatrix> _pruneBuffers;
+    /*!
+     * The number of rows in the persistent pruned matrix.
+     */
+    size_t _pruneSize {0};
+    /*!
+     * The row of each gene in the persistent pruned matrix, or -1 if the gene
+     * has not been included.
+     */
+    std::vector<int> _pruneIndices;
+    /*!
+     * The number of sorted genes which have been included in the persistent
+     * pruned matrix.
+     */
+    size_t _nextGene {0};
+    /*!
+     * The number of sorted edges which have been included in the persistent
+     * pruned matrix.
+     */
+    size_t _nextEdge {0};
+    /*!
+     * The threshold of the persistent pruned matrix.
+     */
+    float _pruneThreshold {std::numeric_limits<float>::infinity()};
     /*!
      * Pointer to the input correlation matrix.
      */
@@ -72,7 +282,7 @@ private:
      * correlations when there are multiple correlations per pair. By default, the
      * first cluster is selected from each pair.
      */
-    ReductionMethod _reductionMethod {ReductionMethod::First};
+    CorrelationMatrix::ReductionMethod _reductionMethod {CorrelationMatrix::ReductionMethod::First};
     /*!
      * The starting threshold.
      */
@@ -86,6 +296,14 @@ private:
      * proper threshold before reaching the stopping threshold.
      */
     float _thresholdStop {0.5f};
+    /*!
+     * The method used to search for the final threshold.
+     */
+    SearchMethod _searchMethod {SearchMethod::Linear};
+    /*!
+     * The threshold decrement of the coarse search.
+     */
+    float _thresholdCoarseStep {0.01f};
     /*!
      * The critical value for the chi-squared test, which is dependent on the
      * degrees of freedom and the alpha-value of the test. This particular
@@ -100,10 +318,44 @@ private:
      * analytic to find a proper threshold.
      */
     float _chiSquareThreshold2 {200};
+    /*!
+     * The eigensolver used to compute the eigenvalues of each pruned matrix.
+     */
+    EigenSolver _eigenSolver {EigenSolver::Ssyev};
     /**
      * The number of threads to use during eigenvalue computation.
      */
     int _numThreads {1};
+    /*!
+     * The number of thresholds to test concurrently. The threads used during
+     * eigenvalue computation are divided among the concurrent tests.
+     */
+    int _windowSize {1};
+    /*!
+     * The path of the eigenvalue cache file, or an empty string if the
+     * eigenvalues are not cached.
+     */
+    QString _cacheFileName;
+    /*!
+     * Whether to compute the statistics of each threshold only from the
+     * eigenvalue cache, without loading the correlation matrix or computing
+     * any eigenvalues.
+     */
+    bool _statsOnly {false};
+    /*!
+     * Pointer to the eigenvalue cache.
+     */
+    std::unique_ptr<Cache> _cache;
+    /*!
+     * The path of the threshold summary file of the input correlation matrix,
+     * or an empty string if no summary was provided.
+     */
+    QString _summaryFileName;
+    /*!
+     * The index of the first threshold step to test. Threshold steps above it
+     * are known from the threshold summary to have an empty pruned matrix.
+     */
+    int _startIndex {0};
     /*!
      * The minimum difference required between an eigenvalue and the previous
      * eigenvalue in ascending order for the eigenvalue to be considered unique.
@@ -0,0 +1,214 @@
+#include "rmt_cache.h"
+#include <cmath>
+
+
+
+/*!
+ * Construct a new cache object for the given file name. The file is not
+ * accessed until it is loaded or created.
+ *
+ * @param fileName
+ */
+RMT::Cache::Cache(const QString& fileName):
+    _file(fileName)
+{
+    EDEBUG_FUNC(this,&fileName);
+}
+
+
+
+/*!
+ * Load an existing cache file with the given hash, reduction method and eigen
+ * solver. If the cache file does not exist or has a different hash, reduction
+ * method or eigen solver, no entries are loaded and false is returned. If the last entry of the cache
+ * file was only partially written, it is discarded. The cache file remains
+ * open so that new entries can be appended.
+ *
+ * @param hash
+ * @param reductionMethod
+ * @param eigenSolver
+ */
+bool RMT::Cache::load(const QByteArray& hash, qint32 reductionMethod, qint32 eigenSolver)
+{
+    EDEBUG_FUNC(this,&hash,reductionMethod,eigenSolver);
+
+    _entries.clear();
+
+    // open cache file if it exists
+    if ( !_file.exists() || !_file.open(QIODevice::ReadWrite) )
+    {
+        return false;
+    }
+
+    _stream.setDevice(&_file);
+    _stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    // read header and make sure that it matches
+    quint32 magic;
+    QByteArray fileHash;
+    qint32 fileReductionMethod;
+    qint32 fileEigenSolver;
+
+    _stream >> magic >> fileHash >> fileReductionMethod >> fileEigenSolver;
+
+    if ( _stream.status() != QDataStream::Ok || magic != MAGIC || fileHash != hash || fileReductionMethod != reductionMethod || fileEigenSolver != eigenSolver )
+    {
+        _file.close();
+        return false;
+    }
+
+    // read each entry
+    qint64 end {_file.pos()};
+
+    while ( !_stream.atEnd() )
+    {
+        Entry entry;
+        qint64 eigenSize;
+
+        _stream >> entry.threshold >> entry.size >> eigenSize;
+
+        // make sure that the eigenvalues fit in the rest of the file
+        if ( _stream.status() != QDataStream::Ok || eigenSize < 0 || eigenSize > (_file.size() - _file.pos()) / static_cast<qint64>(sizeof(float)) )
+        {
+            break;
+        }
+
+        entry.eigens.resize(eigenSize);
+
+        for ( auto& eigen : entry.eigens )
+        {
+            _stream >> eigen;
+        }
+
+        if ( _stream.status() != QDataStream::Ok )
+        {
+            break;
+        }
+
+        _entries.insert(key(entry.threshold), entry);
+        end = _file.pos();
+    }
+
+    // discard any partially written entry
+    _stream.resetStatus();
+    _file.resize(end);
+    _file.seek(end);
+
+    return true;
+}
+
+
+
+/*!
+ * Create a new cache file with the given hash, reduction method and eigen
+ * solver, replacing any existing file, and write the header.
+ *
+ * @param hash
+ * @param reductionMethod
+ * @param eigenSolver
+ */
+void RMT::Cache::create(const QByteArray& hash, qint32 reductionMethod, qint32 eigenSolver)
+{
+    EDEBUG_FUNC(this,&hash,reductionMethod,eigenSolver);
+
+    _entries.clear();
+
+    // open cache file
+    if ( _file.isOpen() )
+    {
+        _file.close();
+    }
+
+    if ( !_file.open(QIODevice::ReadWrite | QIODevice::Truncate) )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(QObject::tr("File IO Error"));
+        e.setDetails(QObject::tr("Could not create eigenvalue cache file %1.").arg(_file.fileName()));
+        throw e;
+    }
+
+    _stream.setDevice(&_file);
+    _stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    // write header
+    _stream << MAGIC << hash << reductionMethod << eigenSolver;
+
+    checkStatus();
+}
+
+
+
+/*!
+ * Append an entry to the end of the cache file. The eigenvalues are written
+ * through the data stream like the rest of the file, so that the cache file
+ * has the same byte order on every machine.
+ *
+ * @param entry
+ */
+void RMT::Cache::append(const Entry& entry)
+{
+    EDEBUG_FUNC(this,&entry);
+
+    // write entry
+    _stream << entry.threshold << entry.size << static_cast<qint64>(entry.eigens.size());
+
+    for ( float eigen : entry.eigens )
+    {
+        _stream << eigen;
+    }
+
+    checkStatus();
+
+    // flush so that a partially written cache file contains only whole entries
+    _file.flush();
+    _entries.insert(key(entry.threshold), entry);
+}
+
+
+
+/*!
+ * Return the entry of the given threshold, or nullptr if the threshold is
+ * not in the cache.
+ *
+ * @param threshold
+ */
+const RMT::Cache::Entry* RMT::Cache::find(float threshold) const
+{
+    EDEBUG_FUNC(this,threshold);
+
+    auto iter = _entries.constFind(key(threshold));
+
+    return ( iter != _entries.constEnd() ) ? &iter.value() : nullptr;
+}
+
+
+
+/*!
+ * Return the key of the given threshold. Thresholds are rounded to six decimal
+ * places so that the same threshold step matches regardless of how it was
+ * computed from the starting threshold and threshold step.
+ *
+ * @param threshold
+ */
+qint32 RMT::Cache::key(float threshold)
+{
+    return static_cast<qint32>(lround(threshold * 1e6));
+}
+
+
+
+/*!
+ * Make sure that the last read or write on the cache file succeeded.
+ */
+void RMT::Cache::checkStatus()
+{
+    EDEBUG_FUNC(this);
+
+    if ( _stream.status() != QDataStream::Ok )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(QObject::tr("File IO Error"));
+        e.setDetails(QObject::tr("Qt Data Stream encountered an error on eigenvalue cache file %1.").arg(_file.fileName()));
+        throw e;
+    }
+}
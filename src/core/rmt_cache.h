@@ -0,0 +1,71 @@
+#ifndef RMT_CACHE_H
+#define RMT_CACHE_H
+#include "rmt.h"
+#include <QHash>
+
+
+
+/*!
+ * This class implements the eigenvalue cache of the RMT analytic. The cache
+ * file stores the sorted eigenvalues of the pruned matrix at each threshold
+ * which was tested, so that the statistics of each threshold can be recomputed
+ * with different parameters without computing any eigenvalues. The cache file
+ * consists of a header followed by a list of entries. The header contains a
+ * hash of the contents of the correlation matrix, the reduction method and the
+ * eigen solver, since the eigenvalues depend on all three (the Lanczos solver
+ * only stores unique eigenvalues), and a cache file is only used if all three
+ * match. Each entry contains a threshold, the size of the pruned matrix, and
+ * the eigenvalues of the pruned matrix. Entries are appended as thresholds are
+ * tested, so a cache file can be extended by later runs.
+ */
+class RMT::Cache
+{
+public:
+    /*!
+     * Defines an entry of the cache file.
+     */
+    struct Entry
+    {
+        /*!
+         * The threshold of the pruned matrix.
+         */
+        float threshold;
+        /*!
+         * The number of rows in the pruned matrix.
+         */
+        qint64 size;
+        /*!
+         * The sorted eigenvalues of the pruned matrix.
+         */
+        std::vector<float> eigens;
+    };
+public:
+    explicit Cache(const QString& fileName);
+    bool load(const QByteArray& hash, qint32 reductionMethod, qint32 eigenSolver);
+    void create(const QByteArray& hash, qint32 reductionMethod, qint32 eigenSolver);
+    void append(const Entry& entry);
+    const Entry* find(float threshold) const;
+private:
+    static qint32 key(float threshold);
+    void checkStatus();
+    /*!
+     * Identifies a file as an RMT eigenvalue cache file.
+     */
+    constexpr static quint32 MAGIC {0x4b524d54};
+    /*!
+     * The cache file.
+     */
+    QFile _file;
+    /*!
+     * The data stream used to read and write the cache file.
+     */
+    QDataStream _stream;
+    /*!
+     * The entries of the cache file, keyed by threshold.
+     */
+    QHash<qint32, Entry> _entries;
+};
+
+
+
+#endif
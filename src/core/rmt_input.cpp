@@ -19,6 +19,34 @@ const QStringList RMT::Input::REDUCTION_NAMES
 
 
 
+/*!
+ * String list of search methods for this analytic that correspond exactly
+ * to its enumeration. Used for handling the search method argument for this
+ * input object.
+ */
+const QStringList RMT::Input::SEARCH_NAMES
+{
+    "linear"
+    ,"coarse"
+};
+
+
+
+/*!
+ * String list of eigensolvers for this analytic that correspond exactly
+ * to its enumeration. Used for handling the eigensolver argument for this
+ * input object.
+ */
+const QStringList RMT::Input::SOLVER_NAMES
+{
+    "ssyev"
+    ,"ssyevd"
+    ,"ssyevr"
+    ,"lanczos"
+};
+
+
+
 /*!
  * Construct a new input object with the given analytic as its parent.
  *
@@ -62,7 +90,14 @@ EAbstractAnalyticInput::Type RMT::Input::type(int index) const
     case ThresholdStart: return Type::Double;
     case ThresholdStep: return Type::Double;
     case ThresholdStop: return Type::Double;
+    case SearchType: return Type::Selection;
+    case ThresholdCoarseStep: return Type::Double;
+    case SolverType: return Type::Selection;
     case NumThreads: return Type::Integer;
+    case WindowSize: return Type::Integer;
+    case CacheFile: return Type::String;
+    case StatsOnly: return Type::Boolean;
+    case SummaryFile: return Type::String;
     case UniqueEpsilon: return Type::Double;
     case MinUniqueEigenvalues: return Type::Integer;
     case SplineInterpolation: return Type::Boolean;
@@ -148,6 +183,37 @@ QVariant RMT::Input::data(int index, Role role) const
         case Role::Maximum: return 1;
         default: return QVariant();
         }
+    case SearchType:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("search");
+        case Role::Title: return tr("Search Method:");
+        case Role::WhatsThis: return tr("Method to use for searching thresholds. The linear search tests every threshold step. The coarse search tests every coarse threshold step until the chi-squared test exceeds the final threshold, and then bisects the coarse step in which the chi-squared value crossed the critical value.");
+        case Role::SelectionValues: return SEARCH_NAMES;
+        case Role::Default: return "linear";
+        default: return QVariant();
+        }
+    case ThresholdCoarseStep:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("tcoarse");
+        case Role::Title: return tr("Threshold Coarse Step:");
+        case Role::WhatsThis: return tr("Threshold step size of the coarse search. It is rounded to a multiple of the threshold step size.");
+        case Role::Default: return 0.01;
+        case Role::Minimum: return 0;
+        case Role::Maximum: return 1;
+        default: return QVariant();
+        }
+    case SolverType:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("solver");
+        case Role::Title: return tr("Eigensolver:");
+        case Role::WhatsThis: return tr("Eigensolver to use for each pruned matrix. The ssyev, ssyevd, and ssyevr solvers store the lower triangle of each pruned matrix in packed form and use the QR, divide-and-conquer, and bisection drivers for packed matrices of LAPACK (sspev, sspevd, and sspevx). The lanczos solver uses the Lanczos algorithm without reorthogonalization on the sparse form of each pruned matrix and computes only its unique eigenvalues, so that its memory usage is linear in the number of genes and edges.");
+        case Role::SelectionValues: return SOLVER_NAMES;
+        case Role::Default: return "ssyev";
+        default: return QVariant();
+        }
     case NumThreads:
         switch (role)
         {
@@ -159,6 +225,44 @@ QVariant RMT::Input::data(int index, Role role) const
         case Role::Maximum: return std::numeric_limits<int>::max();
         default: return QVariant();
         }
+    case WindowSize:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("window");
+        case Role::Title: return tr("Threshold Window Size:");
+        case Role::WhatsThis: return tr("The number of thresholds to test concurrently. The threads are divided among the concurrent tests, whose eigensolver calls run in parallel with one thread each. Each concurrent test requires its own pruned matrix.");
+        case Role::Default: return 1;
+        case Role::Minimum: return 1;
+        case Role::Maximum: return std::numeric_limits<int>::max();
+        default: return QVariant();
+        }
+    case CacheFile:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("cache");
+        case Role::Title: return tr("Eigenvalue Cache File:");
+        case Role::WhatsThis: return tr("Binary file in which the eigenvalues of each threshold are cached. Cached eigenvalues are reused by later runs on the same correlation matrix with the same reduction method and eigen solver. Leave empty to disable caching.");
+        case Role::Default: return QString();
+        default: return QVariant();
+        }
+    case StatsOnly:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("statsonly");
+        case Role::Title: return tr("Statistics Only:");
+        case Role::WhatsThis: return tr("Whether to compute the chi-squared test of each threshold only from the eigenvalue cache, without computing any eigenvalues. Every tested threshold must be in the cache.");
+        case Role::Default: return false;
+        default: return QVariant();
+        }
+    case SummaryFile:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("summary");
+        case Role::Title: return tr("Threshold Summary File:");
+        case Role::WhatsThis: return tr("Threshold summary file of the input correlation matrix, which is produced by the similarity analytic. If provided, it is used to skip the thresholds at which the pruned matrix is empty and to allocate memory in advance.");
+        case Role::Default: return QString();
+        default: return QVariant();
+        }
     case UniqueEpsilon:
         switch (role)
         {
@@ -242,7 +346,7 @@ void RMT::Input::set(int index, const QVariant& value)
     switch (index)
     {
     case ReductionType:
-        _base->_reductionMethod = static_cast<ReductionMethod>(REDUCTION_NAMES.indexOf(value.toString()));
+        _base->_reductionMethod = static_cast<CorrelationMatrix::ReductionMethod>(REDUCTION_NAMES.indexOf(value.toString()));
         break;
     case ThresholdStart:
         _base->_thresholdStart = value.toFloat();
@@ -253,9 +357,30 @@ void RMT::Input::set(int index, const QVariant& value)
     case ThresholdStop:
         _base->_thresholdStop = value.toFloat();
         break;
+    case SearchType:
+        _base->_searchMethod = static_cast<SearchMethod>(SEARCH_NAMES.indexOf(value.toString()));
+        break;
+    case ThresholdCoarseStep:
+        _base->_thresholdCoarseStep = value.toFloat();
+        break;
+    case SolverType:
+        _base->_eigenSolver = static_cast<EigenSolver>(SOLVER_NAMES.indexOf(value.toString()));
+        break;
     case NumThreads:
         _base->_numThreads = value.toInt();
         break;
+    case WindowSize:
+        _base->_windowSize = value.toInt();
+        break;
+    case CacheFile:
+        _base->_cacheFileName = value.toString();
+        break;
+    case StatsOnly:
+        _base->_statsOnly = value.toBool();
+        break;
+    case SummaryFile:
+        _base->_summaryFileName = value.toString();
+        break;
     case UniqueEpsilon:
         _base->_uniqueEpsilon = value.toFloat();
         break;
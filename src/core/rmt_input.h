@@ -22,7 +22,14 @@ public:
         ,ThresholdStart
         ,ThresholdStep
         ,ThresholdStop
+        ,SearchType
+        ,ThresholdCoarseStep
+        ,SolverType
         ,NumThreads
+        ,WindowSize
+        ,CacheFile
+        ,StatsOnly
+        ,SummaryFile
         ,UniqueEpsilon
         ,MinUniqueEigenvalues
         ,SplineInterpolation
@@ -40,6 +47,8 @@ public:
     virtual void set(int index, EAbstractData* data) override final;
 private:
     static const QStringList REDUCTION_NAMES;
+    static const QStringList SEARCH_NAMES;
+    static const QStringList SOLVER_NAMES;
     /*!
      * Pointer to the base analytic for this object.
      */
@@ -5,10 +5,15 @@
 #include "similarity_workblock.h"
 #include "similarity_opencl.h"
 #include "similarity_cuda.h"
+#include "similarity_shard.h"
 #include "ccmatrix_pair.h"
 #include "correlationmatrix_pair.h"
+#include "expressionmatrix_gene.h"
 #include <ace/core/ace_qmpi.h>
 #include <ace/core/elog.h>
+#include <algorithm>
+#include <cstring>
+#include <functional>
 
 
 
@@ -49,6 +54,14 @@ qint64 Similarity::totalPairs(const ExpressionMatrix* emx)
 
 
 
+/*!
+ * Destroy this analytic. This destructor is defined here because the shard
+ * class is incomplete in the header.
+ */
+Similarity::~Similarity() = default;
+
+
+
 /*!
  * Return the total number of work blocks this analytic must process.
  */
@@ -56,7 +69,7 @@ int Similarity::size() const
 {
     EDEBUG_FUNC(this);
 
-    return (totalPairs(_input) + _workBlockSize - 1) / _workBlockSize;
+    return static_cast<int>(_blockStarts.size()) - 1;
 }
 
 
@@ -64,7 +77,7 @@ int Similarity::size() const
 /*!
  * Create and return a work block for this analytic with the given index. This
  * implementation creates a work block with a start index and size denoting the
- * number of pairs to process.
+ * number of pairs to process, as determined by the work block schedule.
  *
  * @param index
  */
@@ -77,10 +90,10 @@ std::unique_ptr<EAbstractAnalyticBlock> Similarity::makeWork(int index) const
         ELog() << tr("Making work index %1 of %2.\n").arg(index).arg(size());
     }
 
-    qint64 start {index * static_cast<qint64>(_workBlockSize)};
-    qint64 size {min(totalPairs(_input) - start, static_cast<qint64>(_workBlockSize))};
+    qint64 start {_blockStarts[index]};
+    qint64 size {_blockStarts[index + 1] - start};
 
-    return unique_ptr<EAbstractAnalyticBlock>(new WorkBlock(index, start, size));
+    return unique_ptr<EAbstractAnalyticBlock>(new WorkBlock(index, start, size, _runId));
 }
 
 
@@ -131,6 +144,17 @@ std::unique_ptr<EAbstractAnalyticBlock> Similarity::makeResult() const
  *   0 0 1 0 1 9 0 6 ,
  *   0 0 0 1 0 9 1 6
  *
+ * The pairwise indices of the result block refer to the genes which were used
+ * to enumerate pairs, so they are mapped back to the genes of the input
+ * expression matrix before they are saved.
+ *
+ * If the top-k mode is used, the correlations are instead kept in memory until
+ * the last result block is processed, and only the strongest correlations of
+ * each gene are saved.
+ *
+ * If shard files are used, the pairs were already written to the shard file of
+ * the process which executed the work block, so the result block is empty.
+ *
  * @param result
  */
 void Similarity::process(const EAbstractAnalyticBlock* result)
@@ -144,6 +168,20 @@ void Similarity::process(const EAbstractAnalyticBlock* result)
 
     const ResultBlock* resultBlock {result->cast<ResultBlock>()};
 
+    // keep only the strongest correlations of each gene if top-k mode is used
+    if ( _topK > 0 )
+    {
+        appendTopEdges(resultBlock);
+
+        if ( result->index() == size() - 1 )
+        {
+            writeTopEdges();
+            writeSummary();
+        }
+
+        return;
+    }
+
     // iterate through all pairs in result block
     Pairwise::Index index {resultBlock->start()};
 
@@ -179,16 +217,28 @@ void Similarity::process(const EAbstractAnalyticBlock* result)
 
         if ( ccmPair.clusterSize() > 0 )
         {
-            ccmPair.write(index);
+            ccmPair.write(mapIndex(index));
         }
 
         if ( cmxPair.clusterSize() > 0 )
         {
-            cmxPair.write(index);
+            cmxPair.write(mapIndex(index));
+
+            if ( _summary )
+            {
+                _summary->add(mapIndex(index), cmxPair);
+            }
         }
 
         ++index;
     }
+
+    // save threshold summary and shard manifest after the last result block
+    if ( result->index() == size() - 1 )
+    {
+        writeSummary();
+        writeManifest();
+    }
 }
 
 
@@ -252,9 +302,11 @@ void Similarity::initialize()
     // get MPI instance
     auto& mpi {Ace::QMPI::instance()};
 
-    // only the master process needs to validate arguments
+    // only the master process needs to validate arguments, but every process
+    // needs the genes which are used to enumerate pairs
     if ( !mpi.isMaster() )
     {
+        initializeGenes();
         return;
     }
 
@@ -276,6 +328,33 @@ void Similarity::initialize()
         throw e;
     }
 
+    // make sure shard prefix is valid
+    if ( !_shardPrefix.isEmpty() && !QFileInfo(_shardPrefix).absoluteDir().exists() )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(tr("Invalid Argument"));
+        e.setDetails(tr("Directory of shard prefix %1 does not exist.").arg(_shardPrefix));
+        throw e;
+    }
+
+    // make sure top-k mode is not used with shard files
+    if ( _topK > 0 && !_shardPrefix.isEmpty() )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(tr("Invalid Argument"));
+        e.setDetails(tr("Top-k mode cannot be used with shard files."));
+        throw e;
+    }
+
+    // make sure threshold summary is not used with shard files
+    if ( !_summaryFileName.isEmpty() && !_shardPrefix.isEmpty() )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(tr("Invalid Argument"));
+        e.setDetails(tr("Threshold summary cannot be used with shard files."));
+        throw e;
+    }
+
     // make sure kernel work sizes are valid
     if ( _globalWorkSize % _localWorkSize != 0 )
     {
@@ -285,12 +364,42 @@ void Similarity::initialize()
         throw e;
     }
 
+    // initialize genes used to enumerate pairs
+    initializeGenes();
+
     // initialize work block size
     if ( _workBlockSize == 0 )
     {
         int numWorkers = max(1, mpi.size() - 1);
 
-        _workBlockSize = min(32768LL, totalPairs(_input) / numWorkers);
+        _workBlockSize = max(1LL, min(32768LL, pairSize() / numWorkers));
+    }
+
+    // initialize work block schedule
+    initializeWorkBlocks();
+
+    // start a new run of shard files
+    if ( !_shardPrefix.isEmpty() )
+    {
+        _runId = QUuid::createUuid();
+        removeShards();
+    }
+
+    // initialize heaps of strongest correlations
+    _topEdges.clear();
+
+    if ( _topK > 0 )
+    {
+        _topEdges.resize(_genes.size());
+    }
+
+    // initialize threshold summary
+    _summary.reset();
+
+    if ( !_summaryFileName.isEmpty() )
+    {
+        _summary.reset(new ThresholdSummary());
+        _summary->initialize(_input->geneSize());
     }
 }
 
@@ -318,3 +427,687 @@ void Similarity::initializeOutputs()
     // initialize correlation matrix
     _cmx->initialize(_input->geneNames(), _maxClusters, _corrName);
 }
+
+
+
+/*!
+ * Return whether a correlation is stronger than another correlation. The
+ * stronger correlation has the larger absolute value, and ties are broken by
+ * the indent of each correlation so that the result does not depend on the
+ * order in which correlations are processed.
+ *
+ * @param a
+ * @param indentA
+ * @param b
+ * @param indentB
+ */
+bool Similarity::isStronger(float a, qint64 indentA, float b, qint64 indentB)
+{
+    return abs(a) > abs(b) || (abs(a) == abs(b) && indentA < indentB);
+}
+
+
+
+/*!
+ * Initialize the list of genes which are used to enumerate pairs. If the
+ * pre-filter is enabled, a pre-pass computes the number of clean samples of
+ * each gene, which are the samples that are not missing and not below the
+ * minimum expression, and the variance of those samples. A gene is excluded
+ * if it has fewer clean samples than the minimum, since every pair with that
+ * gene would have fewer clean samples than the minimum. A gene is also
+ * excluded if the variance of its clean samples is zero, since the gene is
+ * then constant in every cluster of every pair and its correlation is always
+ * undefined. The variance is computed in double precision with the mean
+ * removed first, so it is zero only if the clean samples are exactly equal.
+ * Genes with a small but nonzero variance are kept, because they can still
+ * have a defined correlation. The pairs of excluded genes can therefore never
+ * produce a correlation, and the output is the same as without the
+ * pre-filter.
+ */
+void Similarity::initializeGenes()
+{
+    EDEBUG_FUNC(this);
+
+    _genes.clear();
+
+    // include every gene if the pre-filter is disabled
+    if ( !_preFilter )
+    {
+        for ( qint32 i = 0; i < _input->geneSize(); ++i )
+        {
+            _genes.append(i);
+        }
+
+        return;
+    }
+
+    // include each gene which can produce a correlation
+    ExpressionMatrix::Gene gene(_input);
+    int numSparse {0};
+    int numConstant {0};
+
+    for ( qint32 i = 0; i < _input->geneSize(); ++i )
+    {
+        gene.read(i);
+
+        // compute the number of clean samples and their mean
+        int numSamples = 0;
+        double sum = 0;
+
+        for ( int j = 0; j < _input->sampleSize(); ++j )
+        {
+            float value = gene.at(j);
+
+            if ( !isnan(value) && value >= _minExpression )
+            {
+                sum += value;
+                ++numSamples;
+            }
+        }
+
+        if ( numSamples < _minSamples )
+        {
+            ++numSparse;
+            continue;
+        }
+
+        // compute the variance of the clean samples
+        double mean = sum / numSamples;
+        double variance = 0;
+
+        for ( int j = 0; j < _input->sampleSize(); ++j )
+        {
+            float value = gene.at(j);
+
+            if ( !isnan(value) && value >= _minExpression )
+            {
+                variance += (value - mean) * (value - mean);
+            }
+        }
+
+        variance /= numSamples;
+
+        if ( variance == 0 )
+        {
+            ++numConstant;
+            continue;
+        }
+
+        _genes.append(i);
+    }
+
+    if ( ELog::isActive() )
+    {
+        ELog() << tr("Pre-filter excluded %1 of %2 genes (%3 with too few samples, %4 with zero variance).\n")
+            .arg(_input->geneSize() - _genes.size())
+            .arg(_input->geneSize())
+            .arg(numSparse)
+            .arg(numConstant);
+    }
+}
+
+
+
+/*!
+ * Divide the pairwise index space into work blocks according to the work
+ * block schedule. The static schedule uses the work block size for every
+ * block. The factoring schedule hands out pairs in batches of one block per
+ * worker, where each block in a batch covers half of the remaining pairs
+ * divided evenly among the workers. Blocks therefore start at the work block
+ * size and shrink toward the end of the pairwise index, so that a slow block
+ * near the end cannot hold up the other workers for long. Blocks never shrink
+ * below the global work size, since smaller blocks would underutilize a GPU
+ * worker.
+ */
+void Similarity::initializeWorkBlocks()
+{
+    EDEBUG_FUNC(this);
+
+    // determine the range of block sizes
+    int numWorkers = max(1, Ace::QMPI::instance().size() - 1);
+    qint64 total {pairSize()};
+    qint64 maxSize {_workBlockSize};
+    qint64 minSize {min(maxSize, static_cast<qint64>(_globalWorkSize))};
+
+    // append the start of each block
+    _blockStarts.clear();
+
+    qint64 start {0};
+
+    while ( start < total )
+    {
+        // compute the block size for the next batch
+        qint64 size {maxSize};
+
+        if ( _blockSchedule == BlockSchedule::Factoring )
+        {
+            qint64 remaining {total - start};
+
+            size = (remaining + 2 * numWorkers - 1) / (2 * numWorkers);
+            size = max(minSize, min(maxSize, size));
+        }
+
+        // append one block for each worker in the batch
+        for ( int i = 0; i < numWorkers && start < total; ++i )
+        {
+            _blockStarts.push_back(start);
+            start += min(size, total - start);
+        }
+    }
+
+    _blockStarts.push_back(total);
+}
+
+
+
+
+/*!
+ * Return the expression data of the genes which are used to enumerate pairs,
+ * in the same layout as the raw data of the expression matrix. Workers use
+ * this data so that the pairwise indices of work blocks refer directly to
+ * rows of the returned array.
+ */
+std::vector<float> Similarity::dumpExpressions() const
+{
+    EDEBUG_FUNC(this);
+
+    std::vector<float> expressions {_input->dumpRawData()};
+
+    // return the raw data if every gene is used
+    if ( _genes.size() == _input->geneSize() )
+    {
+        return expressions;
+    }
+
+    // move the expressions of each used gene to its row in the compacted array
+    int sampleSize {_input->sampleSize()};
+
+    for ( int i = 0; i < _genes.size(); ++i )
+    {
+        memmove(
+            &expressions[static_cast<qint64>(i) * sampleSize],
+            &expressions[static_cast<qint64>(_genes[i]) * sampleSize],
+            sampleSize * sizeof(float)
+        );
+    }
+
+    expressions.resize(static_cast<qint64>(_genes.size()) * sampleSize);
+
+    return expressions;
+}
+
+
+
+/*!
+ * Return the number of pairs which are enumerated, which is the number of
+ * pairs among the genes which are used to enumerate pairs.
+ */
+qint64 Similarity::pairSize() const
+{
+    EDEBUG_FUNC(this);
+
+    return static_cast<qint64>(_genes.size()) * (_genes.size() - 1) / 2;
+}
+
+
+
+/*!
+ * Map a pairwise index of the genes which are used to enumerate pairs to the
+ * pairwise index of the same genes in the input expression matrix. Since the
+ * list of genes is sorted, the mapping preserves the order of pairs.
+ *
+ * @param index
+ */
+Pairwise::Index Similarity::mapIndex(const Pairwise::Index& index) const
+{
+    EDEBUG_FUNC(this,&index);
+
+    return Pairwise::Index(_genes[index.getX()], _genes[index.getY()]);
+}
+
+
+
+/*!
+ * Remove the manifest and every shard file with the shard prefix, so that the
+ * shard files of an earlier run cannot be mistaken for the shard files of this
+ * run. This is done by the master process before any work block is executed.
+ */
+void Similarity::removeShards()
+{
+    EDEBUG_FUNC(this);
+
+    QStringList fileNames {Shard::find(_shardPrefix)};
+
+    if ( QFile::exists(Shard::manifestName(_shardPrefix)) )
+    {
+        fileNames.prepend(Shard::manifestName(_shardPrefix));
+    }
+
+    for ( auto& fileName : fileNames )
+    {
+        if ( !QFile::remove(fileName) )
+        {
+            E_MAKE_EXCEPTION(e);
+            e.setTitle(tr("File IO Error"));
+            e.setDetails(tr("Could not remove shard file %1 of an earlier run.").arg(fileName));
+            throw e;
+        }
+    }
+}
+
+
+
+/*!
+ * Write the pairs of the given result block to the shard file of this process
+ * and remove them from the result block, so that only an empty result block is
+ * sent back to the master process. The correlations which are outside of the
+ * thresholds are discarded and the labels of each remaining cluster are
+ * converted to a packed sample mask in the same way as the process function
+ * does. The shard file is created with the run id of the work block when the
+ * first result block is written. This function can be called by multiple
+ * workers at the same time.
+ *
+ * @param resultBlock
+ * @param runId
+ */
+void Similarity::writeShard(ResultBlock* resultBlock, const QUuid& runId)
+{
+    EDEBUG_FUNC(this,resultBlock,&runId);
+
+    // encode pairs which have at least one correlation within thresholds
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    int sampleSize {_input->sampleSize()};
+    Shard::Segment segment {};
+    segment.index = resultBlock->index();
+    segment.start = resultBlock->start();
+    segment.size = resultBlock->pairs().size();
+
+    Pairwise::Index index {resultBlock->start()};
+    QVector<qint8> clusters;
+
+    for ( auto& pair : resultBlock->pairs() )
+    {
+        // determine which correlations are within thresholds
+        clusters.clear();
+
+        for ( qint8 k = 0; k < pair.K; ++k )
+        {
+            float corr = pair.correlations[k];
+
+            if ( !isnan(corr) && _minCorrelation <= abs(corr) && abs(corr) <= _maxCorrelation )
+            {
+                clusters.append(k);
+            }
+        }
+
+        if ( clusters.isEmpty() )
+        {
+            ++index;
+            continue;
+        }
+
+        // write pair header
+        Pairwise::Index mappedIndex {mapIndex(index)};
+
+        stream << mappedIndex.getX() << mappedIndex.getY() << static_cast<qint8>(clusters.size());
+
+        // write correlation and packed sample mask of each cluster
+        for ( qint8 k : clusters )
+        {
+            stream << pair.correlations[k];
+
+            for ( int i = 0; i < sampleSize; i += 2 )
+            {
+                qint8 lower {static_cast<qint8>((pair.labels[i] >= 0) ? (k == pair.labels[i]) : -pair.labels[i])};
+                qint8 value {static_cast<qint8>(lower & 0x0F)};
+
+                if ( i + 1 < sampleSize )
+                {
+                    qint8 upper {static_cast<qint8>((pair.labels[i + 1] >= 0) ? (k == pair.labels[i + 1]) : -pair.labels[i + 1])};
+                    value |= static_cast<qint8>(upper << 4);
+                }
+
+                stream << value;
+            }
+        }
+
+        segment.pairSize += 1;
+        segment.clusterSize += clusters.size();
+        ++index;
+    }
+
+    // append segment to the shard file of this process
+    {
+        QMutexLocker locker(&_shardMutex);
+
+        if ( !_shard )
+        {
+            _shard.reset(new Shard(Shard::fileName(_shardPrefix, Ace::QMPI::instance().rank())));
+            _shard->create(runId, _input->geneSize(), sampleSize, _maxClusters, _corrName, pairSize());
+        }
+
+        _shard->write(segment, data);
+    }
+
+    // remove pairs from result block
+    resultBlock->pairs().clear();
+}
+
+
+
+/*!
+ * Write the manifest of this run if shard files are used. This is done by the
+ * master process after the last result block, when every shard file of this
+ * run is complete. Since each process writes the shard file of its own rank,
+ * the manifest lists the shard file of each rank which exists and has the run
+ * id of this run.
+ */
+void Similarity::writeManifest()
+{
+    EDEBUG_FUNC(this);
+
+    if ( _shardPrefix.isEmpty() )
+    {
+        return;
+    }
+
+    Shard::Manifest manifest {_runId, {}};
+
+    for ( int rank = 0; rank < Ace::QMPI::instance().size(); ++rank )
+    {
+        QString fileName {Shard::fileName(_shardPrefix, rank)};
+
+        if ( !QFile::exists(fileName) )
+        {
+            continue;
+        }
+
+        Shard shard(fileName);
+        shard.open();
+
+        if ( shard.runId() == _runId )
+        {
+            manifest.fileNames.append(QFileInfo(fileName).fileName());
+        }
+    }
+
+    Shard::writeManifest(_shardPrefix, manifest);
+}
+
+
+
+
+/*!
+ * Discard the correlations of the given result block which cannot be among the
+ * strongest correlations of either gene in their pair. If a gene has more than
+ * k correlations within thresholds in the result block, then a correlation of
+ * that gene which is weaker than the k-th strongest of them cannot be among
+ * the k strongest correlations of the gene overall. A correlation is therefore
+ * discarded if it is weaker than the k-th strongest correlation of both of its
+ * genes within the result block. Ties are kept so that the master process can
+ * break them consistently. This function allows each worker to reduce the size
+ * of its result block before it is sent to the master process.
+ *
+ * @param resultBlock
+ */
+void Similarity::pruneTopEdges(ResultBlock* resultBlock) const
+{
+    EDEBUG_FUNC(this,resultBlock);
+
+    // collect the correlations within thresholds for each gene
+    QHash<qint32, QVector<float>> strengths;
+    Pairwise::Index index {resultBlock->start()};
+
+    for ( auto& pair : resultBlock->pairs() )
+    {
+        for ( qint8 k = 0; k < pair.K; ++k )
+        {
+            float corr = pair.correlations[k];
+
+            if ( !isnan(corr) && _minCorrelation <= abs(corr) && abs(corr) <= _maxCorrelation )
+            {
+                strengths[index.getX()].append(abs(corr));
+                strengths[index.getY()].append(abs(corr));
+            }
+        }
+
+        ++index;
+    }
+
+    // determine the k-th strongest correlation of each gene
+    QHash<qint32, float> minimums;
+
+    for ( auto iter = strengths.begin(); iter != strengths.end(); ++iter )
+    {
+        auto& values {iter.value()};
+
+        if ( values.size() > _topK )
+        {
+            std::nth_element(values.begin(), values.begin() + _topK - 1, values.end(), std::greater<float>());
+            minimums.insert(iter.key(), values[_topK - 1]);
+        }
+    }
+
+    // discard correlations which are weaker than both minimums
+    index = Pairwise::Index(resultBlock->start());
+
+    for ( auto& pair : resultBlock->pairs() )
+    {
+        bool isEmpty = true;
+
+        for ( qint8 k = 0; k < pair.K; ++k )
+        {
+            float corr = pair.correlations[k];
+
+            if ( isnan(corr) || abs(corr) < _minCorrelation || _maxCorrelation < abs(corr) )
+            {
+                continue;
+            }
+
+            if ( abs(corr) < minimums.value(index.getX(), 0) && abs(corr) < minimums.value(index.getY(), 0) )
+            {
+                pair.correlations[k] = NAN;
+            }
+            else
+            {
+                isEmpty = false;
+            }
+        }
+
+        // remove the pair data if no correlations remain
+        if ( isEmpty )
+        {
+            pair.K = 0;
+            pair.labels.clear();
+            pair.correlations.clear();
+        }
+
+        ++index;
+    }
+}
+
+
+
+/*!
+ * Add the correlations of the given result block to the heaps of strongest
+ * correlations of each gene. A correlation is added to the heap of each gene
+ * in its pair if the heap is not full or if the correlation is stronger than
+ * the weakest correlation in the heap, which is then removed. The sample mask
+ * of a correlation is only created if it is added to at least one heap, and
+ * the correlation is released once it has been removed from both heaps.
+ *
+ * @param resultBlock
+ */
+void Similarity::appendTopEdges(const ResultBlock* resultBlock)
+{
+    EDEBUG_FUNC(this,resultBlock);
+
+    // determine whether a correlation would be added to the heap of a gene
+    auto accepts = [this] (qint32 gene, float corr, qint64 indent)
+    {
+        auto& heap {_topEdges[gene]};
+
+        return static_cast<int>(heap.size()) < _topK
+            || isStronger(corr, indent, heap.front()->correlation, heap.front()->index.indent(heap.front()->cluster));
+    };
+
+    // add a correlation to the heap of a gene
+    auto compare = [] (const std::shared_ptr<Edge>& a, const std::shared_ptr<Edge>& b)
+    {
+        return isStronger(a->correlation, a->index.indent(a->cluster), b->correlation, b->index.indent(b->cluster));
+    };
+
+    auto push = [this, &compare] (qint32 gene, const std::shared_ptr<Edge>& edge)
+    {
+        auto& heap {_topEdges[gene]};
+
+        if ( static_cast<int>(heap.size()) == _topK )
+        {
+            std::pop_heap(heap.begin(), heap.end(), compare);
+            heap.pop_back();
+        }
+
+        heap.push_back(edge);
+        std::push_heap(heap.begin(), heap.end(), compare);
+    };
+
+    // iterate through all pairs in result block
+    Pairwise::Index index {resultBlock->start()};
+
+    for ( auto& pair : resultBlock->pairs() )
+    {
+        for ( qint8 k = 0; k < pair.K; ++k )
+        {
+            // determine whether correlation is within thresholds
+            float corr = pair.correlations[k];
+
+            if ( isnan(corr) || abs(corr) < _minCorrelation || _maxCorrelation < abs(corr) )
+            {
+                continue;
+            }
+
+            // determine whether correlation is among the strongest of either gene
+            qint64 indent {index.indent(k)};
+            bool acceptsX {accepts(index.getX(), corr, indent)};
+            bool acceptsY {accepts(index.getY(), corr, indent)};
+
+            if ( !acceptsX && !acceptsY )
+            {
+                continue;
+            }
+
+            // create correlation with sample mask
+            std::shared_ptr<Edge> edge {new Edge};
+            edge->index = index;
+            edge->cluster = k;
+            edge->correlation = corr;
+            edge->sampleMask.resize(_input->sampleSize());
+
+            for ( int i = 0; i < _input->sampleSize(); ++i )
+            {
+                // convert label format to sample string format
+                edge->sampleMask[i] = (pair.labels[i] >= 0)
+                    ? (k == pair.labels[i])
+                    : -pair.labels[i];
+            }
+
+            // add correlation to heaps
+            if ( acceptsX )
+            {
+                push(index.getX(), edge);
+            }
+
+            if ( acceptsY )
+            {
+                push(index.getY(), edge);
+            }
+        }
+
+        ++index;
+    }
+}
+
+
+
+/*!
+ * Save the correlations in the heaps of strongest correlations to the output
+ * correlation matrix and cluster matrix. The correlations of all heaps are
+ * combined, sorted by pairwise index and cluster, and saved in that order.
+ */
+void Similarity::writeTopEdges()
+{
+    EDEBUG_FUNC(this);
+
+    // combine the correlations of all heaps
+    std::vector<Edge*> edges;
+
+    for ( auto& heap : _topEdges )
+    {
+        for ( auto& edge : heap )
+        {
+            edges.push_back(edge.get());
+        }
+    }
+
+    // sort correlations by pairwise index and cluster and remove duplicates
+    std::sort(edges.begin(), edges.end(), [] (const Edge* a, const Edge* b)
+    {
+        return a->index.indent(a->cluster) < b->index.indent(b->cluster);
+    });
+
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    // save the correlations of each pair
+    for ( size_t i = 0; i < edges.size(); )
+    {
+        Pairwise::Index index {edges[i]->index};
+        CCMatrix::Pair ccmPair(_ccm);
+        CorrelationMatrix::Pair cmxPair(_cmx);
+
+        for ( ; i < edges.size() && edges[i]->index == index; ++i )
+        {
+            int cluster = ccmPair.clusterSize();
+
+            ccmPair.addCluster();
+            cmxPair.addCluster();
+
+            for ( int j = 0; j < _input->sampleSize(); ++j )
+            {
+                ccmPair.at(cluster, j) = edges[i]->sampleMask[j];
+            }
+
+            cmxPair.at(cluster) = edges[i]->correlation;
+        }
+
+        ccmPair.write(mapIndex(index));
+        cmxPair.write(mapIndex(index));
+
+        if ( _summary )
+        {
+            _summary->add(mapIndex(index), cmxPair);
+        }
+    }
+
+    // release the heaps
+    _topEdges.clear();
+}
+
+
+
+/*!
+ * Save the threshold summary of the output correlation matrix if it was
+ * requested, along with the content hash of the matrix.
+ */
+void Similarity::writeSummary()
+{
+    EDEBUG_FUNC(this);
+
+    if ( _summary )
+    {
+        _summary->setHash(_cmx->contentHash());
+        _summary->save(_summaryFileName);
+    }
+}
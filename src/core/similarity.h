@@ -1,11 +1,14 @@
 #ifndef SIMILARITY_H
 #define SIMILARITY_H
 #include <ace/core/core.h>
+#include <QMutex>
+#include <QUuid>
 
 #include "ccmatrix.h"
 #include "correlationmatrix.h"
 #include "expressionmatrix.h"
 #include "pairwise_clusteringmodel.h"
+#include "thresholdsummary.h"
 
 
 
@@ -53,10 +56,12 @@ public:
     class Serial;
     class OpenCL;
     class CUDA;
+    class Shard;
 public:
     static int nextPower2(int n);
     static qint64 totalPairs(const ExpressionMatrix* emx);
 public:
+    virtual ~Similarity();
     virtual int size() const override final;
     virtual std::unique_ptr<EAbstractAnalyticBlock> makeWork(int index) const override final;
     virtual std::unique_ptr<EAbstractAnalyticBlock> makeWork() const override final;
@@ -69,6 +74,20 @@ public:
     virtual void initialize() override final;
     virtual void initializeOutputs() override final;
 private:
+    /*!
+     * Defines the work block schedules this analytic supports.
+     */
+    enum class BlockSchedule
+    {
+        /*!
+         * Every work block has the same size
+         */
+        Static
+        /*!
+         * Work blocks shrink as the remaining work decreases
+         */
+        ,Factoring
+    };
     /*!
      * Defines the clustering methods this analytic supports.
      */
@@ -97,6 +116,43 @@ private:
          */
         ,Spearman
     };
+    /*!
+     * Defines a correlation which is kept by the top-k mode until all
+     * results have been processed.
+     */
+    struct Edge
+    {
+        /*!
+         * The pairwise index of the pair.
+         */
+        Pairwise::Index index;
+        /*!
+         * The cluster index within the pair.
+         */
+        qint8 cluster;
+        /*!
+         * The correlation of the cluster.
+         */
+        float correlation;
+        /*!
+         * The sample mask of the cluster.
+         */
+        QVector<qint8> sampleMask;
+    };
+private:
+    static bool isStronger(float a, qint64 indentA, float b, qint64 indentB);
+    void initializeGenes();
+    void initializeWorkBlocks();
+    std::vector<float> dumpExpressions() const;
+    qint64 pairSize() const;
+    Pairwise::Index mapIndex(const Pairwise::Index& index) const;
+    void removeShards();
+    void writeShard(ResultBlock* resultBlock, const QUuid& runId);
+    void writeManifest();
+    void pruneTopEdges(ResultBlock* resultBlock) const;
+    void appendTopEdges(const ResultBlock* resultBlock);
+    void writeTopEdges();
+    void writeSummary();
 private:
     /*!
      * Pointer to the input expression matrix.
@@ -150,6 +206,17 @@ private:
      * Whether to remove outliers after clustering.
      */
     bool _removePostOutliers {true};
+    /*!
+     * Whether to exclude genes which cannot produce a correlation before
+     * pairs are enumerated.
+     */
+    bool _preFilter {true};
+    /*!
+     * The index of each gene in the input expression matrix which is used to
+     * enumerate pairs, in increasing order. Work blocks and result blocks use
+     * pairwise indices into this list of genes.
+     */
+    QVector<qint32> _genes;
     /*!
      * The minimum (absolute) correlation threshold to save a correlation.
      */
@@ -158,10 +225,31 @@ private:
      * The maximum (absolute) correlation threshold to save a correlation.
      */
     float _maxCorrelation {1.0};
+    /*!
+     * The number of strongest correlations to keep for each gene. If this
+     * number is zero, every correlation within thresholds is kept.
+     */
+    int _topK {0};
+    /*!
+     * The strongest correlations of each gene that were processed so far,
+     * stored as a heap with the weakest correlation at the front. Each
+     * correlation is shared by the heaps of both genes of its pair. Only the
+     * master process uses this list.
+     */
+    std::vector<std::vector<std::shared_ptr<Edge>>> _topEdges;
     /*!
      * The number of pairs to process in each work block.
      */
     int _workBlockSize {0};
+    /*!
+     * The schedule used to divide pairs into work blocks.
+     */
+    BlockSchedule _blockSchedule {BlockSchedule::Factoring};
+    /*!
+     * The starting pairwise index of each work block, followed by the total
+     * number of pairs. Only the master process uses this list.
+     */
+    std::vector<qint64> _blockStarts;
     /*!
      * The global work size for each OpenCL worker.
      */
@@ -170,6 +258,37 @@ private:
      * The local work size for each OpenCL worker.
      */
     int _localWorkSize {32};
+    /*!
+     * The file name prefix of the shard files. If this prefix is not empty,
+     * each process writes its results to its own shard file instead of
+     * sending them to the master process.
+     */
+    QString _shardPrefix;
+    /*!
+     * The run id which is stored in the shard files and the manifest of this
+     * run. It is generated by the master process and sent to the other
+     * processes with each work block.
+     */
+    QUuid _runId;
+    /*!
+     * The shard file of this process, which is created when the first
+     * result block is written.
+     */
+    std::unique_ptr<Shard> _shard;
+    /*!
+     * Mutex used to serialize writes to the shard file from multiple workers.
+     */
+    QMutex _shardMutex;
+    /*!
+     * The path of the threshold summary file, or an empty string if the
+     * threshold summary is not saved.
+     */
+    QString _summaryFileName;
+    /*!
+     * The threshold summary of the output correlation matrix, which is
+     * updated as each pair is written.
+     */
+    std::unique_ptr<ThresholdSummary> _summary;
 };
 
 
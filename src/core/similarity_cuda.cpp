@@ -56,7 +56,7 @@ void Similarity::CUDA::initialize()
     _program = new ::CUDA::Program(paths, this);
 
     // create buffer for expression data
-    std::vector<float> rawData = _base->_input->dumpRawData();
+    std::vector<float> rawData = _base->dumpExpressions();
     _expressions = ::CUDA::Buffer<float>(rawData.size());
 
     // copy expression data to device
@@ -43,6 +43,19 @@ const QStringList Similarity::Input::CRITERION_NAMES
 
 
 
+/*!
+ * String list of work block schedules for this analytic that correspond exactly
+ * to its enumeration. Used for handling the work block schedule argument for
+ * this input object.
+ */
+const QStringList Similarity::Input::SCHEDULE_NAMES
+{
+    "static"
+    ,"factoring"
+};
+
+
+
 /*!
  * Construct a new input object with the given analytic as its parent.
  *
@@ -92,11 +105,16 @@ EAbstractAnalyticInput::Type Similarity::Input::type(int index) const
     case CriterionType: return Type::Selection;
     case RemovePreOutliers: return Type::Boolean;
     case RemovePostOutliers: return Type::Boolean;
+    case PreFilter: return Type::Boolean;
     case MinCorrelation: return Type::Double;
     case MaxCorrelation: return Type::Double;
+    case TopK: return Type::Integer;
     case WorkBlockSize: return Type::Integer;
+    case WorkBlockSchedule: return Type::Selection;
     case GlobalWorkSize: return Type::Integer;
     case LocalWorkSize: return Type::Integer;
+    case ShardPrefix: return Type::String;
+    case SummaryFile: return Type::String;
     default: return Type::Boolean;
     }
 }
@@ -234,6 +252,15 @@ QVariant Similarity::Input::data(int index, Role role) const
         case Role::Default: return true;
         default: return QVariant();
         }
+    case PreFilter:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("prefilter");
+        case Role::Title: return tr("Pre-filter genes:");
+        case Role::WhatsThis: return tr("Whether to exclude genes with fewer than the minimum number of samples above the minimum expression, or with zero variance over those samples, before pairs are enumerated. These genes cannot produce a correlation, so the output is the same as without the pre-filter.");
+        case Role::Default: return true;
+        default: return QVariant();
+        }
     case MinCorrelation:
         switch (role)
         {
@@ -256,17 +283,38 @@ QVariant Similarity::Input::data(int index, Role role) const
         case Role::Maximum: return 1;
         default: return QVariant();
         }
+    case TopK:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("topk");
+        case Role::Title: return tr("Top-k Correlations:");
+        case Role::WhatsThis: return tr("Number of strongest correlations (absolute value) to save for each gene. A correlation is saved if it is among the strongest correlations of either gene in the pair. Set to 0 to save every correlation within thresholds.");
+        case Role::Default: return 0;
+        case Role::Minimum: return 0;
+        case Role::Maximum: return std::numeric_limits<int>::max();
+        default: return QVariant();
+        }
     case WorkBlockSize:
         switch (role)
         {
         case Role::CommandLineName: return QString("bsize");
         case Role::Title: return tr("Work Block Size:");
-        case Role::WhatsThis: return tr("Number of pairs to process in each work block.");
+        case Role::WhatsThis: return tr("Number of pairs to process in each work block. With the factoring schedule this is the size of the largest work block.");
         case Role::Default: return 0;
         case Role::Minimum: return 0;
         case Role::Maximum: return std::numeric_limits<int>::max();
         default: return QVariant();
         }
+    case WorkBlockSchedule:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("bschedule");
+        case Role::Title: return tr("Work Block Schedule:");
+        case Role::WhatsThis: return tr("Method to use for dividing pairs into work blocks. The static schedule uses the same size for every work block, while the factoring schedule uses smaller work blocks as the remaining work decreases.");
+        case Role::SelectionValues: return SCHEDULE_NAMES;
+        case Role::Default: return "factoring";
+        default: return QVariant();
+        }
     case GlobalWorkSize:
         switch (role)
         {
@@ -289,6 +337,24 @@ QVariant Similarity::Input::data(int index, Role role) const
         case Role::Maximum: return std::numeric_limits<int>::max();
         default: return QVariant();
         }
+    case ShardPrefix:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("shards");
+        case Role::Title: return tr("Shard Prefix:");
+        case Role::WhatsThis: return tr("File name prefix of the shard files. If provided, each process writes its results to its own shard file instead of sending them to the master process, and the output matrices are left empty. Existing shard files with this prefix are removed when the run starts, and a manifest of the shard files is written when it finishes. Use the merge-shards analytic to combine the shard files into the output matrices.");
+        case Role::Default: return QString();
+        default: return QVariant();
+        }
+    case SummaryFile:
+        switch (role)
+        {
+        case Role::CommandLineName: return QString("summary");
+        case Role::Title: return tr("Threshold Summary File:");
+        case Role::WhatsThis: return tr("Binary file in which to save a summary of the output correlation matrix, which contains the maximum absolute correlation of each gene and histograms of the absolute correlations. The summary can be given to the rmt and powerlaw analytics to speed up thresholding.");
+        case Role::Default: return QString();
+        default: return QVariant();
+        }
     default: return QVariant();
     }
 }
@@ -335,21 +401,36 @@ void Similarity::Input::set(int index, const QVariant& value)
     case RemovePostOutliers:
         _base->_removePostOutliers = value.toBool();
         break;
+    case PreFilter:
+        _base->_preFilter = value.toBool();
+        break;
     case MinCorrelation:
         _base->_minCorrelation = value.toFloat();
         break;
     case MaxCorrelation:
         _base->_maxCorrelation = value.toFloat();
         break;
+    case TopK:
+        _base->_topK = value.toInt();
+        break;
     case WorkBlockSize:
         _base->_workBlockSize = value.toInt();
         break;
+    case WorkBlockSchedule:
+        _base->_blockSchedule = static_cast<BlockSchedule>(SCHEDULE_NAMES.indexOf(value.toString()));
+        break;
     case GlobalWorkSize:
         _base->_globalWorkSize = value.toInt();
         break;
     case LocalWorkSize:
         _base->_localWorkSize = value.toInt();
         break;
+    case ShardPrefix:
+        _base->_shardPrefix = value.toString();
+        break;
+    case SummaryFile:
+        _base->_summaryFileName = value.toString();
+        break;
     }
 }
 
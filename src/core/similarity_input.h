@@ -28,11 +28,16 @@ public:
         ,CriterionType
         ,RemovePreOutliers
         ,RemovePostOutliers
+        ,PreFilter
         ,MinCorrelation
         ,MaxCorrelation
+        ,TopK
         ,WorkBlockSize
+        ,WorkBlockSchedule
         ,GlobalWorkSize
         ,LocalWorkSize
+        ,ShardPrefix
+        ,SummaryFile
         ,Total
     };
     explicit Input(Similarity* parent);
@@ -46,6 +51,7 @@ private:
     static const QStringList CLUSTERING_NAMES;
     static const QStringList CORRELATION_NAMES;
     static const QStringList CRITERION_NAMES;
+    static const QStringList SCHEDULE_NAMES;
     /*!
      * Pointer to the base analytic for this object.
      */
@@ -62,7 +62,7 @@ void Similarity::OpenCL::initialize(::OpenCL::Context* context)
     _queue = new ::OpenCL::CommandQueue(context, context->devices().first(), this);
 
     // create buffer for expression data
-    std::vector<float> rawData = _base->_input->dumpRawData();
+    std::vector<float> rawData = _base->dumpExpressions();
     _expressions = ::OpenCL::Buffer<cl_float>(context,rawData.size());
 
     // copy expression data to device
@@ -164,6 +164,18 @@ std::unique_ptr<EAbstractAnalyticBlock> Similarity::OpenCL::Worker::execute(cons
         _buffers.out_correlations.unmap(_queue);
     }
 
+    // discard correlations which cannot be among the strongest of either gene
+    if ( _base->_topK > 0 )
+    {
+        _base->pruneTopEdges(resultBlock);
+    }
+
+    // write results to shard file if shards are used
+    if ( !_base->_shardPrefix.isEmpty() )
+    {
+        _base->writeShard(resultBlock, workBlock->runId());
+    }
+
     // return result block
     return unique_ptr<EAbstractAnalyticBlock>(resultBlock);
 }
@@ -47,7 +47,7 @@ Similarity::Serial::Serial(Similarity* parent):
     }
 
     // initialize expression matrix
-    _expressions = _base->_input->dumpRawData();
+    _expressions = _base->dumpExpressions();
 }
 
 
@@ -139,6 +139,18 @@ std::unique_ptr<EAbstractAnalyticBlock> Similarity::Serial::execute(const EAbstr
         ++index;
     }
 
+    // discard correlations which cannot be among the strongest of either gene
+    if ( _base->_topK > 0 )
+    {
+        _base->pruneTopEdges(resultBlock);
+    }
+
+    // write results to shard file if shards are used
+    if ( !_base->_shardPrefix.isEmpty() )
+    {
+        _base->writeShard(resultBlock, workBlock->runId());
+    }
+
     // return result block
     return unique_ptr<EAbstractAnalyticBlock>(resultBlock);
 }
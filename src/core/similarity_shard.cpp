@@ -0,0 +1,329 @@
+#include "similarity_shard.h"
+
+
+
+/*!
+ * Return the file name of the shard file for the given process rank.
+ *
+ * @param prefix
+ * @param rank
+ */
+QString Similarity::Shard::fileName(const QString& prefix, int rank)
+{
+    return QString("%1.%2.shard").arg(prefix).arg(rank);
+}
+
+
+
+/*!
+ * Return the file name of the manifest of the shard files with the given
+ * prefix.
+ *
+ * @param prefix
+ */
+QString Similarity::Shard::manifestName(const QString& prefix)
+{
+    return QString("%1.manifest").arg(prefix);
+}
+
+
+
+/*!
+ * Return the file names of all shard files with the given prefix, including
+ * shard files which were written by other runs. This function is only used to
+ * remove old shard files when a new run starts; the shard files of a finished
+ * run are given by its manifest.
+ *
+ * @param prefix
+ */
+QStringList Similarity::Shard::find(const QString& prefix)
+{
+    QFileInfo info(prefix);
+    QDir dir {info.absoluteDir()};
+    QStringList fileNames;
+
+    for ( auto& entry : dir.entryList({ info.fileName() + ".*.shard" }, QDir::Files, QDir::Name) )
+    {
+        fileNames.append(dir.filePath(entry));
+    }
+
+    return fileNames;
+}
+
+
+
+/*!
+ * Write the manifest of the shard files with the given prefix, replacing any
+ * existing manifest. The manifest contains the run id and the number and names
+ * of the shard files of the run.
+ *
+ * @param prefix
+ * @param manifest
+ */
+void Similarity::Shard::writeManifest(const QString& prefix, const Manifest& manifest)
+{
+    QFile file(manifestName(prefix));
+
+    if ( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(QObject::tr("File IO Error"));
+        e.setDetails(QObject::tr("Could not create shard manifest %1.").arg(file.fileName()));
+        throw e;
+    }
+
+    QDataStream stream(&file);
+    stream << MANIFEST_MAGIC << manifest.runId << static_cast<qint32>(manifest.fileNames.size());
+
+    for ( auto& fileName : manifest.fileNames )
+    {
+        stream << fileName;
+    }
+
+    if ( stream.status() != QDataStream::Ok || !file.flush() )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(QObject::tr("File IO Error"));
+        e.setDetails(QObject::tr("Qt Data Stream encountered an error on shard manifest %1.").arg(file.fileName()));
+        throw e;
+    }
+}
+
+
+
+/*!
+ * Read the manifest of the shard files with the given prefix.
+ *
+ * @param prefix
+ */
+Similarity::Shard::Manifest Similarity::Shard::readManifest(const QString& prefix)
+{
+    QFile file(manifestName(prefix));
+
+    if ( !file.open(QIODevice::ReadOnly) )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(QObject::tr("File IO Error"));
+        e.setDetails(QObject::tr("Could not open shard manifest %1. Make sure that the similarity run with this shard prefix finished.").arg(file.fileName()));
+        throw e;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic;
+    qint32 size;
+    Manifest manifest;
+
+    stream >> magic >> manifest.runId >> size;
+
+    if ( stream.status() != QDataStream::Ok || magic != MANIFEST_MAGIC || size < 0 )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(QObject::tr("File IO Error"));
+        e.setDetails(QObject::tr("%1 is not a shard manifest.").arg(file.fileName()));
+        throw e;
+    }
+
+    for ( int i = 0; i < size; ++i )
+    {
+        QString fileName;
+        stream >> fileName;
+
+        manifest.fileNames.append(fileName);
+    }
+
+    if ( stream.status() != QDataStream::Ok )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(QObject::tr("File IO Error"));
+        e.setDetails(QObject::tr("Shard manifest %1 is truncated.").arg(file.fileName()));
+        throw e;
+    }
+
+    return manifest;
+}
+
+
+
+/*!
+ * Construct a new shard object for the given file name. The file is not
+ * accessed until it is created or opened.
+ *
+ * @param fileName
+ */
+Similarity::Shard::Shard(const QString& fileName):
+    _file(fileName)
+{
+    EDEBUG_FUNC(this,&fileName);
+}
+
+
+
+/*!
+ * Create a new shard file, replacing any existing file, and write the header.
+ *
+ * @param runId
+ * @param geneSize
+ * @param sampleSize
+ * @param maxClusterSize
+ * @param correlationName
+ * @param pairSize
+ */
+void Similarity::Shard::create(const QUuid& runId, qint32 geneSize, qint32 sampleSize, qint32 maxClusterSize, const QString& correlationName, qint64 pairSize)
+{
+    EDEBUG_FUNC(this,&runId,geneSize,sampleSize,maxClusterSize,&correlationName,pairSize);
+
+    // open shard file
+    if ( !_file.open(QIODevice::WriteOnly | QIODevice::Truncate) )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(QObject::tr("File IO Error"));
+        e.setDetails(QObject::tr("Could not create shard file %1.").arg(_file.fileName()));
+        throw e;
+    }
+
+    _stream.setDevice(&_file);
+    _stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    // write header
+    _runId = runId;
+    _geneSize = geneSize;
+    _sampleSize = sampleSize;
+    _maxClusterSize = maxClusterSize;
+    _correlationName = correlationName;
+    _pairSize = pairSize;
+
+    _stream << MAGIC << _runId << _geneSize << _sampleSize << _maxClusterSize << _correlationName << _pairSize;
+
+    checkStatus();
+}
+
+
+
+/*!
+ * Open an existing shard file, read the header, and read the header of every
+ * segment.
+ */
+void Similarity::Shard::open()
+{
+    EDEBUG_FUNC(this);
+
+    // open shard file
+    if ( !_file.open(QIODevice::ReadOnly) )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(QObject::tr("File IO Error"));
+        e.setDetails(QObject::tr("Could not open shard file %1.").arg(_file.fileName()));
+        throw e;
+    }
+
+    _stream.setDevice(&_file);
+    _stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    // read header
+    quint32 magic;
+    _stream >> magic >> _runId >> _geneSize >> _sampleSize >> _maxClusterSize >> _correlationName >> _pairSize;
+
+    if ( magic != MAGIC )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(QObject::tr("File IO Error"));
+        e.setDetails(QObject::tr("%1 is not a similarity shard file.").arg(_file.fileName()));
+        throw e;
+    }
+
+    // read each segment header and skip over the segment data
+    _segments.clear();
+
+    while ( !_stream.atEnd() )
+    {
+        Segment segment;
+        _stream
+            >> segment.index
+            >> segment.start
+            >> segment.size
+            >> segment.pairSize
+            >> segment.clusterSize
+            >> segment.dataSize;
+
+        checkStatus();
+
+        segment.offset = _file.pos();
+        _segments.append(segment);
+
+        _file.seek(segment.offset + segment.dataSize);
+    }
+}
+
+
+
+/*!
+ * Append a segment with the given segment header and data to the end of
+ * this shard file.
+ *
+ * @param segment
+ * @param data
+ */
+void Similarity::Shard::write(Segment segment, const QByteArray& data)
+{
+    EDEBUG_FUNC(this,&segment,&data);
+
+    // write segment header
+    segment.dataSize = data.size();
+
+    _stream
+        << segment.index
+        << segment.start
+        << segment.size
+        << segment.pairSize
+        << segment.clusterSize
+        << segment.dataSize;
+
+    // write segment data
+    segment.offset = _file.pos();
+    _stream.writeRawData(data.constData(), data.size());
+
+    checkStatus();
+
+    // flush so that a partially written shard file contains only whole segments
+    _file.flush();
+    _segments.append(segment);
+}
+
+
+
+/*!
+ * Read the data of the given segment from this shard file.
+ *
+ * @param segment
+ */
+QByteArray Similarity::Shard::read(const Segment& segment)
+{
+    EDEBUG_FUNC(this,&segment);
+
+    QByteArray data(segment.dataSize, 0);
+
+    _file.seek(segment.offset);
+    _stream.readRawData(data.data(), data.size());
+
+    checkStatus();
+
+    return data;
+}
+
+
+
+/*!
+ * Make sure that the last read or write on the shard file succeeded.
+ */
+void Similarity::Shard::checkStatus()
+{
+    EDEBUG_FUNC(this);
+
+    if ( _stream.status() != QDataStream::Ok )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(QObject::tr("File IO Error"));
+        e.setDetails(QObject::tr("Qt Data Stream encountered an error on shard file %1.").arg(_file.fileName()));
+        throw e;
+    }
+}
@@ -0,0 +1,151 @@
+#ifndef SIMILARITY_SHARD_H
+#define SIMILARITY_SHARD_H
+#include "similarity.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QUuid>
+
+
+
+/*!
+ * This class implements the shard file of the similarity analytic. When the
+ * similarity analytic is given a shard prefix, each process writes the pairs
+ * of the work blocks it executes to its own shard file instead of sending them
+ * to the master process. A shard file consists of a header followed by a list
+ * of segments, one for each work block. Each segment contains the pairs of the
+ * work block which have at least one correlation within thresholds, in the same
+ * order in which they would be written to the output matrices. For each pair,
+ * the segment stores the row and column index in the expression matrix, the
+ * number of clusters, and for each cluster the correlation and the packed
+ * sample mask used by the cluster matrix. The merge shards analytic combines
+ * the segments of all shard files in work block order to produce the output
+ * matrices.
+ *
+ * Each similarity run has a random run id which is stored in the header of
+ * every shard file it writes. When the run finishes, the master process writes
+ * a manifest next to the shard files which contains the run id and the names
+ * of the shard files of the run. The merge shards analytic reads only the shard
+ * files listed in the manifest, so shard files left over from other runs with
+ * the same prefix are never merged.
+ */
+class Similarity::Shard
+{
+public:
+    /*!
+     * Defines the header of a segment in a shard file.
+     */
+    struct Segment
+    {
+        /*!
+         * The index of the work block.
+         */
+        qint32 index;
+        /*!
+         * The pairwise index of the first pair in the work block.
+         */
+        qint64 start;
+        /*!
+         * The number of pairs in the work block.
+         */
+        qint64 size;
+        /*!
+         * The number of pairs stored in the segment.
+         */
+        qint64 pairSize;
+        /*!
+         * The number of clusters stored in the segment.
+         */
+        qint64 clusterSize;
+        /*!
+         * The size (in bytes) of the segment data.
+         */
+        qint64 dataSize;
+        /*!
+         * The position of the segment data in the shard file.
+         */
+        qint64 offset;
+    };
+    /*!
+     * Defines the contents of the manifest of a similarity run.
+     */
+    struct Manifest
+    {
+        /*!
+         * The run id of the similarity run.
+         */
+        QUuid runId;
+        /*!
+         * The file names of the shard files of the run, without the directory.
+         */
+        QStringList fileNames;
+    };
+public:
+    static QString fileName(const QString& prefix, int rank);
+    static QString manifestName(const QString& prefix);
+    static QStringList find(const QString& prefix);
+    static void writeManifest(const QString& prefix, const Manifest& manifest);
+    static Manifest readManifest(const QString& prefix);
+    explicit Shard(const QString& fileName);
+    void create(const QUuid& runId, qint32 geneSize, qint32 sampleSize, qint32 maxClusterSize, const QString& correlationName, qint64 pairSize);
+    void open();
+    void write(Segment segment, const QByteArray& data);
+    QByteArray read(const Segment& segment);
+    const QUuid& runId() const { return _runId; }
+    qint32 geneSize() const { return _geneSize; }
+    qint32 sampleSize() const { return _sampleSize; }
+    qint32 maxClusterSize() const { return _maxClusterSize; }
+    const QString& correlationName() const { return _correlationName; }
+    qint64 pairSize() const { return _pairSize; }
+    const QVector<Segment>& segments() const { return _segments; }
+private:
+    void checkStatus();
+    /*!
+     * Identifies a file as a similarity shard file.
+     */
+    constexpr static quint32 MAGIC {0x4b534844};
+    /*!
+     * Identifies a file as a similarity shard manifest.
+     */
+    constexpr static quint32 MANIFEST_MAGIC {0x4b534d46};
+    /*!
+     * The shard file.
+     */
+    QFile _file;
+    /*!
+     * The data stream used to read and write the shard file.
+     */
+    QDataStream _stream;
+    /*!
+     * The run id of the similarity run which wrote the shard file.
+     */
+    QUuid _runId;
+    /*!
+     * The number of genes in the expression matrix.
+     */
+    qint32 _geneSize {0};
+    /*!
+     * The number of samples in each sample mask.
+     */
+    qint32 _sampleSize {0};
+    /*!
+     * The maximum number of clusters allowed for each pair.
+     */
+    qint32 _maxClusterSize {0};
+    /*!
+     * The name of the correlation method.
+     */
+    QString _correlationName;
+    /*!
+     * The total number of pairs enumerated by the similarity analytic, which
+     * the segments of all shard files must cover.
+     */
+    qint64 _pairSize {0};
+    /*!
+     * The list of segments in the shard file.
+     */
+    QVector<Segment> _segments;
+};
+
+
+
+#endif
@@ -4,18 +4,20 @@
 
 /*!
  * Construct a new block with the given index, starting pairwise index,
- * and pair size.
+ * pair size, and run id.
  *
  * @param index
  * @param start
  * @param size
+ * @param runId
  */
-Similarity::WorkBlock::WorkBlock(int index, qint64 start, qint64 size):
+Similarity::WorkBlock::WorkBlock(int index, qint64 start, qint64 size, const QUuid& runId):
     EAbstractAnalyticBlock(index),
     _start(start),
-    _size(size)
+    _size(size),
+    _runId(runId)
 {
-    EDEBUG_FUNC(this,index,start,size);
+    EDEBUG_FUNC(this,index,start,size,&runId);
 }
 
 
@@ -29,7 +31,7 @@ void Similarity::WorkBlock::write(QDataStream& stream) const
 {
     EDEBUG_FUNC(this,&stream);
 
-    stream << _start << _size;
+    stream << _start << _size << _runId;
 }
 
 
@@ -43,5 +45,5 @@ void Similarity::WorkBlock::read(QDataStream& stream)
 {
     EDEBUG_FUNC(this,&stream);
 
-    stream >> _start >> _size;
+    stream >> _start >> _size >> _runId;
 }
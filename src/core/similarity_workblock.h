@@ -1,6 +1,7 @@
 #ifndef SIMILARITY_WORKBLOCK_H
 #define SIMILARITY_WORKBLOCK_H
 #include "similarity.h"
+#include <QUuid>
 
 
 
@@ -15,9 +16,10 @@ public:
      * Construct a new work block in an uninitialized null state.
      */
     explicit WorkBlock() = default;
-    explicit WorkBlock(int index, qint64 start, qint64 size);
+    explicit WorkBlock(int index, qint64 start, qint64 size, const QUuid& runId);
     qint64 start() const { return _start; }
     qint64 size() const { return _size; }
+    const QUuid& runId() const { return _runId; }
 protected:
     virtual void write(QDataStream& stream) const override final;
     virtual void read(QDataStream& stream) override final;
@@ -30,6 +32,10 @@ private:
      * The number of pairs to process.
      */
     qint64 _size;
+    /*!
+     * The run id of the similarity run, which is stored in the shard files.
+     */
+    QUuid _runId;
 };
 
 
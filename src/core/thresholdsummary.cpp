@@ -0,0 +1,245 @@
+#include "thresholdsummary.h"
+#include "correlationmatrix_pair.h"
+#include <algorithm>
+#include <cmath>
+
+
+
+/*!
+ * Initialize an empty summary with the given number of genes and histogram
+ * bins. The content hash is cleared.
+ *
+ * @param geneSize
+ * @param binSize
+ */
+void ThresholdSummary::initialize(qint32 geneSize, qint32 binSize)
+{
+    EDEBUG_FUNC(this,geneSize,binSize);
+
+    _hash.clear();
+    _maximums.assign(geneSize, 0);
+    _correlationCounts.assign(binSize, 0);
+    _edgeCounts.assign(binSize, 0);
+}
+
+
+
+/*!
+ * Add the correlations of a pair to this summary. The row-wise maximum is
+ * updated for the row of the pair, in the same way as the thresholding
+ * analytics compute row-wise maximums from the correlation matrix.
+ *
+ * @param index
+ * @param pair
+ */
+void ThresholdSummary::add(const Pairwise::Index& index, const CorrelationMatrix::Pair& pair)
+{
+    EDEBUG_FUNC(this,&index,&pair);
+
+    float maximum {0};
+
+    for ( int k = 0; k < pair.clusterSize(); ++k )
+    {
+        float correlation {fabsf(pair.at(k))};
+
+        ++_correlationCounts[bin(correlation)];
+        maximum = std::max(maximum, correlation);
+    }
+
+    ++_edgeCounts[bin(maximum)];
+
+    float& rowMaximum = _maximums[index.getX()];
+    rowMaximum = std::max(rowMaximum, maximum);
+}
+
+
+
+/*!
+ * Save this summary to a file.
+ *
+ * @param fileName
+ */
+void ThresholdSummary::save(const QString& fileName) const
+{
+    EDEBUG_FUNC(this,&fileName);
+
+    // open summary file
+    QFile file(fileName);
+
+    if ( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(QObject::tr("File IO Error"));
+        e.setDetails(QObject::tr("Could not create threshold summary file %1.").arg(fileName));
+        throw e;
+    }
+
+    QDataStream stream(&file);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    // write header
+    stream << MAGIC << _hash << geneSize() << binSize();
+
+    // write row-wise maximums and histograms
+    for ( float maximum : _maximums )
+    {
+        stream << maximum;
+    }
+
+    for ( qint32 i = 0; i < binSize(); ++i )
+    {
+        stream << _correlationCounts[i] << _edgeCounts[i];
+    }
+
+    if ( stream.status() != QDataStream::Ok )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(QObject::tr("File IO Error"));
+        e.setDetails(QObject::tr("Qt Data Stream encountered an error on threshold summary file %1.").arg(fileName));
+        throw e;
+    }
+}
+
+
+
+/*!
+ * Load this summary from a file.
+ *
+ * @param fileName
+ */
+void ThresholdSummary::load(const QString& fileName)
+{
+    EDEBUG_FUNC(this,&fileName);
+
+    // open summary file
+    QFile file(fileName);
+
+    if ( !file.open(QIODevice::ReadOnly) )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(QObject::tr("File IO Error"));
+        e.setDetails(QObject::tr("Could not open threshold summary file %1.").arg(fileName));
+        throw e;
+    }
+
+    QDataStream stream(&file);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    // read header
+    quint32 magic;
+    QByteArray hash;
+    qint32 geneSize;
+    qint32 binSize;
+
+    stream >> magic >> hash >> geneSize >> binSize;
+
+    if ( stream.status() != QDataStream::Ok || magic != MAGIC || geneSize < 0 || binSize <= 0 )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(QObject::tr("File IO Error"));
+        e.setDetails(QObject::tr("%1 is not a threshold summary file.").arg(fileName));
+        throw e;
+    }
+
+    // read row-wise maximums and histograms
+    initialize(geneSize, binSize);
+    _hash = hash;
+
+    for ( float& maximum : _maximums )
+    {
+        stream >> maximum;
+    }
+
+    for ( qint32 i = 0; i < binSize; ++i )
+    {
+        stream >> _correlationCounts[i] >> _edgeCounts[i];
+    }
+
+    if ( stream.status() != QDataStream::Ok )
+    {
+        E_MAKE_EXCEPTION(e);
+        e.setTitle(QObject::tr("File IO Error"));
+        e.setDetails(QObject::tr("Qt Data Stream encountered an error on threshold summary file %1.").arg(fileName));
+        throw e;
+    }
+}
+
+
+
+/*!
+ * Return the number of genes whose row-wise maximum is at least the given
+ * threshold, which is the number of genes in the network at the threshold.
+ *
+ * @param threshold
+ */
+int ThresholdSummary::geneCount(float threshold) const
+{
+    EDEBUG_FUNC(this,threshold);
+
+    return std::count_if(_maximums.begin(), _maximums.end(), [threshold] (float maximum)
+    {
+        return maximum >= threshold;
+    });
+}
+
+
+
+/*!
+ * Return an upper bound on the number of pairs whose maximum absolute
+ * correlation is at least the given threshold, which is the sum of the pair
+ * histogram from the bin of the threshold.
+ *
+ * @param threshold
+ */
+qint64 ThresholdSummary::edgeCount(float threshold) const
+{
+    EDEBUG_FUNC(this,threshold);
+
+    qint64 count {0};
+
+    for ( qint32 i = bin(threshold); i < binSize(); ++i )
+    {
+        count += _edgeCounts[i];
+    }
+
+    return count;
+}
+
+
+
+/*!
+ * Return an upper bound on the number of correlations whose absolute value is
+ * at least the given threshold, which is the sum of the correlation histogram
+ * from the bin of the threshold.
+ *
+ * @param threshold
+ */
+qint64 ThresholdSummary::correlationCount(float threshold) const
+{
+    EDEBUG_FUNC(this,threshold);
+
+    qint64 count {0};
+
+    for ( qint32 i = bin(threshold); i < binSize(); ++i )
+    {
+        count += _correlationCounts[i];
+    }
+
+    return count;
+}
+
+
+
+/*!
+ * Return the histogram bin of the given absolute correlation.
+ *
+ * @param correlation
+ */
+int ThresholdSummary::bin(float correlation) const
+{
+    EDEBUG_FUNC(this,correlation);
+
+    int i = static_cast<int>(correlation * binSize());
+
+    return std::min(std::max(i, 0), binSize() - 1);
+}
@@ -0,0 +1,68 @@
+#ifndef THRESHOLDSUMMARY_H
+#define THRESHOLDSUMMARY_H
+#include <ace/core/core.h>
+#include "correlationmatrix.h"
+
+
+
+/*!
+ * This class implements the threshold summary of a correlation matrix, which
+ * is produced by the similarity analytic as it writes the correlation matrix
+ * and can be used by the thresholding analytics to avoid scanning the
+ * correlation matrix for simple statistics. The summary contains the row-wise
+ * maximum absolute correlation of each gene, a histogram of the absolute
+ * values of all correlations, and a histogram of the maximum absolute
+ * correlation of each pair, which gives an upper bound on the number of edges
+ * of the network at any threshold with any reduction method. Both histograms
+ * divide the range [0, 1] into bins of equal width. The row-wise maximums are
+ * taken over every cluster, as in CorrelationMatrix::dumpCompactData(), so
+ * they do not depend on the reduction method either. The summary also
+ * contains the content hash of its correlation matrix, so that it is only used
+ * with the matrix from which it was produced.
+ */
+class ThresholdSummary
+{
+public:
+    void initialize(qint32 geneSize, qint32 binSize = DEFAULT_BIN_SIZE);
+    void add(const Pairwise::Index& index, const CorrelationMatrix::Pair& pair);
+    void setHash(const QByteArray& hash) { _hash = hash; }
+    void save(const QString& fileName) const;
+    void load(const QString& fileName);
+    const QByteArray& hash() const { return _hash; }
+    qint32 geneSize() const { return _maximums.size(); }
+    qint32 binSize() const { return _correlationCounts.size(); }
+    const std::vector<float>& maximums() const { return _maximums; }
+    int geneCount(float threshold) const;
+    qint64 edgeCount(float threshold) const;
+    qint64 correlationCount(float threshold) const;
+private:
+    int bin(float correlation) const;
+    /*!
+     * The default number of histogram bins.
+     */
+    constexpr static qint32 DEFAULT_BIN_SIZE {1000};
+    /*!
+     * Identifies a file as a threshold summary file.
+     */
+    constexpr static quint32 MAGIC {0x4b54534d};
+    /*!
+     * The content hash of the correlation matrix of this summary.
+     */
+    QByteArray _hash;
+    /*!
+     * The maximum absolute correlation of each row of the correlation matrix.
+     */
+    std::vector<float> _maximums;
+    /*!
+     * The number of correlations in each bin of absolute correlation.
+     */
+    std::vector<qint64> _correlationCounts;
+    /*!
+     * The number of pairs in each bin of maximum absolute correlation.
+     */
+    std::vector<qint64> _edgeCounts;
+};
+
+
+
+#endif
@@ -28,13 +28,29 @@ float Spearman_computeCluster(
 {
     // extract samples in pairwise cluster
     int n = 0;
+    float x_0 = 0;
+    float y_0 = 0;
+    bool isConstantX = true;
+    bool isConstantY = true;
 
     for ( int i = 0; i < sampleSize; ++i )
     {
         if ( labels[i] == cluster )
         {
-            x_rank[n] = x[i];
-            y_rank[n] = y[i];
+            float x_i = x[i];
+            float y_i = y[i];
+
+            if ( n == 0 )
+            {
+                x_0 = x_i;
+                y_0 = y_i;
+            }
+
+            isConstantX = isConstantX && (x_i == x_0);
+            isConstantY = isConstantY && (y_i == y_0);
+
+            x_rank[n] = x_i;
+            y_rank[n] = y_i;
             ++n;
         }
     }
@@ -48,10 +64,11 @@ float Spearman_computeCluster(
         y_rank[i] = INFINITY;
     }
 
-    // compute correlation only if there are enough samples
+    // compute correlation only if there are enough samples and neither gene
+    // is constant, since the correlation of a constant gene is undefined
     float result = NAN;
 
-    if ( n >= minSamples )
+    if ( n >= minSamples && !isConstantX && !isConstantY )
     {
         // compute rank of x
         bitonicSortFF(N_pow2, x_rank, y_rank);
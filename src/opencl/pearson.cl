@@ -26,6 +26,10 @@ float Pearson_computeCluster(
     float sumx2 = 0;
     float sumy2 = 0;
     float sumxy = 0;
+    float x_0 = 0;
+    float y_0 = 0;
+    bool isConstantX = true;
+    bool isConstantY = true;
 
     for ( int i = 0; i < sampleSize; ++i )
     {
@@ -34,6 +38,15 @@ float Pearson_computeCluster(
             float x_i = x[i];
             float y_i = y[i];
 
+            if ( n == 0 )
+            {
+                x_0 = x_i;
+                y_0 = y_i;
+            }
+
+            isConstantX = isConstantX && (x_i == x_0);
+            isConstantY = isConstantY && (y_i == y_0);
+
             sumx += x_i;
             sumy += y_i;
             sumx2 += x_i * x_i;
@@ -44,10 +57,11 @@ float Pearson_computeCluster(
         }
     }
 
-    // compute correlation only if there are enough samples
+    // compute correlation only if there are enough samples and neither gene
+    // is constant, since the correlation of a constant gene is undefined
     float result = NAN;
 
-    if ( n >= minSamples )
+    if ( n >= minSamples && !isConstantX && !isConstantY )
     {
         result = (n*sumxy - sumx*sumy) / sqrt((n*sumx2 - sumx*sumx) * (n*sumy2 - sumy*sumy));
     }
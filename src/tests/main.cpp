@@ -1,10 +1,12 @@
 #include "../core/analyticfactory.h"
 #include "../core/datafactory.h"
 #include "testclustermatrix.h"
+#include "testconditionaltest.h"
 #include "testcorrelationmatrix.h"
 #include "testexportcorrelationmatrix.h"
 #include "testexportexpressionmatrix.h"
 #include "testexpressionmatrix.h"
+#include "testextract.h"
 #include "testimportcorrelationmatrix.h"
 #include "testimportexpressionmatrix.h"
 #include "testrmt.h"
@@ -29,14 +31,16 @@ int main(int argc, char **argv)
 	try
 	{
 		ASSERT_TEST(new TestClusterMatrix);
+		ASSERT_TEST(new TestConditionalTest);
 		ASSERT_TEST(new TestCorrelationMatrix);
 		// ASSERT_TEST(new TestExportCorrelationMatrix);
 		// ASSERT_TEST(new TestExportExpressionMatrix);
 		ASSERT_TEST(new TestExpressionMatrix);
+		ASSERT_TEST(new TestExtract);
 		// ASSERT_TEST(new TestImportCorrelationMatrix);
 		// ASSERT_TEST(new TestImportExpressionMatrix);
-		// ASSERT_TEST(new TestRMT);
-		// ASSERT_TEST(new TestSimilarity);
+		ASSERT_TEST(new TestRMT);
+		ASSERT_TEST(new TestSimilarity);
 	}
 	catch ( EException& e )
 	{
@@ -0,0 +1,255 @@
+#include <ace/core/core.h>
+#include <ace/core/ace_dataobject.h>
+#include <gsl/gsl_cdf.h>
+#include <gsl/gsl_multifit.h>
+#include <gsl/gsl_statistics_double.h>
+#include <random>
+
+#include "testconditionaltest.h"
+#include "testutils.h"
+#include "../core/analyticfactory.h"
+#include "../core/datafactory.h"
+#include "../core/conditionaltest_input.h"
+#include "../core/ccmatrix.h"
+#include "../core/ccmatrix_pair.h"
+#include "../core/correlationmatrix.h"
+#include "../core/correlationmatrix_pair.h"
+#include "../core/conditionspecificclustersmatrix.h"
+#include "../core/conditionspecificclustersmatrix_pair.h"
+
+
+
+/*!
+ * Fit the regression model [1, x, y, x * y] of the conditional test to the
+ * given responses with the least-squares solver of GSL, and compute the
+ * p-value and r-squared value of the fit in the same way as the analytic.
+ *
+ * @param x
+ * @param y
+ * @param responses
+ * @param pValue
+ * @param r2
+ */
+void TestConditionalTest::computeRegression(const QVector<float>& x, const QVector<float>& y, const QVector<double>& responses, double* pValue, double* r2)
+{
+	int n = responses.size();
+	gsl_matrix* X {gsl_matrix_alloc(n, 4)};
+	gsl_vector* Y {gsl_vector_alloc(n)};
+	gsl_vector* C {gsl_vector_alloc(4)};
+	gsl_matrix* cov {gsl_matrix_alloc(4, 4)};
+	gsl_multifit_linear_workspace* work {gsl_multifit_linear_alloc(n, 4)};
+
+	for ( int i = 0; i < n; ++i )
+	{
+		gsl_matrix_set(X, i, 0, 1);
+		gsl_matrix_set(X, i, 1, x[i]);
+		gsl_matrix_set(X, i, 2, y[i]);
+		gsl_matrix_set(X, i, 3, static_cast<double>(x[i]) * y[i]);
+		gsl_vector_set(Y, i, responses[i]);
+	}
+
+	double chisq;
+	gsl_multifit_linear(X, Y, C, cov, &chisq, work);
+
+	*r2 = 1 - chisq / gsl_stats_tss(responses.constData(), 1, n);
+	*pValue = 1 - gsl_cdf_fdist_P(*r2 * (n - 2) / (1 - *r2), 1, n - 2);
+
+	gsl_multifit_linear_free(work);
+	gsl_matrix_free(cov);
+	gsl_vector_free(C);
+	gsl_vector_free(Y);
+	gsl_matrix_free(X);
+}
+
+
+
+void TestConditionalTest::testRegression()
+{
+	// create random expression data with a fixed seed
+	int numGenes = 2;
+	int numSamples = 40;
+	std::minstd_rand generator(1);
+	std::normal_distribution<float> distribution(0, 1);
+	QVector<float> expressions(numGenes * numSamples);
+
+	for ( int i = 0; i < expressions.size(); ++i )
+	{
+		expressions[i] = 5.0f + distribution(generator);
+	}
+
+	QString emxPath {QDir::tempPath() + "/conditionaltest.emx"};
+
+	TestUtils::createExpressionMatrix(emxPath, numGenes, numSamples, expressions);
+
+	// create an annotation matrix with a quantitative feature which depends
+	// on both genes and their interaction, an ordinal feature with three
+	// levels and a categorical feature with two labels
+	QString amxPath {QDir::tempPath() + "/conditionaltest.txt"};
+	QVector<float> geneX(numSamples);
+	QVector<float> geneY(numSamples);
+	QVector<double> quantitative(numSamples);
+	QVector<int> ordinal(numSamples);
+
+	{
+		QFile file(amxPath);
+		QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+
+		QTextStream stream(&file);
+		stream << "Sample\tquantitative\tordinal\tcategorical\n";
+
+		for ( int i = 0; i < numSamples; ++i )
+		{
+			geneX[i] = expressions[1 * numSamples + i];
+			geneY[i] = expressions[0 * numSamples + i];
+
+			double noise {3.0 * distribution(generator)};
+			double value {2.0 + 0.5 * geneX[i] - 0.3 * geneY[i] + 0.2 * geneX[i] * geneY[i] + noise};
+			QString text {QString::number(value, 'f', 3)};
+
+			quantitative[i] = text.toFloat();
+			ordinal[i] = (value < 8) ? 7 : (value < 10) ? 1 : 3;
+
+			stream
+				<< i
+				<< "\t" << text
+				<< "\t" << ordinal[i]
+				<< "\t" << ((i % 3 == 0) ? "a" : "b")
+				<< "\n";
+		}
+	}
+
+	// create a cluster matrix and a correlation matrix with one pair, which
+	// has a cluster of the even samples and a cluster of the odd samples
+	QVector<QVector<bool>> clusters(2, QVector<bool>(numSamples));
+
+	for ( int i = 0; i < numSamples; ++i )
+	{
+		clusters[0][i] = (i % 2 == 0);
+		clusters[1][i] = (i % 2 == 1);
+	}
+
+	EMetaArray metaGeneNames;
+	for ( int i = 0; i < numGenes; ++i )
+	{
+		metaGeneNames.append(QString::number(i));
+	}
+
+	EMetaArray metaSampleNames;
+	for ( int i = 0; i < numSamples; ++i )
+	{
+		metaSampleNames.append(QString::number(i));
+	}
+
+	QString ccmPath {QDir::tempPath() + "/conditionaltest.ccm"};
+	QString cmxPath {QDir::tempPath() + "/conditionaltest.cmx"};
+	QString csmPath {QDir::tempPath() + "/conditionaltest.csm"};
+
+	QFile(ccmPath).remove();
+	QFile(cmxPath).remove();
+
+	{
+		std::unique_ptr<Ace::DataObject> ccmDataRef {new Ace::DataObject(ccmPath, DataFactory::CCMatrixType, EMetaObject())};
+		std::unique_ptr<Ace::DataObject> cmxDataRef {new Ace::DataObject(cmxPath, DataFactory::CorrelationMatrixType, EMetaObject())};
+		CCMatrix* ccm {ccmDataRef->data()->cast<CCMatrix>()};
+		CorrelationMatrix* cmx {cmxDataRef->data()->cast<CorrelationMatrix>()};
+
+		ccm->initialize(metaGeneNames, clusters.size(), metaSampleNames);
+		cmx->initialize(metaGeneNames, clusters.size(), "pearson");
+
+		CCMatrix::Pair ccmPair(ccm);
+		CorrelationMatrix::Pair cmxPair(cmx);
+
+		ccmPair.addCluster(clusters.size());
+		cmxPair.addCluster(clusters.size());
+
+		for ( int k = 0; k < clusters.size(); ++k )
+		{
+			for ( int i = 0; i < numSamples; ++i )
+			{
+				ccmPair.at(k, i) = clusters[k][i];
+			}
+
+			cmxPair.at(k) = 0.9f;
+		}
+
+		ccmPair.write(Pairwise::Index(1, 0));
+		cmxPair.write(Pairwise::Index(1, 0));
+
+		ccmDataRef->data()->finish();
+		ccmDataRef->finalize();
+		cmxDataRef->data()->finish();
+		cmxDataRef->finalize();
+	}
+
+	// run analytic
+	TestUtils::runAnalytic(AnalyticFactory::ConditionalTestType,
+	{
+		{ ConditionalTest::Input::EMXINPUT, emxPath },
+		{ ConditionalTest::Input::CCMINPUT, ccmPath },
+		{ ConditionalTest::Input::CMXINPUT, cmxPath },
+		{ ConditionalTest::Input::AMXINPUT, amxPath },
+		{ ConditionalTest::Input::CSMOUT, csmPath },
+		{ ConditionalTest::Input::TEST, "quantitative,ordinal,categorical" }
+	});
+
+	// read the results of the pair
+	std::unique_ptr<Ace::DataObject> csmDataRef {new Ace::DataObject(csmPath)};
+	CSMatrix* csm {csmDataRef->data()->cast<CSMatrix>()};
+	CSMatrix::Pair csmPair(csm);
+
+	QCOMPARE(csm->getTestCount(), 4);
+
+	csmPair.read(Pairwise::Index(1, 0));
+
+	QCOMPARE(csmPair.clusterSize(), clusters.size());
+
+	// verify the regression tests of each cluster against the least-squares
+	// solver of GSL, where the ordinal levels are numbered in the order in
+	// which they appear in the cluster
+	for ( int k = 0; k < clusters.size(); ++k )
+	{
+		QVector<float> x;
+		QVector<float> y;
+		QVector<double> quantitativeResponses;
+		QVector<double> ordinalResponses;
+		QVector<int> levels;
+
+		for ( int i = 0; i < numSamples; ++i )
+		{
+			if ( !clusters[k][i] )
+			{
+				continue;
+			}
+
+			if ( !levels.contains(ordinal[i]) )
+			{
+				levels.append(ordinal[i]);
+			}
+
+			x.append(geneX[i]);
+			y.append(geneY[i]);
+			quantitativeResponses.append(quantitative[i]);
+			ordinalResponses.append(levels.indexOf(ordinal[i]) + 1);
+		}
+
+		for ( int testIndex = 0; testIndex < 2; ++testIndex )
+		{
+			double expectedPValue;
+			double expectedR2;
+
+			computeRegression(x, y, (testIndex == 0) ? quantitativeResponses : ordinalResponses, &expectedPValue, &expectedR2);
+
+			QVERIFY(expectedR2 > 0 && expectedR2 < 1);
+			QVERIFY(fabs(csmPair.pValues(k)[testIndex] - expectedPValue) <= 1e-9);
+			QVERIFY(fabs(csmPair.rSquares(k)[testIndex] - expectedR2) <= 1e-9);
+		}
+
+		// verify that the labels of the categorical feature are not tested
+		// by regression
+		for ( int testIndex = 2; testIndex < 4; ++testIndex )
+		{
+			QVERIFY(csmPair.pValues(k)[testIndex] >= 0 && csmPair.pValues(k)[testIndex] <= 1);
+			QVERIFY(qIsNaN(csmPair.rSquares(k)[testIndex]));
+		}
+	}
+}
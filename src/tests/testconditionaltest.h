@@ -0,0 +1,20 @@
+#ifndef TESTCONDITIONALTEST_H
+#define TESTCONDITIONALTEST_H
+#include <QtTest/QtTest>
+
+
+
+class TestConditionalTest : public QObject
+{
+	Q_OBJECT
+
+private:
+	static void computeRegression(const QVector<float>& x, const QVector<float>& y, const QVector<double>& responses, double* pValue, double* r2);
+
+private slots:
+	void testRegression();
+};
+
+
+
+#endif
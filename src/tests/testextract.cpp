@@ -0,0 +1,458 @@
+#include <ace/core/core.h>
+#include <ace/core/ace_dataobject.h>
+#include <zlib.h>
+
+#include "testextract.h"
+#include "testutils.h"
+#include "../core/analyticfactory.h"
+#include "../core/datafactory.h"
+#include "../core/extract_input.h"
+#include "../core/exportcorrelationmatrix_input.h"
+#include "../core/ccmatrix.h"
+#include "../core/ccmatrix_pair.h"
+#include "../core/correlationmatrix.h"
+#include "../core/correlationmatrix_pair.h"
+
+
+
+/*!
+ * Run the extract analytic on the test network with the given output format
+ * and number of threads. Only the correlations whose absolute value is at
+ * least 0.85 are extracted.
+ *
+ * @param format
+ * @param outputPath
+ * @param numThreads
+ */
+void TestExtract::runExtract(const QString& format, const QString& outputPath, int numThreads)
+{
+	TestUtils::runAnalytic(AnalyticFactory::ExtractType,
+	{
+		{ Extract::Input::ExpressionData, _emxPath },
+		{ Extract::Input::ClusterData, _ccmPath },
+		{ Extract::Input::CorrelationData, _cmxPath },
+		{ Extract::Input::OutputFormatArg, format },
+		{ Extract::Input::OutputFile, outputPath },
+		{ Extract::Input::MinCorrelation, 0.85 },
+		{ Extract::Input::MaxCorrelation, 1.0 },
+		{ Extract::Input::NumThreads, numThreads }
+	});
+}
+
+
+
+/*!
+ * Decompress the given data, which may consist of several gzip members.
+ *
+ * @param data
+ */
+QByteArray TestExtract::uncompress(const QByteArray& data)
+{
+	QByteArray result;
+	z_stream stream {};
+	char buffer[4096];
+
+	// decompress with automatic gzip header detection, and start a new
+	// member at the end of each member
+	inflateInit2(&stream, 16 + MAX_WBITS);
+
+	stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.constData()));
+	stream.avail_in = data.size();
+
+	while ( stream.avail_in > 0 )
+	{
+		stream.next_out = reinterpret_cast<Bytef*>(buffer);
+		stream.avail_out = sizeof(buffer);
+
+		int status {inflate(&stream, Z_NO_FLUSH)};
+
+		if ( status != Z_OK && status != Z_STREAM_END )
+		{
+			break;
+		}
+
+		result.append(buffer, sizeof(buffer) - stream.avail_out);
+
+		if ( status == Z_STREAM_END )
+		{
+			inflateReset(&stream);
+		}
+	}
+
+	inflateEnd(&stream);
+
+	return result;
+}
+
+
+
+void TestExtract::initTestCase()
+{
+	// create expression data in which gene 0 is missing sample 2
+	int numGenes = 4;
+	int numSamples = 4;
+	QVector<float> expressions(numGenes * numSamples);
+
+	for ( int i = 0; i < expressions.size(); ++i )
+	{
+		expressions[i] = i + 1;
+	}
+
+	expressions[0 * numSamples + 2] = NAN;
+
+	_emxPath = QDir::tempPath() + "/extract.emx";
+
+	TestUtils::createExpressionMatrix(_emxPath, numGenes, numSamples, expressions);
+
+	// create correlation data with exactly representable correlations, in
+	// which pair (2, 0) is below the minimum correlation
+	QVector<Pair> testPairs
+	{
+		{ { 1, 0 }, { { 1, 1, 0, 1 } }, { 0.875f } },
+		{ { 2, 0 }, { { 1, 1, 1, 1 } }, { 0.5f } },
+		{ { 2, 1 }, { { 1, 0, 1, 0 }, { 0, 1, 0, 1 } }, { -0.9375f, 0.90625f } },
+		{ { 3, 2 }, { { 1, 1, 1, 1 } }, { 1.0f } }
+	};
+
+	// create metadata
+	EMetaArray metaGeneNames;
+	for ( int i = 0; i < numGenes; ++i )
+	{
+		metaGeneNames.append(QString::number(i));
+	}
+
+	EMetaArray metaSampleNames;
+	for ( int i = 0; i < numSamples; ++i )
+	{
+		metaSampleNames.append(QString::number(i));
+	}
+
+	// create cluster matrix and correlation matrix
+	_ccmPath = QDir::tempPath() + "/extract.ccm";
+	_cmxPath = QDir::tempPath() + "/extract.cmx";
+
+	QFile(_ccmPath).remove();
+	QFile(_cmxPath).remove();
+
+	std::unique_ptr<Ace::DataObject> ccmDataRef {new Ace::DataObject(_ccmPath, DataFactory::CCMatrixType, EMetaObject())};
+	std::unique_ptr<Ace::DataObject> cmxDataRef {new Ace::DataObject(_cmxPath, DataFactory::CorrelationMatrixType, EMetaObject())};
+	CCMatrix* ccm {ccmDataRef->data()->cast<CCMatrix>()};
+	CorrelationMatrix* cmx {cmxDataRef->data()->cast<CorrelationMatrix>()};
+
+	ccm->initialize(metaGeneNames, 2, metaSampleNames);
+	cmx->initialize(metaGeneNames, 2, "pearson");
+
+	CCMatrix::Pair ccmPair(ccm);
+	CorrelationMatrix::Pair cmxPair(cmx);
+
+	for ( auto& testPair : testPairs )
+	{
+		ccmPair.clearClusters();
+		ccmPair.addCluster(testPair.correlations.size());
+		cmxPair.clearClusters();
+		cmxPair.addCluster(testPair.correlations.size());
+
+		for ( int k = 0; k < testPair.correlations.size(); ++k )
+		{
+			for ( int i = 0; i < numSamples; ++i )
+			{
+				ccmPair.at(k, i) = testPair.sampleMasks.at(k).at(i);
+			}
+
+			cmxPair.at(k) = testPair.correlations.at(k);
+		}
+
+		ccmPair.write(testPair.index);
+		cmxPair.write(testPair.index);
+	}
+
+	ccmDataRef->data()->finish();
+	ccmDataRef->finalize();
+	cmxDataRef->data()->finish();
+	cmxDataRef->finalize();
+}
+
+
+
+void TestExtract::testText()
+{
+	QString outputPath {QDir::tempPath() + "/extract.txt"};
+
+	// verify the text format with one thread and with several threads
+	QByteArray expected
+	{
+		"Source\tTarget\tSimilarity_Score\tInteraction\tCluster_Index\tCluster_Size\tSamples\n"
+		"1\t0\t0.875\tco\t1\t3\t1101\n"
+		"2\t1\t-0.9375\tco\t1\t2\t1010\n"
+		"2\t1\t0.90625\tco\t2\t2\t0101\n"
+		"3\t2\t1\tco\t1\t4\t1111\n"
+	};
+
+	for ( int numThreads : { 1, 4 } )
+	{
+		runExtract("text", outputPath, numThreads);
+		QCOMPARE(TestUtils::readFile(outputPath), expected);
+	}
+
+	// verify the minimal format with one thread and with several threads
+	QByteArray expectedMinimal
+	{
+		"Source\tTarget\tSimilarity_Score\tCluster_Index\tNum_Clusters\n"
+		"1\t0\t0.875\t1\t1\n"
+		"2\t1\t-0.9375\t1\t2\n"
+		"2\t1\t0.90625\t2\t2\n"
+		"3\t2\t1\t1\t1\n"
+	};
+
+	for ( int numThreads : { 1, 4 } )
+	{
+		runExtract("minimal", outputPath, numThreads);
+		QCOMPARE(TestUtils::readFile(outputPath), expectedMinimal);
+	}
+}
+
+
+
+void TestExtract::testGraphML()
+{
+	QString outputPath {QDir::tempPath() + "/extract.graphml"};
+
+	// the sample masks of pairs with one cluster are taken from the
+	// expression data, in which gene 0 is missing sample 2
+	QByteArray expected
+	{
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\"\n"
+		"         xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"\n"
+		"         xsi:schemaLocation=\"http://graphml.graphdrawing.org/xmlns/1.0/graphml.xsd\">\n"
+		"  <graph id=\"G\" edgedefault=\"undirected\">\n"
+		"    <node id=\"0\"/>\n"
+		"    <node id=\"1\"/>\n"
+		"    <node id=\"2\"/>\n"
+		"    <node id=\"3\"/>\n"
+		"    <edge      source=\"1\"      target=\"0\"      samples=\"1191\"    />\n"
+		"    <edge      source=\"2\"      target=\"1\"      samples=\"1010\"    />\n"
+		"    <edge      source=\"2\"      target=\"1\"      samples=\"0101\"    />\n"
+		"    <edge      source=\"3\"      target=\"2\"      samples=\"1111\"    />\n"
+		"  </graph>\n"
+		"</graphml>\n"
+	};
+
+	for ( int numThreads : { 1, 4 } )
+	{
+		runExtract("graphml", outputPath, numThreads);
+		QCOMPARE(TestUtils::readFile(outputPath), expected);
+	}
+}
+
+
+
+void TestExtract::testBinary()
+{
+	QString outputPath {QDir::tempPath() + "/extract.bin"};
+
+	runExtract("binary", outputPath, 4);
+
+	// read header
+	QFile file(outputPath);
+	QVERIFY(file.open(QIODevice::ReadOnly));
+
+	QDataStream stream(&file);
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+	quint32 magic;
+	quint32 version;
+	qint32 geneSize;
+	qint32 maskSize;
+	qint32 maskBytes;
+	qint32 edgeSize;
+	qint64 edgeCount;
+
+	stream >> magic >> version >> geneSize >> maskSize >> maskBytes >> edgeSize >> edgeCount;
+
+	QCOMPARE(magic, 0x4b424544u);
+	QCOMPARE(version, 1u);
+	QCOMPARE(geneSize, 4);
+	QCOMPARE(maskSize, 4);
+	QCOMPARE(maskBytes, 1);
+	QCOMPARE(edgeSize, 15);
+	QCOMPARE(edgeCount, 4LL);
+
+	// read each edge and verify it against the correlation data, where the
+	// sample mask has one bit per sample starting at the highest bit
+	struct Edge
+	{
+		qint32 source;
+		qint32 target;
+		float similarity;
+		quint8 cluster;
+		quint8 clusterSize;
+		quint8 mask;
+	};
+
+	QVector<Edge> expected
+	{
+		{ 1, 0, 0.875f, 1, 1, 0xD0 },
+		{ 2, 1, -0.9375f, 1, 2, 0xA0 },
+		{ 2, 1, 0.90625f, 2, 2, 0x50 },
+		{ 3, 2, 1.0f, 1, 1, 0xF0 }
+	};
+
+	for ( auto& edge : expected )
+	{
+		Edge actual;
+
+		stream >> actual.source >> actual.target >> actual.similarity >> actual.cluster >> actual.clusterSize >> actual.mask;
+
+		QCOMPARE(actual.source, edge.source);
+		QCOMPARE(actual.target, edge.target);
+		QCOMPARE(actual.similarity, edge.similarity);
+		QCOMPARE(actual.cluster, edge.cluster);
+		QCOMPARE(actual.clusterSize, edge.clusterSize);
+		QCOMPARE(actual.mask, edge.mask);
+	}
+
+	QCOMPARE(stream.status(), QDataStream::Ok);
+	QVERIFY(stream.atEnd());
+
+	// verify the gene table
+	QCOMPARE(TestUtils::readFile(outputPath + ".genes.txt"), QByteArray("0\n1\n2\n3\n"));
+}
+
+
+
+void TestExtract::testCSR()
+{
+	QString outputPath {QDir::tempPath() + "/extract.csr"};
+
+	// the rows of each gene contain both directions of each edge in the
+	// order of the pairs
+	QVector<qint64> expectedOffsets { 0, 1, 4, 7, 8 };
+	QVector<qint32> expectedColumns { 1, 0, 2, 2, 1, 1, 3, 2 };
+	QVector<float> expectedSimilarities { 0.875f, 0.875f, -0.9375f, 0.90625f, -0.9375f, 0.90625f, 1.0f, 1.0f };
+	QVector<quint8> expectedClusters { 1, 1, 1, 2, 1, 2, 1, 1 };
+
+	for ( int numThreads : { 1, 4 } )
+	{
+		runExtract("csr", outputPath, numThreads);
+
+		// read header
+		QFile file(outputPath);
+		QVERIFY(file.open(QIODevice::ReadOnly));
+
+		QDataStream stream(&file);
+		stream.setByteOrder(QDataStream::LittleEndian);
+		stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+		quint32 magic;
+		quint32 version;
+		qint32 geneSize;
+		qint32 reserved;
+		qint64 size;
+
+		stream >> magic >> version >> geneSize >> reserved >> size;
+
+		QCOMPARE(magic, 0x4b435352u);
+		QCOMPARE(version, 1u);
+		QCOMPARE(geneSize, 4);
+		QCOMPARE(reserved, 0);
+		QCOMPARE(size, static_cast<qint64>(expectedColumns.size()));
+
+		// read each array of the adjacency matrix
+		QVector<qint64> offsets(geneSize + 1);
+		QVector<qint32> columns(size);
+		QVector<float> similarities(size);
+		QVector<quint8> clusters(size);
+
+		for ( auto& offset : offsets )
+		{
+			stream >> offset;
+		}
+
+		for ( auto& column : columns )
+		{
+			stream >> column;
+		}
+
+		for ( auto& similarity : similarities )
+		{
+			stream >> similarity;
+		}
+
+		for ( auto& cluster : clusters )
+		{
+			stream >> cluster;
+		}
+
+		QCOMPARE(stream.status(), QDataStream::Ok);
+		QVERIFY(stream.atEnd());
+		QCOMPARE(offsets, expectedOffsets);
+		QCOMPARE(columns, expectedColumns);
+		QCOMPARE(similarities, expectedSimilarities);
+		QCOMPARE(clusters, expectedClusters);
+	}
+
+	// verify the gene table
+	QCOMPARE(TestUtils::readFile(outputPath + ".genes.txt"), QByteArray("0\n1\n2\n3\n"));
+}
+
+
+
+void TestExtract::testEmpty()
+{
+	QString ccmPath {QDir::tempPath() + "/extract-empty.ccm"};
+	QString cmxPath {QDir::tempPath() + "/extract-empty.cmx"};
+	QString outputPath {QDir::tempPath() + "/extract-empty.txt.gz"};
+
+	// create a cluster matrix and a correlation matrix without any pairs
+	EMetaArray metaNames;
+	for ( int i = 0; i < 4; ++i )
+	{
+		metaNames.append(QString::number(i));
+	}
+
+	QFile(ccmPath).remove();
+	QFile(cmxPath).remove();
+
+	{
+		std::unique_ptr<Ace::DataObject> ccmDataRef {new Ace::DataObject(ccmPath, DataFactory::CCMatrixType, EMetaObject())};
+		std::unique_ptr<Ace::DataObject> cmxDataRef {new Ace::DataObject(cmxPath, DataFactory::CorrelationMatrixType, EMetaObject())};
+
+		ccmDataRef->data()->cast<CCMatrix>()->initialize(metaNames, 2, metaNames);
+		cmxDataRef->data()->cast<CorrelationMatrix>()->initialize(metaNames, 2, "pearson");
+
+		ccmDataRef->data()->finish();
+		ccmDataRef->finalize();
+		cmxDataRef->data()->finish();
+		cmxDataRef->finalize();
+	}
+
+	// verify that the compressed text output contains the header
+	TestUtils::runAnalytic(AnalyticFactory::ExtractType,
+	{
+		{ Extract::Input::ExpressionData, _emxPath },
+		{ Extract::Input::ClusterData, ccmPath },
+		{ Extract::Input::CorrelationData, cmxPath },
+		{ Extract::Input::OutputFormatArg, "text" },
+		{ Extract::Input::OutputFile, outputPath },
+		{ Extract::Input::Compress, true }
+	});
+
+	QCOMPARE(uncompress(TestUtils::readFile(outputPath)), QByteArray("Source\tTarget\tSimilarity_Score\tInteraction\tCluster_Index\tCluster_Size\tSamples\n"));
+
+	// verify that the compressed export is a valid empty gzip file
+	TestUtils::runAnalytic(AnalyticFactory::ExportCorrelationMatrixType,
+	{
+		{ ExportCorrelationMatrix::Input::ExpressionData, _emxPath },
+		{ ExportCorrelationMatrix::Input::ClusterData, ccmPath },
+		{ ExportCorrelationMatrix::Input::CorrelationData, cmxPath },
+		{ ExportCorrelationMatrix::Input::OutputFile, outputPath },
+		{ ExportCorrelationMatrix::Input::Compress, true }
+	});
+
+	QByteArray data {TestUtils::readFile(outputPath)};
+
+	QVERIFY(data.startsWith("\x1f\x8b"));
+	QVERIFY(uncompress(data).isEmpty());
+}
@@ -0,0 +1,48 @@
+#ifndef TESTEXTRACT_H
+#define TESTEXTRACT_H
+#include <QtTest/QtTest>
+
+#include "../core/pairwise_index.h"
+
+
+
+class TestExtract : public QObject
+{
+	Q_OBJECT
+
+private:
+	struct Pair
+	{
+		Pairwise::Index index;
+		QVector<QVector<qint8>> sampleMasks;
+		QVector<float> correlations;
+	};
+
+private:
+	void runExtract(const QString& format, const QString& outputPath, int numThreads);
+	static QByteArray uncompress(const QByteArray& data);
+	/*!
+	 * The path of the expression matrix of the test network.
+	 */
+	QString _emxPath;
+	/*!
+	 * The path of the cluster matrix of the test network.
+	 */
+	QString _ccmPath;
+	/*!
+	 * The path of the correlation matrix of the test network.
+	 */
+	QString _cmxPath;
+
+private slots:
+	void initTestCase();
+	void testText();
+	void testGraphML();
+	void testBinary();
+	void testCSR();
+	void testEmpty();
+};
+
+
+
+#endif
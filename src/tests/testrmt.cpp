@@ -1,90 +1,621 @@
 #include <ace/core/core.h>
-#include <ace/core/ace_analytic_single.h>
 #include <ace/core/ace_dataobject.h>
+#include <lapacke.h>
+#include <random>
 
 #include "testrmt.h"
 #include "../core/analyticfactory.h"
 #include "../core/datafactory.h"
 #include "../core/rmt_input.h"
+#include "../core/rmt_cache.h"
 #include "../core/correlationmatrix.h"
 #include "../core/correlationmatrix_pair.h"
+#include "testutils.h"
 
 
 
-void TestRMT::test()
+/*!
+ * Run the RMT analytic on the correlation matrix of the tests with the
+ * thresholds of the tests and the given additional arguments.
+ *
+ * @param logPath
+ * @param arguments
+ */
+void TestRMT::runRMT(const QString& logPath, const QList<QPair<int, QVariant>>& arguments)
 {
-	// create random correlation data
-	int numGenes = 10;
-	int maxClusters = 5;
-	QVector<Pair> testPairs;
+	QList<QPair<int, QVariant>> allArguments
+	{
+		{ RMT::Input::InputData, _cmxPath },
+		{ RMT::Input::LogFile, logPath },
+		{ RMT::Input::ThresholdStart, _thresholdStart },
+		{ RMT::Input::ThresholdStep, _thresholdStep },
+		{ RMT::Input::ThresholdStop, _thresholdStop }
+	};
+
+	TestUtils::runAnalytic(AnalyticFactory::RMTType, allArguments + arguments);
+}
 
+
+
+/*!
+ * Create a correlation matrix with numbered genes from the given pairs, which
+ * must be in increasing order of their indices.
+ *
+ * @param path
+ * @param numGenes
+ * @param pairs
+ */
+void TestRMT::writeCorrelationMatrix(const QString& path, int numGenes, const QVector<Pair>& pairs)
+{
+	// create metadata
+	EMetaArray metaGeneNames;
 	for ( int i = 0; i < numGenes; ++i )
+	{
+		metaGeneNames.append(QString::number(i));
+	}
+
+	int maxClusters {1};
+
+	for ( auto& pair : pairs )
+	{
+		maxClusters = std::max(maxClusters, pair.correlations.size());
+	}
+
+	// create correlation matrix
+	QFile(path).remove();
+
+	std::unique_ptr<Ace::DataObject> dataRef {new Ace::DataObject(path, DataFactory::CorrelationMatrixType, EMetaObject())};
+	CorrelationMatrix* cmx {dataRef->data()->cast<CorrelationMatrix>()};
+
+	cmx->initialize(metaGeneNames, maxClusters, "pearson");
+
+	CorrelationMatrix::Pair cmxPair(cmx);
+	for ( auto& pair : pairs )
+	{
+		cmxPair.clearClusters();
+		cmxPair.addCluster(pair.correlations.size());
+
+		for ( int k = 0; k < cmxPair.clusterSize(); ++k )
+		{
+			cmxPair.at(k) = pair.correlations.at(k);
+		}
+
+		cmxPair.write(pair.index);
+	}
+
+	dataRef->data()->finish();
+	dataRef->finalize();
+}
+
+
+
+/*!
+ * Compute the row-wise maximum of each gene of the correlation matrix of the
+ * tests, which is taken over every cluster of the pairs in its row.
+ */
+std::vector<float> TestRMT::computeMaximums()
+{
+	std::vector<float> maximums(_numGenes, 0);
+
+	for ( auto& pair : _pairs )
+	{
+		for ( float correlation : pair.correlations )
+		{
+			maximums[pair.index.getX()] = std::max(maximums[pair.index.getX()], fabsf(correlation));
+		}
+	}
+
+	return maximums;
+}
+
+
+
+/*!
+ * Compute the pruned matrix of the correlation matrix of the tests at the
+ * given threshold from scratch, using the first cluster of each pair. The
+ * pruned matrix is returned in dense column-major form.
+ *
+ * @param threshold
+ * @param size
+ */
+std::vector<float> TestRMT::computePruneMatrix(float threshold, int* size)
+{
+	std::vector<float> maximums {computeMaximums()};
+
+	// determine the rows of the genes whose row-wise maximum is included
+	std::vector<int> rows(_numGenes, -1);
+	int n {0};
+
+	for ( int i = 0; i < _numGenes; ++i )
+	{
+		if ( maximums[i] >= threshold && maximums[i] >= _thresholdStop )
+		{
+			rows[i] = n++;
+		}
+	}
+
+	// set the diagonal and each included correlation
+	std::vector<float> matrix(n * n, 0);
+
+	for ( int i = 0; i < n; ++i )
+	{
+		matrix[i * n + i] = 1;
+	}
+
+	for ( auto& pair : _pairs )
+	{
+		int x {rows[pair.index.getX()]};
+		int y {rows[pair.index.getY()]};
+		float correlation {pair.correlations[0]};
+
+		if ( x != -1 && y != -1 && fabsf(correlation) >= threshold && fabsf(correlation) >= _thresholdStop )
+		{
+			matrix[x * n + y] = correlation;
+			matrix[y * n + x] = correlation;
+		}
+	}
+
+	*size = n;
+
+	return matrix;
+}
+
+
+
+/*!
+ * Compute the sorted eigenvalues of the pruned matrix of the correlation
+ * matrix of the tests at the given threshold with a dense solver.
+ *
+ * @param threshold
+ */
+std::vector<float> TestRMT::computeEigenvalues(float threshold)
+{
+	int n;
+	std::vector<float> matrix {computePruneMatrix(threshold, &n)};
+	std::vector<float> eigens(n);
+
+	if ( n > 0 )
+	{
+		LAPACKE_ssyev(LAPACK_COL_MAJOR, 'N', 'U', n, matrix.data(), n, eigens.data());
+	}
+
+	return eigens;
+}
+
+
+
+/*!
+ * Read the lines of a log file.
+ *
+ * @param logPath
+ */
+QStringList TestRMT::readLog(const QString& logPath)
+{
+	return QString(TestUtils::readFile(logPath)).split("\n", QString::SkipEmptyParts);
+}
+
+
+
+void TestRMT::initTestCase()
+{
+	// create random correlation data with a fixed seed, in which some pairs
+	// are missing and some pairs have two clusters
+	_numGenes = 40;
+	std::minstd_rand generator(1);
+	std::uniform_real_distribution<float> distribution(-1, 1);
+	_pairs.clear();
+
+	for ( int i = 0; i < _numGenes; ++i )
 	{
 		for ( int j = 0; j < i; ++j )
 		{
-			int numClusters = rand() % (maxClusters + 1);
+			if ( distribution(generator) < -0.4f )
+			{
+				continue;
+			}
+
+			QVector<float> correlations {distribution(generator)};
 
-			if ( numClusters > 0 )
+			if ( distribution(generator) > 0.5f )
 			{
-				QVector<float> correlations(numClusters);
+				correlations.append(distribution(generator));
+			}
 
-				for ( int k = 0; k < numClusters; ++k )
+			_pairs.append({ { i, j }, correlations });
+		}
+	}
+
+	// create correlation matrix
+	_cmxPath = QDir::tempPath() + "/test-rmt.cmx";
+
+	writeCorrelationMatrix(_cmxPath, _numGenes, _pairs);
+}
+
+
+
+void TestRMT::test()
+{
+	// run the analytic, which cannot find a non-random threshold because the
+	// matrix is too small for the chi-squared test
+	QString logPath {QDir::tempPath() + "/test-rmt.log"};
+
+	QVERIFY_EXCEPTION_THROWN(runRMT(logPath, {}), EException);
+
+	// verify that every threshold was tested with the correct pruned matrix
+	QStringList lines {readLog(logPath)};
+
+	QCOMPARE(lines.size(), _numThresholds + 1);
+
+	for ( int i = 0; i <= _numThresholds; ++i )
+	{
+		float threshold {_thresholdStart - i * _thresholdStep};
+		QStringList fields {lines[i].split("\t")};
+		int size;
+
+		computePruneMatrix(threshold, &size);
+
+		QCOMPARE(fields.size(), 4);
+		QCOMPARE(fields[0], QString::number(threshold, 'f', 3));
+		QCOMPARE(fields[1].toInt(), size);
+		QCOMPARE(fields[3], QString("-1"));
+	}
+}
+
+
+
+void TestRMT::testPruneMatrix()
+{
+	// verify that the eigenvalues of the incrementally built pruned matrix at
+	// every threshold match those of a pruned matrix built from scratch, for
+	// each solver, with one and with several concurrent tests
+	QString logPath {QDir::tempPath() + "/test-rmt.log"};
+	QString cachePath {QDir::tempPath() + "/test-rmt.cache"};
+	QStringList solvers {"ssyev", "ssyevd", "ssyevr", "lanczos"};
+
+	std::unique_ptr<Ace::DataObject> cmxDataRef {new Ace::DataObject(_cmxPath)};
+	CorrelationMatrix* cmx {cmxDataRef->data()->cast<CorrelationMatrix>()};
+
+	for ( int s = 0; s < solvers.size(); ++s )
+	{
+		for ( int windowSize : { 1, 3 } )
+		{
+			QFile(cachePath).remove();
+
+			QVERIFY_EXCEPTION_THROWN(runRMT(logPath, {
+				{ RMT::Input::SolverType, solvers[s] },
+				{ RMT::Input::NumThreads, 4 },
+				{ RMT::Input::WindowSize, windowSize },
+				{ RMT::Input::CacheFile, cachePath }
+			}), EException);
+
+			RMT::Cache cache(cachePath);
+
+			QVERIFY(cache.load(cmx->contentHash(), 0, s));
+
+			for ( int i = 0; i <= _numThresholds; ++i )
+			{
+				float threshold {_thresholdStart - i * _thresholdStep};
+				const RMT::Cache::Entry* entry {cache.find(threshold)};
+				int size;
+
+				computePruneMatrix(threshold, &size);
+
+				QVERIFY(entry);
+				QCOMPARE(entry->size, static_cast<qint64>(size));
+
+				// the Lanczos solver may keep only one copy of a repeated
+				// eigenvalue, so compare the eigenvalues as sets
+				std::vector<float> eigens {computeEigenvalues(threshold)};
+
+				if ( solvers[s] != "lanczos" )
+				{
+					QCOMPARE(entry->eigens.size(), eigens.size());
+				}
+
+				auto contains = [] (const std::vector<float>& values, float value)
+				{
+					for ( float v : values )
+					{
+						if ( fabs(v - value) <= 1e-4f * std::max(1.0f, fabsf(value)) )
+						{
+							return true;
+						}
+					}
+
+					return false;
+				};
+
+				for ( float value : entry->eigens )
 				{
-					correlations[k] = -1.0f + 2.0f * rand() / (1 << 31);
+					QVERIFY(contains(eigens, value));
 				}
 
-				testPairs.append({ { i, j }, correlations });
+				for ( float value : eigens )
+				{
+					QVERIFY(contains(entry->eigens, value));
+				}
 			}
 		}
 	}
+}
+
+
+
+void TestRMT::testSearch()
+{
+	// create an eigenvalue cache in which the eigenvalues have exactly the
+	// nearest-neighbor spacing distribution of a Poisson process down to a
+	// given threshold and are equally spaced below it, so that the chi-squared
+	// value is low above the final threshold and very high below it
+	QString logPath {QDir::tempPath() + "/test-rmt.log"};
+	QString cachePath {QDir::tempPath() + "/test-rmt.cache"};
+	float thresholdStep {0.01f};
+	int numThresholds {45};
+	int finalIndex {23};
+	int numEigens {200};
+
+	std::vector<float> poisson(numEigens);
+	std::vector<float> equal(numEigens);
+
+	for ( int k = 0; k < numEigens - 1; ++k )
+	{
+		poisson[k + 1] = poisson[k] - logf(1 - (k + 0.5f) / (numEigens - 1));
+	}
+
+	float sum {poisson.back()};
+
+	for ( int k = 0; k < numEigens; ++k )
+	{
+		poisson[k] /= sum;
+		equal[k] = static_cast<float>(k) / (numEigens - 1);
+	}
+
+	{
+		std::unique_ptr<Ace::DataObject> cmxDataRef {new Ace::DataObject(_cmxPath)};
+		CorrelationMatrix* cmx {cmxDataRef->data()->cast<CorrelationMatrix>()};
+
+		QFile(cachePath).remove();
+
+		RMT::Cache cache(cachePath);
+		cache.create(cmx->contentHash(), 0, 0);
+
+		for ( int i = 0; i <= numThresholds; ++i )
+		{
+			cache.append({ _thresholdStart - i * thresholdStep, numEigens, (i <= finalIndex) ? poisson : equal });
+		}
+	}
+
+	// run the linear search and the coarse search with several window sizes
+	// from the cache and verify that they find the same final threshold
+	QList<QPair<int, QVariant>> arguments
+	{
+		{ RMT::Input::ThresholdStep, thresholdStep },
+		{ RMT::Input::CacheFile, cachePath },
+		{ RMT::Input::StatsOnly, true },
+		{ RMT::Input::SplineInterpolation, false }
+	};
+
+	runRMT(logPath, arguments + QList<QPair<int, QVariant>> {
+		{ RMT::Input::SearchType, "linear" }
+	});
+
+	QStringList linearLines {readLog(logPath)};
+
+	QCOMPARE(linearLines.size(), finalIndex + 3);
+	QVERIFY(fabs(linearLines.last().toFloat() - (_thresholdStart - finalIndex * thresholdStep)) < 1e-4f);
+
+	for ( int windowSize : { 1, 3 } )
+	{
+		runRMT(logPath, arguments + QList<QPair<int, QVariant>> {
+			{ RMT::Input::SearchType, "coarse" },
+			{ RMT::Input::ThresholdCoarseStep, 5 * thresholdStep },
+			{ RMT::Input::WindowSize, windowSize }
+		});
+
+		QStringList coarseLines {readLog(logPath)};
+
+		QCOMPARE(coarseLines.last(), linearLines.last());
+		QVERIFY(coarseLines.size() < linearLines.size());
+	}
+}
+
+
+
+/*!
+ * The messages of the analytic which were captured by the message handler of
+ * the window test.
+ */
+static QStringList g_messages;
+static QMutex g_messagesMutex;
+
+
+
+void TestRMT::testWindow()
+{
+	if ( QThread::idealThreadCount() < 2 )
+	{
+		QSKIP("concurrent tests require at least two threads");
+	}
+
+	// create a correlation matrix whose pruned matrices are large enough that
+	// concurrent eigensolver calls take much longer than starting a thread
+	QString cmxPath {QDir::tempPath() + "/test-rmt-window.cmx"};
+	QString logPath {QDir::tempPath() + "/test-rmt-window.log"};
+	int numGenes = 500;
+	std::minstd_rand generator(2);
+	std::uniform_real_distribution<float> distribution(0.5f, 1);
+	QVector<Pair> pairs;
 
-	// create metadata
-	EMetaArray metaGeneNames;
 	for ( int i = 0; i < numGenes; ++i )
 	{
-		metaGeneNames.append(QString::number(i));
+		for ( int j = 0; j < i; ++j )
+		{
+			float correlation {distribution(generator)};
+
+			pairs.append({ { i, j }, { (generator() % 2) ? correlation : -correlation } });
+		}
 	}
 
-	QString correlationName("test");
+	writeCorrelationMatrix(cmxPath, numGenes, pairs);
 
-	// initialize temp files
-	QString cmxPath {QDir::tempPath() + "/test.cmx"};
-	QString logPath {QDir::tempPath() + "/test.log"};
+	// run the analytic with one threshold at a time, with a single thread so
+	// that each eigensolver call is computed exactly as in a concurrent test,
+	// and then with several concurrent thresholds, capturing its messages
+	auto run = [&] (int numThreads, int windowSize)
+	{
+		try
+		{
+			TestUtils::runAnalytic(AnalyticFactory::RMTType, {
+				{ RMT::Input::InputData, cmxPath },
+				{ RMT::Input::LogFile, logPath },
+				{ RMT::Input::ThresholdStart, 0.95 },
+				{ RMT::Input::ThresholdStep, 0.05 },
+				{ RMT::Input::ThresholdStop, 0.55 },
+				{ RMT::Input::NumThreads, numThreads },
+				{ RMT::Input::WindowSize, windowSize }
+			});
+		}
+		catch ( EException& )
+		{
+			// the random matrix has no non-random threshold
+		}
 
-	QFile(cmxPath).remove();
-	QFile(logPath).remove();
+		return TestUtils::readFile(logPath);
+	};
 
-	// create correlation matrix
+	QByteArray serialLog {run(1, 1)};
+
+	g_messages.clear();
+
+	QtMessageHandler handler {qInstallMessageHandler([] (QtMsgType, const QMessageLogContext&, const QString& message)
+	{
+		QMutexLocker locker(&g_messagesMutex);
+		g_messages.append(message);
+	})};
+
+	QByteArray windowLog {run(4, 4)};
+
+	qInstallMessageHandler(handler);
+
+	// verify that the log file is the same
+	QVERIFY(!serialLog.isEmpty());
+	QCOMPARE(windowLog, serialLog);
+
+	// verify that the eigenvalues of one threshold were computed while those
+	// of another threshold were being computed, since the eigenvalues are
+	// computed between the prune matrix and unique eigenvalue messages of a
+	// threshold
+	int numRunning {0};
+	int maxRunning {0};
+
+	for ( auto& message : g_messages )
+	{
+		if ( message.contains("prune matrix") )
+		{
+			maxRunning = std::max(maxRunning, ++numRunning);
+		}
+		else if ( message.contains("unique eigenvalues") )
+		{
+			--numRunning;
+		}
+	}
+
+	QVERIFY(maxRunning > 1);
+}
+
+
+
+void TestRMT::testLanczosLarge()
+{
+	// create a star network of 200,000 genes, whose packed pruned matrix would
+	// take 80 GB with a dense solver; gene 0 is never included since a gene is
+	// only included by the pairs in its own row, so gene 1 is the center
+	QString cmxPath {QDir::tempPath() + "/test-rmt-large.cmx"};
+	QString logPath {QDir::tempPath() + "/test-rmt-large.log"};
+	QString cachePath {QDir::tempPath() + "/test-rmt-large.cache"};
+	int numGenes = 200000;
+	QVector<Pair> pairs;
+
+	auto correlationAt = [] (int i)
+	{
+		return 0.855f + 0.01f * (i % 10);
+	};
+
+	pairs.append({ { 1, 0 }, { 0.99f } });
+
+	for ( int i = 2; i < numGenes; ++i )
+	{
+		pairs.append({ { i, 1 }, { correlationAt(i) } });
+	}
+
+	writeCorrelationMatrix(cmxPath, numGenes, pairs);
+
+	// run the analytic with the Lanczos solver, which cannot find a non-random
+	// threshold because a star network has only three unique eigenvalues
+	float thresholdStart {0.95f};
+	float thresholdStep {0.01f};
+	int numThresholds {10};
+
+	QFile(cachePath).remove();
+
+	QVERIFY_EXCEPTION_THROWN(TestUtils::runAnalytic(AnalyticFactory::RMTType, {
+		{ RMT::Input::InputData, cmxPath },
+		{ RMT::Input::LogFile, logPath },
+		{ RMT::Input::ThresholdStart, thresholdStart },
+		{ RMT::Input::ThresholdStep, thresholdStep },
+		{ RMT::Input::ThresholdStop, 0.85 },
+		{ RMT::Input::SolverType, "lanczos" },
+		{ RMT::Input::CacheFile, cachePath }
+	}), EException);
+
+	// verify the size and the unique eigenvalues of each pruned matrix, which
+	// consists of the center and the leaves whose correlation is above the
+	// threshold, and whose eigenvalues are 1 and 1 plus or minus the norm of
+	// the correlations
 	std::unique_ptr<Ace::DataObject> cmxDataRef {new Ace::DataObject(cmxPath)};
 	CorrelationMatrix* cmx {cmxDataRef->data()->cast<CorrelationMatrix>()};
+	RMT::Cache cache(cachePath);
 
-	cmx->initialize(metaGeneNames, maxClusters, correlationName);
+	QVERIFY(cache.load(cmx->contentHash(), 0, 3));
 
-	CorrelationMatrix::Pair cmxPair(cmx);
-	for ( auto& testPair : testPairs )
+	QStringList lines {readLog(logPath)};
+
+	QCOMPARE(lines.size(), numThresholds + 1);
+
+	for ( int t = 0; t <= numThresholds; ++t )
 	{
-		cmxPair.clearClusters();
-		cmxPair.addCluster(testPair.correlations.size());
+		float threshold {thresholdStart - t * thresholdStep};
+		int size {1};
+		double norm {0};
 
-		for ( int k = 0; k < cmxPair.clusterSize(); ++k )
+		for ( int i = 2; i < numGenes; ++i )
 		{
-			cmxPair.at(k) = testPair.correlations.at(k);
+			if ( correlationAt(i) >= threshold )
+			{
+				++size;
+				norm += correlationAt(i) * correlationAt(i);
+			}
 		}
 
-		cmxPair.write(testPair.index);
-	}
+		norm = sqrt(norm);
+
+		std::vector<float> eigens {1};
 
-	cmxDataRef->data()->finish();
-	cmxDataRef->finalize();
+		if ( size > 1 )
+		{
+			eigens = { static_cast<float>(1 - norm), 1, static_cast<float>(1 + norm) };
+		}
 
-	// create analytic manager
-	auto abstractManager = Ace::Analytic::AbstractManager::makeManager(AnalyticFactory::RMTType, 0, 1);
-	auto manager = qobject_cast<Ace::Analytic::Single*>(abstractManager.release());
-	manager->set(RMT::Input::InputData, cmxPath);
-	manager->set(RMT::Input::LogFile, logPath);
+		const RMT::Cache::Entry* entry {cache.find(threshold)};
 
-	// run analytic
-	manager->initialize();
+		QVERIFY(entry);
+		QCOMPARE(lines[t].split("\t")[1].toInt(), size);
+		QCOMPARE(entry->size, static_cast<qint64>(size));
+		QCOMPARE(entry->eigens.size(), eigens.size());
 
-	// TODO: wait for analytic to finish properly
+		for ( size_t i = 0; i < eigens.size(); ++i )
+		{
+			QVERIFY(fabs(entry->eigens[i] - eigens[i]) <= 1e-4f * std::max(1.0f, fabsf(eigens[i])));
+		}
+	}
 }
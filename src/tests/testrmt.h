@@ -17,8 +17,29 @@ private:
 		QVector<float> correlations;
 	};
 
+private:
+	void runRMT(const QString& logPath, const QList<QPair<int, QVariant>>& arguments);
+	static void writeCorrelationMatrix(const QString& path, int numGenes, const QVector<Pair>& pairs);
+	std::vector<float> computeMaximums();
+	std::vector<float> computePruneMatrix(float threshold, int* size);
+	std::vector<float> computeEigenvalues(float threshold);
+	static QStringList readLog(const QString& logPath);
+
+	float _thresholdStart {0.95f};
+	float _thresholdStep {0.05f};
+	float _thresholdStop {0.5f};
+	int _numThresholds {9};
+	int _numGenes;
+	QVector<Pair> _pairs;
+	QString _cmxPath;
+
 private slots:
+	void initTestCase();
 	void test();
+	void testPruneMatrix();
+	void testSearch();
+	void testWindow();
+	void testLanczosLarge();
 };
 
 
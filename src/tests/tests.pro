@@ -11,26 +11,32 @@ CONFIG += debug
 # Source files
 SOURCES += \
 	testclustermatrix.cpp \
+	testconditionaltest.cpp \
 	testcorrelationmatrix.cpp \
 	testexportcorrelationmatrix.cpp \
 	testexportexpressionmatrix.cpp \
 	testexpressionmatrix.cpp \
+	testextract.cpp \
 	testimportcorrelationmatrix.cpp \
 	testimportexpressionmatrix.cpp \
 	testrmt.cpp \
 	testsimilarity.cpp \
+	testutils.cpp \
 	main.cpp
 
 HEADERS += \
 	testclustermatrix.h \
+	testconditionaltest.h \
 	testcorrelationmatrix.h \
 	testexportcorrelationmatrix.h \
 	testexportexpressionmatrix.h \
 	testexpressionmatrix.h \
+	testextract.h \
 	testimportcorrelationmatrix.h \
 	testimportexpressionmatrix.h \
 	testrmt.h \
-	testsimilarity.h
+	testsimilarity.h \
+	testutils.h
 
 # Installation instructions
 isEmpty(PREFIX) { PREFIX = /usr/local }
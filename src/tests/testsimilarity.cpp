@@ -1,12 +1,154 @@
 #include <ace/core/core.h>
-#include <ace/core/ace_analytic_single.h>
 #include <ace/core/ace_dataobject.h>
+#include <random>
 
 #include "testsimilarity.h"
 #include "../core/analyticfactory.h"
 #include "../core/datafactory.h"
 #include "../core/similarity_input.h"
-#include "../core/expressionmatrix_gene.h"
+#include "../core/similarity_shard.h"
+#include "../core/mergeshards_input.h"
+#include "../core/rmt_input.h"
+#include "../core/powerlaw_input.h"
+#include "../core/thresholdsummary.h"
+#include "../core/ccmatrix_pair.h"
+#include "../core/correlationmatrix_pair.h"
+#include "testutils.h"
+
+
+
+/*!
+ * Run the similarity analytic on the expression matrix of the comparison
+ * tests without clustering, with the given additional arguments.
+ *
+ * @param ccmPath
+ * @param cmxPath
+ * @param arguments
+ */
+void TestSimilarity::runSimilarity(const QString& ccmPath, const QString& cmxPath, const QList<QPair<int, QVariant>>& arguments)
+{
+	QFile(ccmPath).remove();
+	QFile(cmxPath).remove();
+
+	QList<QPair<int, QVariant>> allArguments
+	{
+		{ Similarity::Input::InputData, _emxPath },
+		{ Similarity::Input::ClusterData, ccmPath },
+		{ Similarity::Input::CorrelationData, cmxPath },
+		{ Similarity::Input::ClusteringType, "none" },
+		{ Similarity::Input::CorrelationType, "pearson" },
+		{ Similarity::Input::MinCorrelation, 0.0 },
+		{ Similarity::Input::WorkBlockSize, 7 }
+	};
+
+	TestUtils::runAnalytic(AnalyticFactory::SimilarityType, allArguments + arguments);
+}
+
+
+
+/*!
+ * Read the pairs of a cluster matrix and correlation matrix.
+ *
+ * @param ccmPath
+ * @param cmxPath
+ */
+QVector<TestSimilarity::Pair> TestSimilarity::readPairs(const QString& ccmPath, const QString& cmxPath)
+{
+	std::unique_ptr<Ace::DataObject> ccmDataRef {new Ace::DataObject(ccmPath)};
+	std::unique_ptr<Ace::DataObject> cmxDataRef {new Ace::DataObject(cmxPath)};
+	CCMatrix* ccm {ccmDataRef->data()->cast<CCMatrix>()};
+	CorrelationMatrix* cmx {cmxDataRef->data()->cast<CorrelationMatrix>()};
+
+	CCMatrix::Pair ccmPair(ccm);
+	CorrelationMatrix::Pair cmxPair(cmx);
+	QVector<Pair> pairs;
+
+	while ( cmxPair.hasNext() )
+	{
+		cmxPair.readNext();
+		ccmPair.read(cmxPair.index());
+
+		Pair pair;
+		pair.index = cmxPair.index();
+		pair.correlations = cmxPair.correlations();
+
+		for ( int k = 0; k < ccmPair.clusterSize(); ++k )
+		{
+			QVector<qint8> sampleMask(ccm->sampleSize());
+
+			for ( int i = 0; i < ccm->sampleSize(); ++i )
+			{
+				sampleMask[i] = ccmPair.at(k, i);
+			}
+
+			pair.sampleMasks.append(sampleMask);
+		}
+
+		pairs.append(pair);
+	}
+
+	return pairs;
+}
+
+
+
+/*!
+ * Return whether two lists of pairs have the same indices, sample masks and
+ * correlations.
+ *
+ * @param a
+ * @param b
+ */
+bool TestSimilarity::isEqual(const QVector<Pair>& a, const QVector<Pair>& b)
+{
+	if ( a.size() != b.size() )
+	{
+		return false;
+	}
+
+	for ( int i = 0; i < a.size(); ++i )
+	{
+		if ( !(a[i].index == b[i].index) || a[i].sampleMasks != b[i].sampleMasks || a[i].correlations != b[i].correlations )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+
+void TestSimilarity::initTestCase()
+{
+	// create random expression data with a fixed seed, in which one gene is
+	// constant at a value which is not exactly representable and one gene has
+	// too few samples for any pair
+	int numGenes = 12;
+	int numSamples = 40;
+	std::minstd_rand generator(1);
+	std::normal_distribution<float> distribution(0, 1);
+	QVector<float> expressions(numGenes * numSamples);
+
+	for ( int i = 0; i < expressions.size(); ++i )
+	{
+		expressions[i] = distribution(generator);
+	}
+
+	for ( int j = 0; j < numSamples; ++j )
+	{
+		expressions[4 * numSamples + j] = 0.1f;
+	}
+
+	for ( int j = 10; j < numSamples; ++j )
+	{
+		expressions[7 * numSamples + j] = NAN;
+	}
+
+	_emxPath = QDir::tempPath() + "/similarity.emx";
+
+	TestUtils::createExpressionMatrix(_emxPath, numGenes, numSamples, expressions);
+}
 
 
 
@@ -22,63 +164,329 @@ void TestSimilarity::test()
 		testExpressions[i] = -10.0f + 20.0f * rand() / (1 << 31);
 	}
 
-	// create metadata
-	QStringList geneNames;
-	QStringList sampleNames;
+	// initialize temp files
+	QString ccmPath {QDir::tempPath() + "/test.ccm"};
+	QString cmxPath {QDir::tempPath() + "/test.cmx"};
+	QString emxPath {QDir::tempPath() + "/test.emx"};
 
-	for ( int i = 0; i < numGenes; ++i )
+	// create expression matrix
+	TestUtils::createExpressionMatrix(emxPath, numGenes, numSamples, testExpressions);
+
+	// run analytic
+	TestUtils::runAnalytic(AnalyticFactory::SimilarityType,
 	{
-		geneNames.append(QString::number(i));
+		{ Similarity::Input::InputData, emxPath },
+		{ Similarity::Input::ClusterData, ccmPath },
+		{ Similarity::Input::CorrelationData, cmxPath },
+		{ Similarity::Input::ClusteringType, "gmm" },
+		{ Similarity::Input::CorrelationType, "pearson" }
+	});
+
+	// TODO: read and verify cluster data
+	// TODO: read and verify correlation data
+}
+
+
+
+void TestSimilarity::testFactoring()
+{
+	QString ccmPath {QDir::tempPath() + "/similarity.ccm"};
+	QString cmxPath {QDir::tempPath() + "/similarity.cmx"};
+
+	// run analytic with the static schedule
+	runSimilarity(ccmPath, cmxPath, { { Similarity::Input::WorkBlockSchedule, "static" } });
+
+	QVector<Pair> baseline {readPairs(ccmPath, cmxPath)};
+
+	QVERIFY(!baseline.isEmpty());
+
+	// verify that the factoring schedule gives the same output
+	runSimilarity(ccmPath, cmxPath, { { Similarity::Input::WorkBlockSchedule, "factoring" } });
+	QVERIFY(isEqual(readPairs(ccmPath, cmxPath), baseline));
+}
+
+
+
+void TestSimilarity::testPreFilter()
+{
+	QString ccmPath {QDir::tempPath() + "/similarity.ccm"};
+	QString cmxPath {QDir::tempPath() + "/similarity.cmx"};
+
+	for ( QString correlationType : { "pearson", "spearman" } )
+	{
+		// run analytic without the pre-filter
+		runSimilarity(ccmPath, cmxPath,
+		{
+			{ Similarity::Input::CorrelationType, correlationType },
+			{ Similarity::Input::PreFilter, false }
+		});
+
+		QVector<Pair> baseline {readPairs(ccmPath, cmxPath)};
+
+		QVERIFY(!baseline.isEmpty());
+
+		// verify that the constant gene and the gene with too few samples
+		// have no correlations
+		for ( auto& pair : baseline )
+		{
+			QVERIFY(pair.index.getX() != 4 && pair.index.getY() != 4);
+			QVERIFY(pair.index.getX() != 7 && pair.index.getY() != 7);
+		}
+
+		// verify that the pre-filter gives the same output
+		runSimilarity(ccmPath, cmxPath,
+		{
+			{ Similarity::Input::CorrelationType, correlationType },
+			{ Similarity::Input::PreFilter, true }
+		});
+
+		QVERIFY(isEqual(readPairs(ccmPath, cmxPath), baseline));
 	}
+}
+
+
+
+void TestSimilarity::testTopK()
+{
+	QString ccmPath {QDir::tempPath() + "/similarity.ccm"};
+	QString cmxPath {QDir::tempPath() + "/similarity.cmx"};
+	int k = 2;
+
+	// run analytic without top-k mode
+	runSimilarity(ccmPath, cmxPath, {});
+
+	QVector<Pair> baseline {readPairs(ccmPath, cmxPath)};
 
-	for ( int i = 0; i < numSamples; ++i )
+	QVERIFY(!baseline.isEmpty());
+
+	// select the k strongest correlations of each gene, where ties are broken
+	// by the lower indent
+	struct Edge
+	{
+		float strength;
+		qint64 indent;
+		int pair;
+		int cluster;
+	};
+
+	QHash<qint32, QVector<Edge>> geneEdges;
+
+	for ( int i = 0; i < baseline.size(); ++i )
 	{
-		sampleNames.append(QString::number(i));
+		for ( int c = 0; c < baseline[i].correlations.size(); ++c )
+		{
+			Edge edge {fabsf(baseline[i].correlations[c]), baseline[i].index.indent(c), i, c};
+
+			geneEdges[baseline[i].index.getX()].append(edge);
+			geneEdges[baseline[i].index.getY()].append(edge);
+		}
 	}
 
-	// initialize temp files
-	QString ccmPath {QDir::tempPath() + "/test.ccm"};
-	QString cmxPath {QDir::tempPath() + "/test.cmx"};
-	QString emxPath {QDir::tempPath() + "/test.emx"};
+	QSet<QPair<int, int>> selected;
 
-	QFile(ccmPath).remove();
-	QFile(cmxPath).remove();
-	QFile(emxPath).remove();
+	for ( auto& edges : geneEdges )
+	{
+		std::sort(edges.begin(), edges.end(), [] (const Edge& a, const Edge& b)
+		{
+			return a.strength > b.strength || (a.strength == b.strength && a.indent < b.indent);
+		});
 
-	// create expression matrix
-	std::unique_ptr<Ace::DataObject> emxDataRef {new Ace::DataObject(emxPath)};
-	ExpressionMatrix* emx {emxDataRef->data()->cast<ExpressionMatrix>()};
+		for ( int i = 0; i < std::min(k, edges.size()); ++i )
+		{
+			selected.insert({ edges[i].pair, edges[i].cluster });
+		}
+	}
 
-	emx->initialize(geneNames, sampleNames);
+	// remove the correlations which were not selected
+	QVector<Pair> expected;
 
-	ExpressionMatrix::Gene gene(emx);
-	for ( int i = 0; i < emx->geneSize(); ++i )
+	for ( int i = 0; i < baseline.size(); ++i )
 	{
-		for ( int j = 0; j < emx->sampleSize(); ++j )
+		Pair pair;
+		pair.index = baseline[i].index;
+
+		for ( int c = 0; c < baseline[i].correlations.size(); ++c )
 		{
-			gene[j] = testExpressions[i * numSamples + j];
+			if ( selected.contains({ i, c }) )
+			{
+				pair.sampleMasks.append(baseline[i].sampleMasks[c]);
+				pair.correlations.append(baseline[i].correlations[c]);
+			}
 		}
 
-		gene.write(i);
+		if ( !pair.correlations.isEmpty() )
+		{
+			expected.append(pair);
+		}
 	}
 
-	emxDataRef->data()->finish();
-	emxDataRef->finalize();
+	QVERIFY(expected.size() < baseline.size());
 
-	// create analytic manager
-	auto abstractManager = Ace::Analytic::AbstractManager::makeManager(AnalyticFactory::SimilarityType, 0, 1);
-	auto manager = qobject_cast<Ace::Analytic::Single*>(abstractManager.release());
-	manager->set(Similarity::Input::InputData, emxPath);
-	manager->set(Similarity::Input::ClusterData, ccmPath);
-	manager->set(Similarity::Input::CorrelationData, cmxPath);
-	manager->set(Similarity::Input::ClusteringType, "gmm");
-	manager->set(Similarity::Input::CorrelationType, "pearson");
+	// verify that top-k mode gives the selected correlations
+	runSimilarity(ccmPath, cmxPath, { { Similarity::Input::TopK, k } });
+	QVERIFY(isEqual(readPairs(ccmPath, cmxPath), expected));
+}
 
-	// run analytic
-	manager->initialize();
 
-	// TODO: wait for analytic to finish properly
 
-	// TODO: read and verify cluster data
-	// TODO: read and verify correlation data
+void TestSimilarity::testShards()
+{
+	QString ccmPath {QDir::tempPath() + "/similarity.ccm"};
+	QString cmxPath {QDir::tempPath() + "/similarity.cmx"};
+	QString shardCcmPath {QDir::tempPath() + "/similarity-shard.ccm"};
+	QString shardCmxPath {QDir::tempPath() + "/similarity-shard.cmx"};
+	QString mergedCcmPath {QDir::tempPath() + "/similarity-merged.ccm"};
+	QString mergedCmxPath {QDir::tempPath() + "/similarity-merged.cmx"};
+	QString shardPrefix {QDir::tempPath() + "/similarity"};
+	QString shardPath {Similarity::Shard::fileName(shardPrefix, 0)};
+	QString stalePath {Similarity::Shard::fileName(shardPrefix, 5)};
+	QString oldPath {QDir::tempPath() + "/similarity-old.shard"};
+
+	QList<QPair<int, QVariant>> mergeArguments
+	{
+		{ MergeShards::Input::InputData, _emxPath },
+		{ MergeShards::Input::ClusterData, mergedCcmPath },
+		{ MergeShards::Input::CorrelationData, mergedCmxPath },
+		{ MergeShards::Input::ShardPrefix, shardPrefix }
+	};
+
+	// run analytic with direct output
+	runSimilarity(ccmPath, cmxPath, {});
+
+	QVector<Pair> baseline {readPairs(ccmPath, cmxPath)};
+
+	QVERIFY(!baseline.isEmpty());
+
+	// run analytic with shard files after leaving a shard file of an earlier
+	// run with more processes, and keep a copy of the shard file of this run
+	QFile(stalePath).remove();
+	QFile(oldPath).remove();
+
+	runSimilarity(shardCcmPath, shardCmxPath, { { Similarity::Input::ShardPrefix, shardPrefix } });
+
+	QVERIFY(QFile::copy(shardPath, stalePath));
+	QVERIFY(QFile::copy(shardPath, oldPath));
+
+	runSimilarity(shardCcmPath, shardCmxPath, { { Similarity::Input::ShardPrefix, shardPrefix } });
+
+	// verify that the stale shard file was removed and the manifest was written
+	QVERIFY(QFile::exists(shardPath));
+	QVERIFY(!QFile::exists(stalePath));
+	QVERIFY(QFile::exists(Similarity::Shard::manifestName(shardPrefix)));
+
+	// verify that the merged output is the same as the direct output
+	TestUtils::runAnalytic(AnalyticFactory::MergeShardsType, mergeArguments);
+
+	QVERIFY(isEqual(readPairs(mergedCcmPath, mergedCmxPath), baseline));
+
+	// verify that the merged output has the same content hash
+	{
+		std::unique_ptr<Ace::DataObject> directDataRef {new Ace::DataObject(cmxPath)};
+		std::unique_ptr<Ace::DataObject> mergedDataRef {new Ace::DataObject(mergedCmxPath)};
+
+		QCOMPARE(mergedDataRef->data()->cast<CorrelationMatrix>()->contentHash(), directDataRef->data()->cast<CorrelationMatrix>()->contentHash());
+	}
+
+	// verify that a shard file of the earlier run is refused
+	QVERIFY(QFile::remove(shardPath));
+	QVERIFY(QFile::rename(oldPath, shardPath));
+
+	QVERIFY_EXCEPTION_THROWN(TestUtils::runAnalytic(AnalyticFactory::MergeShardsType, mergeArguments), EException);
+
+	// verify that the shard files are refused without a manifest
+	QVERIFY(QFile::remove(Similarity::Shard::manifestName(shardPrefix)));
+
+	QVERIFY_EXCEPTION_THROWN(TestUtils::runAnalytic(AnalyticFactory::MergeShardsType, mergeArguments), EException);
+}
+
+
+
+void TestSimilarity::testSummary()
+{
+	QString ccmPath {QDir::tempPath() + "/similarity.ccm"};
+	QString cmxPath {QDir::tempPath() + "/similarity.cmx"};
+	QString otherCcmPath {QDir::tempPath() + "/similarity-other.ccm"};
+	QString otherCmxPath {QDir::tempPath() + "/similarity-other.cmx"};
+	QString summaryPath {QDir::tempPath() + "/similarity.summary"};
+	QString logPath {QDir::tempPath() + "/similarity-threshold.log"};
+	QString summaryLogPath {QDir::tempPath() + "/similarity-threshold-summary.log"};
+
+	// run analytic with a threshold summary
+	runSimilarity(ccmPath, cmxPath, { { Similarity::Input::SummaryFile, summaryPath } });
+
+	// verify that the summary has the content hash of the correlation matrix
+	ThresholdSummary summary;
+	summary.load(summaryPath);
+
+	{
+		std::unique_ptr<Ace::DataObject> dataRef {new Ace::DataObject(cmxPath)};
+
+		QCOMPARE(summary.hash(), dataRef->data()->cast<CorrelationMatrix>()->contentHash());
+	}
+
+	// verify that RMT writes the same log file with and without the summary,
+	// for both the linear and the coarse search; the network is too small for
+	// the chi-squared test, so every threshold is tested and RMT fails
+	for ( float coarseStep : { 0.0f, 0.05f } )
+	{
+		QList<QPair<int, QVariant>> arguments
+		{
+			{ RMT::Input::InputData, cmxPath },
+			{ RMT::Input::ThresholdStart, 0.99 },
+			{ RMT::Input::ThresholdStep, 0.01 },
+			{ RMT::Input::ThresholdStop, 0.5 },
+			{ RMT::Input::ThresholdCoarseStep, coarseStep }
+		};
+
+		QVERIFY_EXCEPTION_THROWN(TestUtils::runAnalytic(AnalyticFactory::RMTType, arguments + QList<QPair<int, QVariant>> {
+			{ RMT::Input::LogFile, logPath }
+		}), EException);
+
+		QVERIFY_EXCEPTION_THROWN(TestUtils::runAnalytic(AnalyticFactory::RMTType, arguments + QList<QPair<int, QVariant>> {
+			{ RMT::Input::LogFile, summaryLogPath },
+			{ RMT::Input::SummaryFile, summaryPath }
+		}), EException);
+
+		QCOMPARE(TestUtils::readFile(summaryLogPath), TestUtils::readFile(logPath));
+	}
+
+	// verify that the power-law analytic writes the same log file with and
+	// without the summary
+	QList<QPair<int, QVariant>> arguments
+	{
+		{ PowerLaw::Input::InputData, cmxPath },
+		{ PowerLaw::Input::ThresholdStart, 0.99 },
+		{ PowerLaw::Input::ThresholdStep, 0.01 },
+		{ PowerLaw::Input::ThresholdStop, 0.5 }
+	};
+
+	QVERIFY_EXCEPTION_THROWN(TestUtils::runAnalytic(AnalyticFactory::PowerLawType, arguments + QList<QPair<int, QVariant>> {
+		{ PowerLaw::Input::LogFile, logPath }
+	}), EException);
+
+	QVERIFY_EXCEPTION_THROWN(TestUtils::runAnalytic(AnalyticFactory::PowerLawType, arguments + QList<QPair<int, QVariant>> {
+		{ PowerLaw::Input::LogFile, summaryLogPath },
+		{ PowerLaw::Input::SummaryFile, summaryPath }
+	}), EException);
+
+	QCOMPARE(TestUtils::readFile(summaryLogPath), TestUtils::readFile(logPath));
+
+	// verify that the summary is refused for a different correlation matrix
+	runSimilarity(otherCcmPath, otherCmxPath, { { Similarity::Input::MinCorrelation, 0.2 } });
+
+	QVERIFY_EXCEPTION_THROWN(TestUtils::runAnalytic(AnalyticFactory::RMTType,
+	{
+		{ RMT::Input::InputData, otherCmxPath },
+		{ RMT::Input::LogFile, summaryLogPath },
+		{ RMT::Input::SummaryFile, summaryPath }
+	}), EException);
+
+	QVERIFY_EXCEPTION_THROWN(TestUtils::runAnalytic(AnalyticFactory::PowerLawType,
+	{
+		{ PowerLaw::Input::InputData, otherCmxPath },
+		{ PowerLaw::Input::LogFile, summaryLogPath },
+		{ PowerLaw::Input::SummaryFile, summaryPath }
+	}), EException);
+
+	QVERIFY(TestUtils::readFile(summaryLogPath).isEmpty());
 }
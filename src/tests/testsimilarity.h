@@ -18,8 +18,23 @@ private:
 		QVector<float> correlations;
 	};
 
+private:
+	void runSimilarity(const QString& ccmPath, const QString& cmxPath, const QList<QPair<int, QVariant>>& arguments);
+	static QVector<Pair> readPairs(const QString& ccmPath, const QString& cmxPath);
+	static bool isEqual(const QVector<Pair>& a, const QVector<Pair>& b);
+	/*!
+	 * The path of the expression matrix which is used by the comparison tests.
+	 */
+	QString _emxPath;
+
 private slots:
+	void initTestCase();
 	void test();
+	void testFactoring();
+	void testPreFilter();
+	void testTopK();
+	void testShards();
+	void testSummary();
 };
 
 
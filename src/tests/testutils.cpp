@@ -0,0 +1,173 @@
+#include <ace/core/core.h>
+#include <ace/core/ace_dataobject.h>
+
+#include "testutils.h"
+#include "../core/datafactory.h"
+#include "../core/expressionmatrix_gene.h"
+
+
+
+/*!
+ * Run an analytic with the given arguments in the calling thread through its
+ * public input, work, serial and process interface, in the same order as a
+ * single-process run. Data arguments are file paths: input data objects are
+ * opened and output data objects are created and finalized by this function.
+ * Any exception thrown by the analytic is passed on to the caller.
+ *
+ * @param type
+ * @param arguments
+ */
+void TestUtils::runAnalytic(quint16 type, const QList<QPair<int, QVariant>>& arguments)
+{
+	// create analytic and its input
+	std::unique_ptr<EAbstractAnalytic> analytic {EAbstractAnalyticFactory::instance().make(type)};
+	EAbstractAnalyticInput* input {analytic->makeInput()};
+
+	std::vector<std::unique_ptr<Ace::DataObject>> inputData;
+	std::vector<std::unique_ptr<Ace::DataObject>> outputData;
+	std::vector<std::unique_ptr<QFile>> files;
+
+	// set each argument according to its type
+	for ( auto& argument : arguments )
+	{
+		int index {argument.first};
+		QString path {argument.second.toString()};
+
+		switch (input->type(index))
+		{
+		case EAbstractAnalyticInput::Type::DataIn:
+			inputData.emplace_back(new Ace::DataObject(path));
+			input->set(index, inputData.back()->data());
+			break;
+		case EAbstractAnalyticInput::Type::DataOut:
+			QFile(path).remove();
+			outputData.emplace_back(new Ace::DataObject(path, input->data(index, EAbstractAnalyticInput::Role::DataType).toUInt(), EMetaObject()));
+			input->set(index, outputData.back()->data());
+			break;
+		case EAbstractAnalyticInput::Type::FileIn:
+			files.emplace_back(new QFile(path));
+			files.back()->open(QIODevice::ReadOnly);
+			input->set(index, files.back().get());
+			break;
+		case EAbstractAnalyticInput::Type::FileOut:
+			files.emplace_back(new QFile(path));
+			files.back()->open(QIODevice::WriteOnly | QIODevice::Truncate);
+			input->set(index, files.back().get());
+			break;
+		default:
+			input->set(index, argument.second);
+			break;
+		}
+	}
+
+	// initialize analytic
+	analytic->initialize();
+	analytic->initializeOutputs();
+
+	// process each work block, using the serial implementation if the analytic
+	// has one and passing an empty block with the work index otherwise
+	EAbstractAnalyticSerial* serial {analytic->makeSerial()};
+
+	for ( int i = 0; i < analytic->size(); ++i )
+	{
+		if ( serial )
+		{
+			std::unique_ptr<EAbstractAnalyticBlock> work {analytic->makeWork(i)};
+			std::unique_ptr<EAbstractAnalyticBlock> result {serial->execute(work.get())};
+
+			analytic->process(result.get());
+		}
+		else
+		{
+			EAbstractAnalyticBlock block(i);
+
+			analytic->process(&block);
+		}
+	}
+
+	// destroy the analytic so that it flushes any output streams before the
+	// output files are closed
+	analytic.reset();
+
+	// finalize output data objects and files
+	for ( auto& dataRef : outputData )
+	{
+		dataRef->data()->finish();
+		dataRef->finalize();
+	}
+
+	for ( auto& file : files )
+	{
+		file->close();
+	}
+}
+
+
+
+/*!
+ * Create an expression matrix with numbered genes and samples from the given
+ * expression data, which is stored gene by gene.
+ *
+ * @param path
+ * @param numGenes
+ * @param numSamples
+ * @param expressions
+ */
+void TestUtils::createExpressionMatrix(const QString& path, int numGenes, int numSamples, const QVector<float>& expressions)
+{
+	// create metadata
+	QStringList geneNames;
+	QStringList sampleNames;
+
+	for ( int i = 0; i < numGenes; ++i )
+	{
+		geneNames.append(QString::number(i));
+	}
+
+	for ( int i = 0; i < numSamples; ++i )
+	{
+		sampleNames.append(QString::number(i));
+	}
+
+	// create expression matrix
+	QFile(path).remove();
+
+	std::unique_ptr<Ace::DataObject> dataRef {new Ace::DataObject(path, DataFactory::ExpressionMatrixType, EMetaObject())};
+	ExpressionMatrix* emx {dataRef->data()->cast<ExpressionMatrix>()};
+
+	emx->initialize(geneNames, sampleNames);
+
+	ExpressionMatrix::Gene gene(emx);
+	for ( int i = 0; i < numGenes; ++i )
+	{
+		for ( int j = 0; j < numSamples; ++j )
+		{
+			gene[j] = expressions[i * numSamples + j];
+		}
+
+		gene.write(i);
+	}
+
+	dataRef->data()->finish();
+	dataRef->finalize();
+}
+
+
+
+/*!
+ * Return the contents of a file, or an empty byte array if the file cannot be
+ * read.
+ *
+ * @param path
+ */
+QByteArray TestUtils::readFile(const QString& path)
+{
+	QFile file(path);
+
+	if ( !file.open(QIODevice::ReadOnly) )
+	{
+		return QByteArray();
+	}
+
+	return file.readAll();
+}
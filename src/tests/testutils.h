@@ -0,0 +1,16 @@
+#ifndef TESTUTILS_H
+#define TESTUTILS_H
+#include <QtCore>
+
+
+
+namespace TestUtils
+{
+	void runAnalytic(quint16 type, const QList<QPair<int, QVariant>>& arguments);
+	void createExpressionMatrix(const QString& path, int numGenes, int numSamples, const QVector<float>& expressions);
+	QByteArray readFile(const QString& path);
+}
+
+
+
+#endif